@@ -25,6 +25,13 @@
 // replace "<MobileNumber>" and "<ApiKey>" with your whatsapp phone number and API key from callmebot
 #define CALLMEBOT_PATH "/whatsapp.php?phone=<MobileNumber>&apikey=<ApiKey>&text="
 
+// replace "<YourUploadHost>" with the HTTP server receiving the JPEG snapshot of a stranger (POST, image/jpeg)
+#define SNAPSHOT_HOST "<YourUploadHost>"
+#define SNAPSHOT_PORT 80
+#define SNAPSHOT_PATH "/doorbell/snapshot"
+// the message trace ("trace 3" on the console) goes to the same server (POST, application/octet-stream)
+#define TRACE_PATH "/doorbell/trace"
+
 // replace "<YourWifiSsid>" and "<WourWifiPassword>" with your WiFi SSID and password
 #define WIFI_SSID "<YourWifiSsid>"
 #define WIFI_PASSWORD "<YourWifiPassword>"
@@ -27,17 +27,19 @@ enum AppEvent : int16_t
 
     EventGpioISR = 10, // iParam=pin, uParam=value, lParam=millis()
     EventSystem,       // iParam=SystemTriggerSource
+    EventGpioRing,     // edges are pending in GpioEdgeRing
 
     ///////////////////////////////////////////////////////////////////////
     // Inter-process event
     ///////////////////////////////////////////////////////////////////////
     EventIpc = 300, // iParam=IpcParam
+    EventNpuFrame,  // iParam=IpcParam (frame decision), uParam/lParam=NpuFrame, one per inference
 
     ///////////////////////////////////////////////////////////////////////
     EventWifiStatus = 400, // iParam = WiFiEvent_t
     EventInternetStatus,   // iParam = InternetStatus
-    EventSendMessage,
-    EventMessageStatus, // iParam = MessageStatus
+    EventSendMessage,   // iParam = IpcParam (decision), uParam = session, lParam = origin, see AlertLatency
+    EventMessageStatus, // iParam = MessageStatus, uParam = session, lParam = origin
 
     /////////////////////////////////////////////////////////////////////////////
 };
@@ -45,15 +47,37 @@ enum AppEvent : int16_t
 enum SystemTriggerSource : int16_t
 {
     SysInitDone = 0,
-    SysSoftwareTimer, // lParam=xTimer:uint32_t
+    SysSoftwareTimer, // lParam=WheelTimer::id()
     SysVbusDetect,    // uParam=isVbusDetected:bool
     SysLowBattery,
     SysButtonClick,       // uParam=pin number
     SysButtonDoubleClick, // uParam=pin number
     SysButtonLongPress,   // uParam=pin number
     SysSerial,            // lParam=ptr to Serial
+    SysConsoleCommand,    // uParam=ConsoleCommand, lParam=ConsoleLine::pack()
 };
 
+typedef enum _ConsoleCommand : int16_t
+{
+    ConsoleNull = 0,
+    ConsoleHelp,
+    ConsoleBusLanes,     // print the lane stats of QueueMain
+    ConsoleQueueReport,  // print depth, high-water mark, post failures and wait of every queue
+    ConsoleTimerReport,  // print the timers of TimerService and the wake-ups they cost
+    ConsolePowerReport,  // print the time per power state, argument 0/1 disables/enables light sleep
+    ConsoleTaskReport,   // print stack and CPU usage per task and handler, argument 1 resets them
+    ConsoleTrace,        // print the message trace state, argument 0/1 stops/starts, 2 dumps on serial, 3 uploads
+    ConsoleAlertLatency, // print the alert latency per stage, argument 1 resets it
+    ConsoleNpuPerf,      // print NPU latency statistics
+    ConsoleNpuZone,      // print zones and drop counters, argument 1 resets the counters
+    ConsoleNpuThreshold, // print or set the per-class thresholds
+    ConsoleNpuRole,      // set the role of a class
+    ConsoleNpuSnapshot,  // print the last snapshot upload, argument 1 uploads a new one
+    ConsoleNpuCascade,   // print or set the model slots of the cascade
+    ConsoleNpuLog,       // print the detection log state, argument 1 flushes the batch
+    ConsoleNpuBench,     // NPU link throughput sweep, argument = clock index, none = all clocks
+} ConsoleCommand;
+
 typedef enum _InternetStatus : int16_t
 {
     Disconnect = 0,
@@ -72,11 +96,13 @@ typedef enum _MessageStatus : int16_t
 typedef enum _IpcParam : int16_t
 {
     IpcNull = 0,
-    IpcNpuStart,
+    IpcNpuStart, // uParam = session, lParam = origin (millis() of the PIR edge), see AlertLatency
     IpcNpuStop,
 
     IpcNpuNoObjectDetected,
     IpcNpuObjectUnclassified,
     IpcNpuStrangerDetected,
     IpcNpuTenderDetected,
+    IpcNpuIdle,     // NpuScheduler has backed off to stop
+    IpcNpuSnapshot, // upload a JPEG snapshot of the camera view
 } IpcParam;
@@ -0,0 +1,103 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Raw AT command on the SSCMA link, for commands the SSCMA library does not wrap
+//   request : AT+<command>\r\n
+//   response: \r{"type": 0, "name": "<NAME>", "code": <code>, "data": ...}\n
+// Lines longer than NPU_AT_LINE_SIZE are truncated, the header fields come first anyway.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_AT_LINE_SIZE 128
+#define NPU_AT_TIMEOUT 3000 // in unit of ms, e.g. AT+MODEL reloads the model from flash
+
+template <typename Link>
+class NpuAt
+{
+public:
+    // send AT+<command> and wait for the response of name (upper case command name)
+    // return the response code, 0 on success, or -1 on timeout
+    static int command(Link &link, const char *command, const char *name, uint32_t timeoutMs = NPU_AT_TIMEOUT)
+    {
+        char line[NPU_AT_LINE_SIZE];
+        int n = snprintf(line, sizeof(line), "AT+%s\r\n", command);
+        link.write(line, n);
+
+        char quoted[24];
+        snprintf(quoted, sizeof(quoted), "\"%s\"", name);
+
+        int length = 0;
+        uint32_t start = millis();
+        while (millis() - start < timeoutMs)
+        {
+            if (link.available() <= 0)
+            {
+                delay(1);
+                continue;
+            }
+
+            char c;
+            if (link.read(&c, 1) != 1)
+            {
+                continue;
+            }
+            if (c != '\n')
+            {
+                if (length < (int)sizeof(line) - 1)
+                {
+                    line[length++] = c;
+                }
+                continue;
+            }
+
+            line[length] = '\0';
+            length = 0;
+            const char *type = valueOf(line, "\"type\"");
+            const char *value = valueOf(line, "\"name\"");
+            const char *code = valueOf(line, "\"code\"");
+            if (type && value && code && atoi(type) == 0 && strncmp(value, quoted, strlen(quoted)) == 0)
+            {
+                return atoi(code);
+            }
+        }
+        return -1;
+    }
+
+private:
+    // return the value of a JSON key in line, nullptr if not found
+    static const char *valueOf(const char *line, const char *key)
+    {
+        const char *value = strstr(line, key);
+        if (!value)
+        {
+            return nullptr;
+        }
+        value += strlen(key);
+        while (*value == ':' || *value == ' ')
+        {
+            value++;
+        }
+        return value;
+    }
+};
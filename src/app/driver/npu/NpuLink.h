@@ -0,0 +1,207 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Transfer mode of the raw SSCMA link, used by NpuAt and NpuSnapshot
+//   Direct: every available()/read() goes to the link, as the callers ask for it
+//   Bulk  : a read refills a local buffer with up to chunk bytes in one transaction and
+//           remembers how many more bytes the device has announced, so neither the next
+//           available() nor the next refill query the device. Small reads (NpuAt reads
+//           byte by byte) are served from RAM instead of costing two transactions a byte.
+//           A read may return less than available(): the rest of the buffer only.
+// Link is SSCMA (available/read/write on the raw transport); NpuLink has the same
+// interface, so it can be given to NpuAt/NpuSnapshot in place of SSCMA.
+// Note the SSCMA library still splits a read into packets of its own maximum payload,
+// the saving is in the available() polls and in the read calls of the callers.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_LINK_CHUNK_MAX 1024 // bytes, size of the Bulk buffer
+
+typedef enum _NpuLinkMode : uint8_t
+{
+    NpuLinkDirect = 0,
+    NpuLinkBulk,
+} NpuLinkMode;
+
+template <typename Link>
+class NpuLink
+{
+public:
+    struct Stats
+    {
+        uint32_t transactions; // available(), read() and write() calls on the link
+        uint32_t bytes;        // read from the link
+        uint32_t busUs;        // time spent in the link calls
+    };
+
+    NpuLink(Link &link) : _link(link),
+                          _mode(NpuLinkBulk),
+                          _chunk(NPU_LINK_CHUNK_MAX),
+                          _head(0),
+                          _tail(0),
+                          _announced(0),
+                          _stats()
+    {
+    }
+
+    // chunk is clamped to [1, NPU_LINK_CHUNK_MAX], it only applies to Bulk
+    void setMode(NpuLinkMode mode, int chunk = NPU_LINK_CHUNK_MAX)
+    {
+        _mode = mode;
+        _chunk = chunk < 1 ? 1 : (chunk > NPU_LINK_CHUNK_MAX ? NPU_LINK_CHUNK_MAX : chunk);
+        discard();
+    }
+    NpuLinkMode mode(void) const
+    {
+        return _mode;
+    }
+    int chunk(void) const
+    {
+        return _chunk;
+    }
+
+    int available(void)
+    {
+        if (_mode == NpuLinkDirect)
+        {
+            return linkAvailable();
+        }
+        if (_head < _tail)
+        {
+            return _tail - _head;
+        }
+        if (_announced <= 0)
+        {
+            _announced = linkAvailable();
+        }
+        return _announced > 0 ? _announced : 0;
+    }
+
+    int read(char *data, int length)
+    {
+        if (_mode == NpuLinkDirect)
+        {
+            return linkRead(data, length);
+        }
+        if (_head == _tail)
+        {
+            refill();
+        }
+        int n = _tail - _head;
+        n = n < length ? n : length;
+        memcpy(data, &_buffer[_head], n);
+        _head += n;
+        return n;
+    }
+
+    // read and drop up to length bytes, with the transactions of read(); Direct reads into
+    // the Bulk buffer, which it does not use otherwise
+    int skip(int length)
+    {
+        if (_mode == NpuLinkDirect)
+        {
+            return linkRead(_buffer, length < NPU_LINK_CHUNK_MAX ? length : NPU_LINK_CHUNK_MAX);
+        }
+        if (_head == _tail)
+        {
+            refill();
+        }
+        int n = _tail - _head;
+        n = n < length ? n : length;
+        _head += n;
+        return n;
+    }
+
+    // a new request starts: what is left of the previous reply is stale
+    int write(const char *data, int length)
+    {
+        discard();
+        uint32_t start = micros();
+        int n = _link.write(data, length);
+        _stats.transactions++;
+        _stats.busUs += micros() - start;
+        return n;
+    }
+
+    void discard(void)
+    {
+        _head = _tail = 0;
+        _announced = 0;
+    }
+
+    const Stats &stats(void) const
+    {
+        return _stats;
+    }
+    void resetStats(void)
+    {
+        _stats = Stats();
+    }
+
+private:
+    Link &_link;
+    NpuLinkMode _mode;
+    int _chunk;
+    int _head; // next byte of _buffer to hand out
+    int _tail; // end of the valid bytes of _buffer
+    int _announced; // bytes the device reported available and not yet read
+    char _buffer[NPU_LINK_CHUNK_MAX];
+    Stats _stats;
+
+    void refill(void)
+    {
+        _head = _tail = 0;
+        if (_announced <= 0)
+        {
+            _announced = linkAvailable();
+            if (_announced <= 0)
+            {
+                _announced = 0;
+                return;
+            }
+        }
+        int n = linkRead(_buffer, _announced < _chunk ? _announced : _chunk);
+        _tail = n > 0 ? n : 0;
+        _announced = n > 0 ? _announced - n : 0;
+    }
+
+    int linkAvailable(void)
+    {
+        uint32_t start = micros();
+        int n = _link.available();
+        _stats.transactions++;
+        _stats.busUs += micros() - start;
+        return n;
+    }
+
+    int linkRead(char *data, int length)
+    {
+        uint32_t start = micros();
+        int n = _link.read(data, length);
+        _stats.transactions++;
+        _stats.busUs += micros() - start;
+        if (n > 0)
+        {
+            _stats.bytes += n;
+        }
+        return n;
+    }
+};
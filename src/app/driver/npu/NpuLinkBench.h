@@ -0,0 +1,106 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "./NpuLink.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Raw throughput of the NPU link at a given transfer mode and chunk size
+//   transfer() sends a command whose reply is large (by default one inference with the
+//   image, a few tens of KB of JSON) and reads the whole reply, reading chunk bytes at a
+//   time as a caller would. The time to the first byte holds the WE2 compute, the time
+//   from the first to the last byte is the link transfer.
+//   The reply is dropped as it is read (NpuLink::skip()), the bench needs no buffer of its
+//   own on the stack of the calling thread.
+// AT+INVOKE=<N_TIMES>,<DIFFERED>,<RESULT_ONLY>
+//   N_TIMES     : number of inferences to run
+//   DIFFERED    : 1 = reply only when the result differs from the previous one
+//   RESULT_ONLY : 1 = reply without the image
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_LINK_BENCH_COMMAND "AT+INVOKE=1,0,0\r\n" // one frame, always replied, with image
+#define NPU_LINK_BENCH_TIMEOUT 3000                  // in unit of ms, max wait of the first byte
+#define NPU_LINK_BENCH_DRAIN 20                      // in unit of ms, silence which ends the reply
+
+template <typename Link>
+class NpuLinkBench
+{
+public:
+    struct Result
+    {
+        uint32_t bytes;
+        uint32_t firstByteUs; // from the command to the first byte
+        uint32_t transferUs;  // from the first to the last byte
+        uint32_t transactions;
+
+        uint32_t bytesPerSecond(void) const
+        {
+            return transferUs ? (uint32_t)((uint64_t)bytes * 1000000 / transferUs) : 0;
+        }
+    };
+
+    static Result transfer(NpuLink<Link> &link, NpuLinkMode mode, int chunk, const char *command = NPU_LINK_BENCH_COMMAND)
+    {
+        Result result = {0, 0, 0, 0};
+
+        link.setMode(mode, chunk);
+        chunk = link.chunk();
+        uint32_t transactions = link.stats().transactions;
+        uint32_t start = micros();
+        uint32_t first = 0;
+        uint32_t last = 0;
+        link.write(command, strlen(command));
+
+        uint32_t lastDataMs = millis();
+        while (true)
+        {
+            int n = link.available();
+            if (n <= 0)
+            {
+                uint32_t silenceMs = millis() - lastDataMs;
+                if ((result.bytes && silenceMs >= NPU_LINK_BENCH_DRAIN) || silenceMs >= NPU_LINK_BENCH_TIMEOUT)
+                {
+                    break;
+                }
+                delay(1);
+                continue;
+            }
+
+            if (result.bytes == 0)
+            {
+                first = micros();
+            }
+            n = link.skip(n < chunk ? n : chunk);
+            if (n > 0)
+            {
+                result.bytes += n;
+                last = micros();
+                lastDataMs = millis();
+            }
+        }
+
+        if (result.bytes)
+        {
+            result.firstByteUs = first - start;
+            result.transferUs = last - first;
+        }
+        result.transactions = link.stats().transactions - transactions;
+        return result;
+    }
+};
@@ -0,0 +1,206 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "../../util/Base64Decoder.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Stream a camera frame from the SSCMA device as JPEG, without holding the image in RAM
+//   AT+INVOKE with the image enabled makes the WE2 reply a JSON event whose "image" field
+//   holds the base64 JPEG. The reply is read from the link NPU_SNAPSHOT_CHUNK bytes at a
+//   time, the "image" string is decoded on the fly and written to the sink chunk by chunk.
+//   Link is SSCMA (available/read/write on the raw I2C transport), Sink is anything with
+//   write(const uint8_t *, size_t), e.g. HttpChunkedWriter over a WiFiClient.
+//   stream() blocks the caller; maxMs caps the whole reply, the drain included.
+// AT+INVOKE=<N_TIMES>,<DIFFERED>,<RESULT_ONLY>: DIFFERED must be 0, a WE2 asked for the
+// differences only does not reply on an unchanged scene
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_SNAPSHOT_CHUNK 256    // bytes read from the NPU link at a time
+#define NPU_SNAPSHOT_TIMEOUT 3000 // in unit of ms, max silence of the link
+#define NPU_SNAPSHOT_DRAIN 20     // in unit of ms, silence which ends the reply after the image
+
+#define NPU_SNAPSHOT_COMMAND "AT+INVOKE=1,0,0\r\n" // one frame, always replied, with image
+
+template <typename Link>
+class NpuSnapshot
+{
+public:
+    struct Report
+    {
+        bool isOk;
+        uint32_t bytes; // JPEG bytes written to the sink
+        uint32_t ms;    // from the command to the last byte
+
+        uint32_t bytesPerSecond(void) const
+        {
+            return ms ? (uint32_t)((uint64_t)bytes * 1000 / ms) : 0;
+        }
+    };
+
+    NpuSnapshot() : _decoder(), _state(SeekKey), _keyIndex(0)
+    {
+    }
+
+    template <typename Sink>
+    Report stream(Link &link, Sink &sink, uint32_t maxMs = UINT32_MAX)
+    {
+        Report report = {false, 0, 0};
+        uint32_t start = millis();
+        uint32_t lastData = start;
+
+        _decoder.reset();
+        _state = SeekKey;
+        _keyIndex = 0;
+        link.write(NPU_SNAPSHOT_COMMAND, sizeof(NPU_SNAPSHOT_COMMAND) - 1);
+
+        while (_state != Done && _state != Failed)
+        {
+            int n = link.available();
+            if (n <= 0)
+            {
+                if (millis() - lastData >= NPU_SNAPSHOT_TIMEOUT || millis() - start >= maxMs)
+                {
+                    break;
+                }
+                delay(1);
+                continue;
+            }
+
+            n = link.read(_rx, n < NPU_SNAPSHOT_CHUNK ? n : NPU_SNAPSHOT_CHUNK);
+            lastData = millis();
+            for (int i = 0; i < n && _state != Done && _state != Failed;)
+            {
+                i = parse(i, n, sink, &report.bytes);
+            }
+            if (millis() - start >= maxMs)
+            {
+                break;
+            }
+        }
+        report.isOk = (_state == Done) && report.bytes > 0;
+        report.ms = millis() - start;
+
+        drain(link, start, maxMs);
+        return report;
+    }
+
+private:
+    typedef enum _State : uint8_t
+    {
+        SeekKey = 0, // looking for "image"
+        SeekValue,   // looking for the opening quote of the value
+        Image,       // decoding up to the closing quote
+        Done,
+        Failed, // the sink does not accept data any more
+    } State;
+
+    Base64Decoder _decoder;
+    State _state;
+    uint8_t _keyIndex;
+    char _rx[NPU_SNAPSHOT_CHUNK];
+    uint8_t _tx[(NPU_SNAPSHOT_CHUNK * 3) / 4 + 1];
+
+    // consume _rx[i..n), return the index of the first character not consumed
+    template <typename Sink>
+    int parse(int i, int n, Sink &sink, uint32_t *bytes)
+    {
+        static const char key[] = "\"image\"";
+
+        switch (_state)
+        {
+        case SeekKey:
+            for (; i < n; i++)
+            {
+                if (_rx[i] == key[_keyIndex])
+                {
+                    if (++_keyIndex == sizeof(key) - 1)
+                    {
+                        _state = SeekValue;
+                        return i + 1;
+                    }
+                }
+                else
+                {
+                    _keyIndex = (_rx[i] == key[0]) ? 1 : 0;
+                }
+            }
+            return n;
+
+        case SeekValue:
+            if (_rx[i] == '"')
+            {
+                _state = Image;
+            }
+            else if (_rx[i] != ':' && _rx[i] != ' ')
+            {
+                _state = SeekKey; // "image" was not a key
+                _keyIndex = 0;
+            }
+            return i + 1;
+
+        case Image:
+        {
+            int end = i;
+            while (end < n && _rx[end] != '"')
+            {
+                end++;
+            }
+            int length = _decoder.decode(&_rx[i], end - i, _tx);
+            if (length > 0)
+            {
+                if (sink.write(_tx, length) != (size_t)length)
+                {
+                    _state = Failed;
+                    return n;
+                }
+                *bytes += length;
+            }
+            if (end < n)
+            {
+                _state = Done;
+                return end + 1;
+            }
+            return n;
+        }
+
+        default:
+            return n;
+        }
+    }
+
+    // discard the rest of the reply, so the next SSCMA::invoke() starts on a clean link
+    void drain(Link &link, uint32_t start, uint32_t maxMs)
+    {
+        uint32_t lastData = millis();
+        while (millis() - lastData < NPU_SNAPSHOT_DRAIN && millis() - start < maxMs)
+        {
+            int n = link.available();
+            if (n > 0)
+            {
+                link.read(_rx, n < NPU_SNAPSHOT_CHUNK ? n : NPU_SNAPSHOT_CHUNK);
+                lastData = millis();
+            }
+            else
+            {
+                delay(1);
+            }
+        }
+    }
+};
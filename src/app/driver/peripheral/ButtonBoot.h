@@ -34,7 +34,7 @@
 class ButtonBoot : public DebounceButton
 {
 public:
-    ButtonBoot(QueueHandle_t queue) : DebounceButton(GPIO_BUTTON, BUTTON_STATE_ACTIVE, INPUT, queue)
+    ButtonBoot(QueueHandle_t queue, GpioEdgeRing *edgeRing = nullptr) : DebounceButton(GPIO_BUTTON, BUTTON_STATE_ACTIVE, INPUT, queue, edgeRing)
     {
         enableInterrupt(CHANGE);
         // enableInterrupt(FALLING);
@@ -21,6 +21,8 @@
 #include <FunctionalInterrupt.h>
 #include "../../../ArduProfFreeRTOS.h"
 #include "../../../AppEvent.h"
+#include "../../power/PowerManager.h"
+#include "../gpio/GpioEdgeRing.h"
 #include "./DebounceDef.h"
 #include "./DebounceTimer.h"
 
@@ -32,15 +34,17 @@ public:
     DebounceButton(uint8_t pin,
                    uint8_t activeState,
                    uint8_t ioMode,
-                   QueueHandle_t queue) : _PIN(pin),
+                   QueueHandle_t queue,
+                   GpioEdgeRing *edgeRing = nullptr) : MessageQueue(queue),
                                           pinStateActive(activeState),
                                           isIntrEnable(false),
-                                          _debounceTimer(nullptr),
                                           _eventValue(EventNull),
                                           _buttonClick(EventNull),
                                           _buttonDoubleClick(EventNull),
                                           _buttonLongPress(EventNull),
-                                          MessageQueue(queue)
+                                          _edgeRing(edgeRing),
+                                          _debounceTimer(nullptr),
+                                          _PIN(pin)
     {
         debounceCount = 0;
         debounceActive = false;
@@ -140,7 +144,6 @@ public:
         }
         else if (debounceCount >= DoubleClickDuration)
         {
-            int16_t event;
             if (_clickCount == 1)
             {
                 sendMessageToTask(_eventValue, _buttonClick, _PIN);
@@ -182,13 +185,23 @@ protected:
 private:
     void isr(void)
     {
-        sendMessageFromIsrToTask(EventGpioISR, _PIN, digitalRead(_PIN), millis());
+        uint8_t value = digitalRead(_PIN);
+        PowerManager::onPinIsr(_PIN, value);
+        if (_edgeRing)
+        {
+            _edgeRing->push(_PIN, value, millis());
+        }
+        else
+        {
+            sendMessageFromIsrToTask(EventGpioISR, _PIN, value, millis());
+        }
     }
 
     int16_t _eventValue;
     int16_t _buttonClick;
     int16_t _buttonDoubleClick;
     int16_t _buttonLongPress;
+    GpioEdgeRing *_edgeRing; // nullptr: an EventGpioISR per edge
 
     friend DebounceTimer;
     DebounceTimer *_debounceTimer;
@@ -21,8 +21,6 @@
 #include "DebounceTimer.h"
 #include "DebounceButton.h"
 
-DebounceTimer *DebounceTimer::_instance = nullptr;
-
 bool DebounceTimer::attachButton(DebounceButton *button)
 {
     for (int i = 0; i < ButtonListSize; i++)
@@ -19,36 +19,19 @@
  */
 #pragma once
 #include "../../../ArduProfFreeRTOS.h"
+#include "../../../util/TimerService.h"
 #include "./DebounceDef.h"
 
 #define ButtonListSize 10
 
 class DebounceButton;
 
-class DebounceTimer : public ardufreertos::SoftwareTimer,
-                      ardufreertos::MessageQueue
+// a WheelTimer of TimerService, posting EventSystem/SysSoftwareTimer to the owner queue
+class DebounceTimer : public WheelTimer
 {
 public:
-    DebounceTimer(QueueHandle_t queue,
-                  int _eventValue,
-                  int _paramValue) : MessageQueue(queue),
-                                     SoftwareTimer(
-                                         "Debounce Timer",
-                                         DebounceTimerInterval,
-                                         pdTRUE, // The timers will auto-reload themselves when they expire.
-                                         nullptr,
-                                         [](TimerHandle_t xTimer)
-                                         // [_instance](TimerHandle_t xTimer)
-                                         {
-                                             if (_instance != nullptr)
-                                             {
-                                                 _instance->isr(xTimer);
-                                             }
-                                         }),
-                                     _eventValue(_eventValue),
-                                     _paramValue(_paramValue)
+    DebounceTimer(ardufreertos::MessageQueue *owner) : WheelTimer("Debounce Timer", owner, DebounceTimerInterval * portTICK_PERIOD_MS)
     {
-        _instance = this;
         memset(_buttonList, 0, sizeof(_buttonList));
     }
 
@@ -57,16 +40,6 @@ public:
 
     virtual void onEventTimer(void);
 
-protected:
-    virtual void isr(TimerHandle_t xTimer)
-    {
-        sendMessageFromIsrToTask(_eventValue, _paramValue, 0, (uint32_t)xTimer);
-    }
-
 private:
-    static DebounceTimer *_instance;
     DebounceButton *_buttonList[ButtonListSize];
-
-    int _eventValue;
-    int _paramValue;
 };
@@ -0,0 +1,116 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <atomic>
+#include "../../../ArduProfFreeRTOS.h"
+#include "../../../AppEvent.h"
+#include "../../../util/SpscRing.h"
+
+/////////////////////////////////////////////////////////////
+// GPIO edges from the ISRs to a task, without a queue copy per edge
+//   push() (ISR) writes a compact edge record to an SpscRing. The first edge since the
+//   last drain also posts one EventGpioRing to the queue, so a bouncing button costs one
+//   queue message per wake-up, not one per edge. The task calls beginDrain() on
+//   EventGpioRing, then pop() until the ring is empty.
+//   The GPIO ISRs run from one interrupt and do not preempt one another: one producer.
+/////////////////////////////////////////////////////////////
+#define GPIO_EDGE_RING_SIZE 32
+
+struct GpioEdge
+{
+    uint32_t ms;
+    uint8_t pin;
+    uint8_t level;
+};
+
+class GpioEdgeRing : public ardufreertos::MessageQueue
+{
+public:
+    GpioEdgeRing(QueueHandle_t queue) : MessageQueue(queue),
+                                        _isSignalled(false),
+                                        _drains(0),
+                                        _maxBatch(0)
+    {
+    }
+
+    // ISR
+    void push(uint8_t pin, uint8_t level, uint32_t ms)
+    {
+        GpioEdge edge;
+        edge.ms = ms;
+        edge.pin = pin;
+        edge.level = level;
+        _ring.push(edge);
+
+        // pairs with the fence of beginDrain(): either the task sees this edge when it
+        // drains, or this ISR sees the flag cleared and posts a new EventGpioRing
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!_isSignalled.load(std::memory_order_relaxed))
+        {
+            _isSignalled.store(true, std::memory_order_relaxed);
+            if (!sendMessageFromIsrToTask(EventGpioRing))
+            {
+                _isSignalled.store(false, std::memory_order_relaxed); // queue full, the next edge retries
+            }
+        }
+    }
+
+    // task, on EventGpioRing
+    void beginDrain(void)
+    {
+        _isSignalled.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _drains++;
+    }
+    bool pop(GpioEdge *edge)
+    {
+        return _ring.pop(edge);
+    }
+    void endDrain(uint16_t batch)
+    {
+        if (batch > _maxBatch)
+        {
+            _maxBatch = batch;
+        }
+    }
+
+    uint32_t edges(void) const
+    {
+        return _ring.pushed();
+    }
+    uint32_t overflows(void) const
+    {
+        return _ring.overflows();
+    }
+    uint32_t drains(void) const
+    {
+        return _drains;
+    }
+    uint16_t maxBatch(void) const
+    {
+        return _maxBatch;
+    }
+
+private:
+    SpscRing<GpioEdge, GPIO_EDGE_RING_SIZE> _ring;
+    std::atomic<bool> _isSignalled; // an EventGpioRing is posted and not drained yet
+    uint32_t _drains;
+    uint16_t _maxBatch;
+};
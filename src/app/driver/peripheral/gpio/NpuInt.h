@@ -0,0 +1,69 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <FunctionalInterrupt.h>
+#include "../../../ArduProfFreeRTOS.h"
+#include "../../../pins.h"
+#include "../../../AppEvent.h"
+
+#ifdef GPIO_PIN
+#undef GPIO_PIN
+#endif
+
+/////////////////////////////////////////////////////////////
+// npuINT is raised by the Grove Vision AI V2 (WE2) when it has finished a frame
+/////////////////////////////////////////////////////////////
+#define GPIO_PIN PIN_NPU_INT
+#define NPU_INT_ACTIVE_STATE HIGH
+#define NPU_INT_EDGE RISING
+
+class NpuInt : public Gpio
+{
+public:
+    NpuInt() : Gpio(GPIO_PIN, INPUT)
+    {
+    }
+
+    void enableInterrupt(ardufreertos::MessageQueue *msgQueue)
+    {
+        attachIntr(
+            NPU_INT_EDGE, [](void *ptr)
+            {
+                int value = digitalRead(GPIO_PIN);
+                if (value == NPU_INT_ACTIVE_STATE)
+                { // workaround of ensuring edge interrupt, same as PirInt
+                    auto msgQueue = static_cast<ardufreertos::MessageQueue *>(ptr);
+                    msgQueue->postEvent(EventGpioISR, GPIO_PIN, value, millis());
+                } },
+            msgQueue);
+    }
+
+    void disableInterrupt(void)
+    {
+        detachIntr();
+    }
+
+    bool isActive(void)
+    {
+        return (read() == NPU_INT_ACTIVE_STATE);
+    }
+};
+
+#undef GPIO_PIN
@@ -22,6 +22,8 @@
 #include "../../../ArduProfFreeRTOS.h"
 #include "../../../pins.h"
 #include "../../../AppEvent.h"
+#include "../../power/PowerManager.h"
+#include "./GpioEdgeRing.h"
 
 #ifdef GPIO_PIN
 #undef GPIO_PIN
@@ -37,7 +39,7 @@ public:
     {
     }
 
-    void enableInterrupt(ardufreertos::MessageQueue *msgQueue)
+    void enableInterrupt(GpioEdgeRing *edgeRing)
     {
         // static int _value = digitalRead(GPIO_PIN);
 
@@ -45,10 +47,11 @@ public:
             RISING, [](void *ptr)
             {
                 int value = digitalRead(GPIO_PIN);
+                PowerManager::onPinIsr(GPIO_PIN, value);
                 if (value == HIGH)
                 { // workaround of ensuring Rising interrupt
-                    auto msgQueue = static_cast<ardufreertos::MessageQueue *>(ptr);
-                    msgQueue->postEvent(EventGpioISR, GPIO_PIN, value, millis());
+                    auto edgeRing = static_cast<GpioEdgeRing *>(ptr);
+                    edgeRing->push(GPIO_PIN, value, millis());
                 }
 
                 // int newValue = digitalRead(GPIO_PIN);
@@ -61,7 +64,7 @@ public:
                 // }
                 //
             },
-            msgQueue);
+            edgeRing);
         // attachIntr(RISING, std::bind(&PirInt::isr, this));
     }
 
@@ -0,0 +1,235 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <esp_timer.h>
+#include "./PowerManager.h"
+#include "../../AppLog.h"
+
+static const char *stateNames[PowerStateCount] = {"active", "idle", "lock released"};
+
+PowerManager *PowerManager::_instance = nullptr;
+
+PowerManager::PowerManager() : _isEnabled(POWER_LIGHT_SLEEP),
+                               _idleCount(0),
+                               _state(PowerActive),
+                               _stateSinceUs(esp_timer_get_time()),
+                               _stateUs(),
+                               _lock(nullptr),
+                               _pmError(ESP_OK),
+                               _isLockReleased(false),
+                               _releases(0),
+                               _wakeGpios(),
+                               _wakeGpioCount(0)
+{
+    portMUX_INITIALIZE(&_mux);
+    _instance = this;
+}
+
+void PowerManager::begin(void)
+{
+    esp_err_t err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "app", &_lock);
+    if (err != ESP_OK)
+    {
+        LOG_ERROR("esp_pm_lock_create() returns ", err, ", the core needs CONFIG_PM_ENABLE: no light sleep");
+        _lock = nullptr;
+        _pmError = err;
+        return;
+    }
+    esp_pm_lock_acquire(_lock);
+
+    // no frequency scaling: the CPU runs at the same clock as before, asleep or not
+    esp_pm_config_esp32c3_t config;
+    config.max_freq_mhz = getCpuFrequencyMhz();
+    config.min_freq_mhz = config.max_freq_mhz;
+    config.light_sleep_enable = true;
+    err = esp_pm_configure(&config);
+    if (err != ESP_OK)
+    {
+        LOG_ERROR("esp_pm_configure() returns ", err, ", the core needs CONFIG_FREERTOS_USE_TICKLESS_IDLE: no light sleep");
+        esp_pm_lock_release(_lock);
+        esp_pm_lock_delete(_lock);
+        _lock = nullptr;
+        _pmError = err;
+        return;
+    }
+    esp_sleep_enable_gpio_wakeup();
+}
+
+bool PowerManager::addWakeGpio(uint8_t pin, uint8_t activeLevel, gpio_int_type_t intrType)
+{
+    if (_wakeGpioCount >= POWER_WAKE_GPIO_MAX)
+    {
+        LOG_ERROR("POWER_WAKE_GPIO_MAX reached, GPIO", pin, " does not wake the chip");
+        return false;
+    }
+    WakeGpio &gpio = _wakeGpios[_wakeGpioCount++];
+    gpio.pin = pin;
+    gpio.activeLevel = activeLevel;
+    gpio.intrType = intrType;
+    gpio.wakes = 0;
+    return true;
+}
+
+void PowerManager::setEnabled(bool isEnabled)
+{
+    _isEnabled = isEnabled;
+    if (!isEnabled)
+    {
+        keepAwake();
+    }
+}
+
+void PowerManager::onIdleTick(bool isIdle)
+{
+    if (!isIdle)
+    {
+        keepAwake();
+        return;
+    }
+
+    if (_idleCount < POWER_IDLE_COUNT)
+    {
+        _idleCount++;
+        setState(PowerIdle);
+    }
+    else if (_isEnabled && _lock)
+    {
+        releaseLock();
+        setState(PowerLockReleased);
+    }
+}
+
+void PowerManager::keepAwake(void)
+{
+    _idleCount = 0;
+    acquireLock();
+    setState(PowerActive);
+}
+
+void PowerManager::onPinIsr(uint8_t pin, uint8_t level)
+{
+    PowerManager *power = _instance;
+    if (!power)
+    {
+        return;
+    }
+    portENTER_CRITICAL_ISR(&power->_mux);
+    if (power->_isLockReleased)
+    {
+        for (int i = 0; i < power->_wakeGpioCount; i++)
+        {
+            WakeGpio &gpio = power->_wakeGpios[i];
+            if (gpio.pin == pin)
+            {
+                gpio_wakeup_enable((gpio_num_t)pin, otherLevel(level));
+                if (level == gpio.activeLevel)
+                {
+                    gpio.wakes++;
+                }
+            }
+        }
+    }
+    portEXIT_CRITICAL_ISR(&power->_mux);
+}
+
+void PowerManager::report(void)
+{
+    setState(_state); // bring the current state up to date
+
+    int64_t totalUs = 0;
+    for (int i = 0; i < PowerStateCount; i++)
+    {
+        totalUs += _stateUs[i];
+    }
+    if (!_lock)
+    {
+        PRINTLN("light sleep unavailable: error ", _pmError, ", the core needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE");
+    }
+    PRINTLN("light sleep ", !_lock ? "unavailable" : _isEnabled ? "enabled" : "disabled", ", state=", stateNames[_state],
+            ", idle ticks=", _idleCount, "/", POWER_IDLE_COUNT);
+    for (int i = 0; i < PowerStateCount; i++)
+    {
+        PRINTLN(stateNames[i], ": ", (uint32_t)(_stateUs[i] / 1000), " ms (", totalUs ? (uint32_t)(_stateUs[i] * 100 / totalUs) : 0, "%)");
+    }
+    PRINTLN("lock releases=", _releases, ", avg=", _releases ? (uint32_t)(_stateUs[PowerLockReleased] / 1000 / _releases) : 0,
+            " ms (time the chip may sleep, not time asleep)");
+    for (int i = 0; i < _wakeGpioCount; i++)
+    {
+        PRINTLN("wake-ups: GPIO", _wakeGpios[i].pin, "=", _wakeGpios[i].wakes);
+    }
+#if CONFIG_PM_PROFILING
+    // time per PM mode, LIGHT_SLEEP included, on the ESP-IDF console (stdout)
+    esp_pm_dump_locks(stdout);
+#endif
+}
+
+void PowerManager::setState(PowerState state)
+{
+    int64_t nowUs = esp_timer_get_time();
+    _stateUs[_state] += nowUs - _stateSinceUs;
+    _stateSinceUs = nowUs;
+    _state = state;
+}
+
+void PowerManager::releaseLock(void)
+{
+    if (_isLockReleased)
+    {
+        return;
+    }
+    // WiFi is up by now (QueueMain is idle when connected only): its power save mode takes
+    esp_err_t err = esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+    if (err != ESP_OK)
+    {
+        LOG_ERROR("esp_wifi_set_ps() returns ", err);
+    }
+
+    // a pin edge between the read and the level set fires at once, onPinIsr() flips it
+    portENTER_CRITICAL(&_mux);
+    for (int i = 0; i < _wakeGpioCount; i++)
+    {
+        uint8_t pin = _wakeGpios[i].pin;
+        gpio_wakeup_enable((gpio_num_t)pin, otherLevel(digitalRead(pin)));
+    }
+    _isLockReleased = true;
+    portEXIT_CRITICAL(&_mux);
+
+    esp_pm_lock_release(_lock);
+    _releases++;
+}
+
+void PowerManager::acquireLock(void)
+{
+    if (!_isLockReleased)
+    {
+        return;
+    }
+    esp_pm_lock_acquire(_lock);
+
+    portENTER_CRITICAL(&_mux);
+    _isLockReleased = false;
+    for (int i = 0; i < _wakeGpioCount; i++)
+    {
+        gpio_num_t pin = (gpio_num_t)_wakeGpios[i].pin;
+        gpio_wakeup_disable(pin);
+        gpio_set_intr_type(pin, _wakeGpios[i].intrType);
+    }
+    portEXIT_CRITICAL(&_mux);
+}
@@ -0,0 +1,128 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include <driver/gpio.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_wifi.h>
+#include "../../ArduProfFreeRTOS.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Automatic light sleep of the chip while the app is idle
+//   begin() turns on the automatic light sleep of ESP-IDF (esp_pm_configure() with
+//   light_sleep_enable, which takes CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE):
+//   the idle task puts the chip to sleep whenever every task is blocked, until the next RTOS
+//   timeout or a wake pin, and steps the tick count by the time asleep. WiFi runs in minimum
+//   modem sleep (WIFI_PS_MIN_MODEM): its driver wakes the chip for the DTIM beacons of the AP,
+//   so the station stays associated.
+//   A PM lock (ESP_PM_NO_LIGHT_SLEEP) keeps the chip awake while the app is active. QueueMain
+//   calls onIdleTick() on its 1Hz timer with its idle condition; once the app has been idle
+//   for POWER_IDLE_COUNT ticks in a row, the lock is released. It is taken again on the first
+//   tick which is not idle, or at once by keepAwake() on a PIR or BOOT edge.
+//   GPIO wake-up takes level interrupts. While the lock is released, each wake pin (PIR, BOOT)
+//   triggers on the level it is not at, and onPinIsr() flips it at each edge, so the ISRs see
+//   every edge, asleep or awake, and a level does not fire over and over. The edge interrupts
+//   are restored when the lock is taken.
+//   The USB serial port drops while the chip sleeps.
+//   The stock arduino-esp32 core is built without tickless idle: esp_pm_configure() fails
+//   there, begin() logs it and the chip never sleeps. See the README for a core with it.
+// The time in each PowerState is measured on esp_timer. "lock released" is the time the
+// chip may sleep, not the time it is asleep: that one comes from the PM profiling of ESP-IDF
+// (CONFIG_PM_PROFILING), which report() dumps when the core has it.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define POWER_LIGHT_SLEEP 1 // 0: the lock is never released, the time per state is still measured
+#define POWER_IDLE_COUNT 5  // idle ticks (seconds) before the lock is released
+#define POWER_WAKE_GPIO_MAX 2
+
+typedef enum _PowerState : uint8_t
+{
+    PowerActive = 0,   // a job in flight: NPU, message, button, console input
+    PowerIdle,         // awake, nothing to do
+    PowerLockReleased, // the chip sleeps whenever every task is blocked
+    PowerStateCount
+} PowerState;
+
+class PowerManager
+{
+public:
+    PowerManager();
+
+    // configure the automatic light sleep, with the lock taken
+    void begin(void);
+
+    // a pin whose active level wakes the chip; intrType is its edge interrupt, restored on wake
+    bool addWakeGpio(uint8_t pin, uint8_t activeLevel, gpio_int_type_t intrType);
+
+    void setEnabled(bool isEnabled);
+    bool isEnabled(void) const
+    {
+        return _isEnabled;
+    }
+    PowerState state(void) const
+    {
+        return _state;
+    }
+
+    // on every 1Hz tick; releases the lock once the app has been idle long enough
+    void onIdleTick(bool isIdle);
+
+    // take the lock now, ahead of the next tick
+    void keepAwake(void);
+
+    // ISR of a wake pin, with the level it read
+    static void onPinIsr(uint8_t pin, uint8_t level);
+
+    void report(void);
+
+private:
+    static PowerManager *_instance;
+
+    struct WakeGpio
+    {
+        uint8_t pin;
+        uint8_t activeLevel;
+        gpio_int_type_t intrType;
+        uint32_t wakes; // edges to the active level while the lock was released
+    };
+
+    bool _isEnabled;
+    uint8_t _idleCount;
+    PowerState _state;
+    int64_t _stateSinceUs;
+    int64_t _stateUs[PowerStateCount];
+
+    esp_pm_lock_handle_t _lock; // nullptr: no automatic light sleep in this build
+    esp_err_t _pmError;         // why not, from begin()
+    portMUX_TYPE _mux;          // the wake pins, between onPinIsr() and the lock changes
+    bool _isLockReleased;
+    uint32_t _releases;
+
+    WakeGpio _wakeGpios[POWER_WAKE_GPIO_MAX];
+    uint8_t _wakeGpioCount;
+
+    void setState(PowerState state);
+    void releaseLock(void);
+    void acquireLock(void);
+    static gpio_int_type_t otherLevel(uint8_t level)
+    {
+        return level == HIGH ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL;
+    }
+};
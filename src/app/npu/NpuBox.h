@@ -0,0 +1,87 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+#define NPU_BOX_MAX 16 // max number of boxes handled per frame, extra boxes are ignored
+
+// Detection box in NPU pixel space, (x, y) is the box center as reported by SSCMA
+struct NpuBox
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint8_t score;
+    uint8_t target;
+
+    int32_t left(void) const
+    {
+        return (int32_t)x - w / 2;
+    }
+    int32_t top(void) const
+    {
+        return (int32_t)y - h / 2;
+    }
+    int32_t right(void) const
+    {
+        return left() + w;
+    }
+    int32_t bottom(void) const
+    {
+        return top() + h;
+    }
+    uint32_t area(void) const
+    {
+        return (uint32_t)w * h;
+    }
+
+    // intersection over union in percent, integer only
+    uint8_t iou(const NpuBox &other) const
+    {
+        int32_t ix = min32(right(), other.right()) - max32(left(), other.left());
+        int32_t iy = min32(bottom(), other.bottom()) - max32(top(), other.top());
+        if (ix <= 0 || iy <= 0)
+        {
+            return 0;
+        }
+        uint32_t inter = (uint32_t)ix * (uint32_t)iy;
+        uint32_t uni = area() + other.area() - inter;
+        return uni ? (uint8_t)(inter * 100 / uni) : 0;
+    }
+
+    // squared distance between box centers
+    uint32_t distance2(const NpuBox &other) const
+    {
+        int32_t dx = (int32_t)x - other.x;
+        int32_t dy = (int32_t)y - other.y;
+        return (uint32_t)(dx * dx + dy * dy);
+    }
+
+private:
+    static int32_t min32(int32_t a, int32_t b)
+    {
+        return a < b ? a : b;
+    }
+    static int32_t max32(int32_t a, int32_t b)
+    {
+        return a > b ? a : b;
+    }
+};
@@ -0,0 +1,164 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include "./NpuBox.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Two-stage model cascade
+//   Presence : a small person detector runs while nobody is in frame
+//   Identity : the tenant/stranger model runs once the presence model has found a person,
+//              and falls back to Presence after NPU_CASCADE_HOLD frames without a box
+// The WE2 cannot crop its input to a region, so the identity model sees the whole frame;
+// its boxes are restricted instead to the region found by the presence model (grown by
+// NPU_CASCADE_MARGIN), and the region then follows the identity boxes.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_CASCADE_HOLD 4            // identity frames without box before going back to presence
+#define NPU_CASCADE_MARGIN 16         // in pixel, added around the region of the presence boxes
+#define NPU_CASCADE_PRESENCE_SCORE 40 // min score of a presence box
+
+class NpuCascade
+{
+public:
+    typedef enum _Stage : uint8_t
+    {
+        Presence = 0,
+        Identity,
+
+        StageCount,
+    } Stage;
+
+    NpuCascade() : _stage(Presence), _emptyFrames(0), _regionCount(0), _promotionCount(0)
+    {
+        for (int i = 0; i < StageCount; i++)
+        {
+            _frameCount[i] = 0;
+        }
+    }
+
+    void reset(void)
+    {
+        _stage = Presence;
+        _emptyFrames = 0;
+        _regionCount = 0;
+    }
+
+    Stage stage(void) const
+    {
+        return _stage;
+    }
+
+    // result of the presence model, compacted to the boxes above NPU_CASCADE_PRESENCE_SCORE
+    // return the number of persons found
+    int onPresence(NpuBox *boxes, int count)
+    {
+        _frameCount[Presence]++;
+
+        int kept = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (boxes[i].score >= NPU_CASCADE_PRESENCE_SCORE)
+            {
+                boxes[kept++] = boxes[i];
+            }
+        }
+        if (kept > 0)
+        {
+            setRegion(boxes, kept);
+            _stage = Identity;
+            _emptyFrames = 0;
+            _promotionCount++;
+        }
+        return kept;
+    }
+
+    // result of the identity model, compacted to the boxes inside the region
+    // return the number of boxes kept
+    int onIdentity(NpuBox *boxes, int count)
+    {
+        _frameCount[Identity]++;
+
+        int kept = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (isInRegion(boxes[i]))
+            {
+                boxes[kept++] = boxes[i];
+            }
+        }
+        if (kept > 0)
+        {
+            setRegion(boxes, kept);
+            _emptyFrames = 0;
+        }
+        else if (++_emptyFrames >= NPU_CASCADE_HOLD)
+        {
+            reset();
+        }
+        return kept;
+    }
+
+    uint32_t frameCount(Stage stage) const
+    {
+        return _frameCount[stage];
+    }
+
+    // number of presence frames which started the identity model
+    uint32_t promotionCount(void) const
+    {
+        return _promotionCount;
+    }
+
+    static const char *getStageString(Stage stage)
+    {
+        return stage == Identity ? "identity" : "presence";
+    }
+
+private:
+    Stage _stage;
+    uint8_t _emptyFrames;
+    uint8_t _regionCount;
+    NpuBox _region[NPU_BOX_MAX];
+    uint32_t _frameCount[StageCount];
+    uint32_t _promotionCount;
+
+    void setRegion(const NpuBox *boxes, int count)
+    {
+        _regionCount = count < NPU_BOX_MAX ? count : NPU_BOX_MAX;
+        for (int i = 0; i < _regionCount; i++)
+        {
+            _region[i] = boxes[i];
+        }
+    }
+
+    bool isInRegion(const NpuBox &box) const
+    {
+        for (int i = 0; i < _regionCount; i++)
+        {
+            const NpuBox &region = _region[i];
+            if (box.x >= region.left() - NPU_CASCADE_MARGIN && box.x <= region.right() + NPU_CASCADE_MARGIN &&
+                box.y >= region.top() - NPU_CASCADE_MARGIN && box.y <= region.bottom() + NPU_CASCADE_MARGIN)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,71 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Per-frame detection summary, posted once per inference as EventNpuFrame
+//   iParam = decision (IpcParam)
+//   uParam = [15:8] max stranger score, [7:0] max tenant score
+//   lParam = [31:20] frame sequence, [19:14] box count, [13:0] inference time in ms
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_FRAME_SEQ_BITS 12
+#define NPU_FRAME_BOX_BITS 6
+#define NPU_FRAME_TIME_BITS 14
+
+#define NPU_FRAME_SEQ_MAX ((1UL << NPU_FRAME_SEQ_BITS) - 1)
+#define NPU_FRAME_BOX_MAX ((1UL << NPU_FRAME_BOX_BITS) - 1)
+#define NPU_FRAME_TIME_MAX ((1UL << NPU_FRAME_TIME_BITS) - 1)
+
+struct NpuFrame
+{
+    int16_t decision;
+    uint16_t seq; // wraps at NPU_FRAME_SEQ_MAX
+    uint8_t tenantScore;
+    uint8_t strangerScore;
+    uint8_t boxCount;     // saturates at NPU_FRAME_BOX_MAX
+    uint16_t inferenceMs; // saturates at NPU_FRAME_TIME_MAX
+
+    uint16_t packScores(void) const
+    {
+        return ((uint16_t)strangerScore << 8) | tenantScore;
+    }
+
+    uint32_t packInfo(void) const
+    {
+        uint32_t boxes = boxCount < NPU_FRAME_BOX_MAX ? boxCount : NPU_FRAME_BOX_MAX;
+        uint32_t ms = inferenceMs < NPU_FRAME_TIME_MAX ? inferenceMs : NPU_FRAME_TIME_MAX;
+        return ((uint32_t)(seq & NPU_FRAME_SEQ_MAX) << (NPU_FRAME_BOX_BITS + NPU_FRAME_TIME_BITS)) |
+               (boxes << NPU_FRAME_TIME_BITS) |
+               ms;
+    }
+
+    static NpuFrame unpack(int16_t iParam, uint16_t uParam, uint32_t lParam)
+    {
+        NpuFrame frame;
+        frame.decision = iParam;
+        frame.tenantScore = uParam & 0xff;
+        frame.strangerScore = uParam >> 8;
+        frame.seq = (lParam >> (NPU_FRAME_BOX_BITS + NPU_FRAME_TIME_BITS)) & NPU_FRAME_SEQ_MAX;
+        frame.boxCount = (lParam >> NPU_FRAME_TIME_BITS) & NPU_FRAME_BOX_MAX;
+        frame.inferenceMs = lParam & NPU_FRAME_TIME_MAX;
+        return frame;
+    }
+};
@@ -0,0 +1,128 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include "../AppLog.h"
+#include "./NpuBox.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Model-output policies of NpuPipeline
+//   each policy turns the output of one kind of model into NpuBox, walking only the result
+//   type the model produces, so the loops over the other types are not compiled at all
+//
+//   NpuModelBox   : object detection (boxes), the doorbell model
+//   NpuModelClass : image classification (classes), reported as one full-frame box
+//   NpuModelPose  : pose estimation (keypoints), the box of each keypoint set
+//   NpuModelAll   : boxes, with classes/points/keypoints traced for debugging a new model
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_MODEL_INPUT_SIZE 192                // in pixel, the square input of the person model
+#define NPU_CLASS_BOX_SIZE NPU_MODEL_INPUT_SIZE // size of the full-frame box standing for a class result
+
+struct NpuModelBox
+{
+    template <typename AI>
+    static int collect(AI &ai, NpuBox *boxes, int maxBoxes)
+    {
+        int count = 0;
+        for (int i = 0; i < (int)ai.boxes().size() && count < maxBoxes; i++)
+        {
+            const auto &box = ai.boxes()[i];
+            // LOG_TRACE("Box[", i, "], target=", box.target, ", score=", box.score, ", x=", box.x, ", y=", box.y, ", w=", box.w, ", h=", box.h);
+            boxes[count++] = {box.x, box.y, box.w, box.h, box.score, box.target};
+        }
+        return count;
+    }
+};
+
+struct NpuModelClass
+{
+    template <typename AI>
+    static int collect(AI &ai, NpuBox *boxes, int maxBoxes)
+    {
+        // a classifier has no geometry: every frame shows the same full-frame box,
+        // so NpuTracker keeps a single track and votes on the class over frames
+        int best = -1;
+        for (int i = 0; i < (int)ai.classes().size(); i++)
+        {
+            // LOG_TRACE("Class[", i, "], target=", ai.classes()[i].target, ", score=", ai.classes()[i].score);
+            if (best < 0 || ai.classes()[i].score > ai.classes()[best].score)
+            {
+                best = i;
+            }
+        }
+        if (best < 0 || maxBoxes < 1)
+        {
+            return 0;
+        }
+        // its anchor (bottom center, see NpuZone) one row above the bottom of the input: an
+        // include zone reaching the bottom of the image keeps it, the crossing test of a
+        // polygon zone leaves out the bottom edge itself
+        boxes[0] = {NPU_CLASS_BOX_SIZE / 2, NPU_CLASS_BOX_SIZE - 2 - NPU_CLASS_BOX_SIZE / 2, NPU_CLASS_BOX_SIZE, NPU_CLASS_BOX_SIZE,
+                    ai.classes()[best].score, ai.classes()[best].target};
+        return 1;
+    }
+};
+
+struct NpuModelPose
+{
+    template <typename AI>
+    static int collect(AI &ai, NpuBox *boxes, int maxBoxes)
+    {
+        // the points are not used by the decision, only the box of each person
+        int count = 0;
+        for (int i = 0; i < (int)ai.keypoints().size() && count < maxBoxes; i++)
+        {
+            const auto &box = ai.keypoints()[i].box;
+            // LOG_TRACE("keypoint[", i, "], target=", box.target, ", score=", box.score, ", points=", ai.keypoints()[i].points.size());
+            boxes[count++] = {box.x, box.y, box.w, box.h, box.score, box.target};
+        }
+        return count;
+    }
+};
+
+struct NpuModelAll
+{
+    template <typename AI>
+    static int collect(AI &ai, NpuBox *boxes, int maxBoxes)
+    {
+        // LOG_TRACE("ai.boxes().size()=", ai.boxes().size(), ", .classes().size()=", ai.classes().size(), ", .points().size()=", ai.points().size(), ", .keypoints().size()=", ai.keypoints().size());
+        for (int i = 0; i < (int)ai.classes().size(); i++)
+        {
+            LOG_TRACE("Class[", i, "], target=", ai.classes()[i].target, ", score=", ai.classes()[i].score);
+        }
+
+        for (int i = 0; i < (int)ai.points().size(); i++)
+        {
+            LOG_TRACE("Point[", i, "], target=", ai.points()[i].target, ", score=", ai.points()[i].score, ", x=", ai.points()[i].x, ", y=", ai.points()[i].y);
+        }
+        for (int i = 0; i < (int)ai.keypoints().size(); i++)
+        {
+            LOG_TRACE("keypoint[", i, "], target=", ai.keypoints()[i].box.target, ", score=", ai.keypoints()[i].box.score,
+                      ", box:[x=", ai.keypoints()[i].box.x, ", y=", ai.keypoints()[i].box.y, ", w=", ai.keypoints()[i].box.w, ", h=", ai.keypoints()[i].box.h, "]");
+            LOG_TRACE("points:[");
+            for (int j = 0; j < (int)ai.keypoints()[i].points.size(); j++)
+            {
+                LOG_TRACE("\t[", ai.keypoints()[i].points[j].x, ", ", ai.keypoints()[i].points[j].y, "]");
+            }
+            LOG_TRACE("]");
+        }
+        return NpuModelBox::collect(ai, boxes, maxBoxes);
+    }
+};
@@ -0,0 +1,102 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include "../util/LatencyStats.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// NPU latency instrumentation, all values in unit of ms
+//   Preprocess/Inference/Postprocess : phases reported by the WE2 in SSCMA perf()
+//   Transport                        : invoke() round trip minus the WE2 phases, i.e. the
+//                                      time spent on the link and in the SSCMA driver
+//   Invoke                           : whole invoke() round trip seen by the ESP32-C3
+//   Host                             : ESP32-C3 side processing of the result, in unit of us
+//   Switch                           : model switch of the cascade (AT+MODEL round trip)
+////////////////////////////////////////////////////////////////////////////////////////////
+class NpuPerf
+{
+public:
+    typedef enum _Phase : uint8_t
+    {
+        Preprocess = 0,
+        Inference,
+        Postprocess,
+        Transport,
+        Invoke,
+        Host,
+        Switch,
+
+        PhaseCount,
+    } Phase;
+
+    void reset(void)
+    {
+        for (int i = 0; i < PhaseCount; i++)
+        {
+            _stats[i].reset();
+        }
+    }
+
+    void record(Phase phase, uint32_t ms)
+    {
+        _stats[phase].record(ms < UINT16_MAX ? ms : UINT16_MAX);
+    }
+
+    void recordInvoke(uint16_t preprocess, uint16_t inference, uint16_t postprocess, uint32_t invokeMs)
+    {
+        uint32_t npuMs = (uint32_t)preprocess + inference + postprocess;
+        record(Preprocess, preprocess);
+        record(Inference, inference);
+        record(Postprocess, postprocess);
+        record(Transport, invokeMs > npuMs ? invokeMs - npuMs : 0);
+        record(Invoke, invokeMs);
+    }
+
+    const LatencyStats &stats(Phase phase) const
+    {
+        return _stats[phase];
+    }
+
+    static const char *getPhaseString(Phase phase)
+    {
+        switch (phase)
+        {
+        case Preprocess:
+            return "preprocess";
+        case Inference:
+            return "inference";
+        case Postprocess:
+            return "postprocess";
+        case Transport:
+            return "transport";
+        case Invoke:
+            return "invoke";
+        case Host:
+            return "host";
+        case Switch:
+            return "switch";
+        default:
+            return "unknown";
+        }
+    }
+
+private:
+    LatencyStats _stats[PhaseCount];
+};
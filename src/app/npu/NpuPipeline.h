@@ -0,0 +1,184 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include "../AppEvent.h"
+#include "../AppLog.h"
+#include "./NpuBox.h"
+#include "./NpuCascade.h"
+#include "./NpuFrame.h"
+#include "./NpuModel.h"
+#include "./NpuScheduler.h"
+#include "./NpuThreshold.h"
+#include "./NpuTracker.h"
+#include "./NpuZone.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Post-processing of an inference result into an NpuFrame
+//   AI is SSCMA on the target, or any class with the same boxes()/classes()/points()/
+//   keypoints() accessors (e.g. the mock used by tools/replay on a Linux host)
+//   Model is one of the policies of NpuModel.h, matching the model flashed on the WE2
+//   The role and thresholds of each class come from NpuThreshold, tunable at runtime
+//   With the cascade enabled, the result is of the model of the current NpuCascade stage
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename AI, typename Model = NpuModelBox>
+class NpuPipeline
+{
+public:
+    NpuPipeline() : _tracker(), _zones(), _threshold(), _cascade(), _isCascade(false), _boxes(), _decisions(), _decisionCount(0)
+    {
+    }
+
+    void reset(void)
+    {
+        _tracker.reset();
+        _cascade.reset();
+    }
+
+    const NpuTracker &tracker(void) const
+    {
+        return _tracker;
+    }
+
+    NpuZoneFilter &zones(void)
+    {
+        return _zones;
+    }
+
+    NpuThreshold &threshold(void)
+    {
+        return _threshold;
+    }
+
+    const NpuCascade &cascade(void) const
+    {
+        return _cascade;
+    }
+
+    // track decisions of the last process()
+    int decisionCount(void) const
+    {
+        return _decisionCount;
+    }
+    const NpuTracker::Decision &decision(int i) const
+    {
+        return _decisions[i];
+    }
+
+    bool isCascade(void) const
+    {
+        return _isCascade;
+    }
+
+    void setCascade(bool isCascade)
+    {
+        _isCascade = isCascade;
+        _cascade.reset();
+    }
+
+    // fill frame.decision, scores and box count from the result of the last invoke()
+    NpuScheduler::FrameResult process(AI &ai, bool isOk, NpuFrame &frame)
+    {
+        frame.decision = IpcNpuNoObjectDetected;
+        _decisionCount = 0;
+
+        int count = isOk ? Model::collect(ai, _boxes, NPU_BOX_MAX) : 0;
+        count = _zones.filter(_boxes, count); // boxes out of the region of interest are never seen by the tracker
+        if (_isCascade)
+        {
+            if (_cascade.stage() == NpuCascade::Presence)
+            {
+                // a person box says nothing about tenant or stranger, so the tracker only ages
+                count = _cascade.onPresence(_boxes, count);
+                frame.boxCount = count;
+                frame.decision = count ? IpcNpuObjectUnclassified : IpcNpuNoObjectDetected;
+                _tracker.update(_boxes, 0, _threshold, nullptr, 0);
+                return count ? NpuScheduler::FrameConfident : NpuScheduler::FrameEmpty; // burst the identity model
+            }
+            count = _cascade.onIdentity(_boxes, count);
+        }
+        count = dropIgnored(count);
+        if (count > 0)
+        {
+            // fold all boxes of the frame into a single summary
+            for (int i = 0; i < count; i++)
+            {
+                uint8_t &maxScore = (_threshold.roleOf(_boxes[i].target) == NpuThreshold::Tenant) ? frame.tenantScore : frame.strangerScore;
+                if (_boxes[i].score > maxScore)
+                {
+                    maxScore = _boxes[i].score;
+                }
+            }
+            frame.boxCount = count;
+
+            // a stranger or tenant is reported only once its track has enough votes
+            frame.decision = IpcNpuObjectUnclassified;
+            _decisionCount = _tracker.update(_boxes, count, _threshold, _decisions, NPU_TRACK_MAX);
+            for (int i = 0; i < _decisionCount; i++)
+            {
+                bool isTenant = _threshold.roleOf(_decisions[i].target) == NpuThreshold::Tenant;
+                LOG_TRACE("track #", _decisions[i].trackId, " decided: ", isTenant ? "tenant" : "stranger", ", score=", _decisions[i].score);
+                if (!isTenant)
+                {
+                    frame.decision = IpcNpuStrangerDetected;
+                }
+                else if (frame.decision != IpcNpuStrangerDetected)
+                {
+                    frame.decision = IpcNpuTenderDetected;
+                }
+            }
+        }
+        else
+        {
+            _tracker.update(_boxes, 0, _threshold, nullptr, 0); // age out tracks
+        }
+
+        // keep bursting while there is evidence to collect, even if no track is decided yet
+        if (_tracker.engagedCount() > 0)
+        {
+            return NpuScheduler::FrameConfident;
+        }
+        return frame.boxCount ? NpuScheduler::FrameUncertain : NpuScheduler::FrameEmpty;
+    }
+
+private:
+    NpuTracker _tracker;
+    NpuZoneFilter _zones;
+    NpuThreshold _threshold;
+    NpuCascade _cascade;
+    bool _isCascade;
+    NpuBox _boxes[NPU_BOX_MAX];
+    NpuTracker::Decision _decisions[NPU_TRACK_MAX];
+    int _decisionCount;
+
+    // drop the boxes of classes with role Ignore, compacting _boxes[] in place
+    int dropIgnored(int count)
+    {
+        int kept = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (_threshold.roleOf(_boxes[i].target) != NpuThreshold::Ignore)
+            {
+                _boxes[kept++] = _boxes[i];
+            }
+        }
+        return kept;
+    }
+};
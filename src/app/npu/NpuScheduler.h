@@ -0,0 +1,239 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Adaptive inference rate
+//   Burst   : max rate right after the PIR edge or a detection above the score threshold
+//   Fast    : 4 Hz
+//   Slow    : 1 Hz
+//   Trickle : 0.2 Hz
+//   Stopped : session over, NPU idle
+// The scheduler steps down one state after NPU_RATE_*_FRAMES consecutive empty frames
+// An uncertain frame holds the rate, up to NPU_RATE_UNCERTAIN_FRAMES in a row with no
+// confident one; beyond, it counts as empty, so a static low score box (a poster, a shadow)
+// does not keep the NPU running
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_RATE_BURST_PERIOD 100 // in unit of ms
+#define NPU_RATE_BURST_FRAMES 4   // number of empty frames before stepping down
+
+#define NPU_RATE_FAST_PERIOD 250
+#define NPU_RATE_FAST_FRAMES 4
+
+#define NPU_RATE_SLOW_PERIOD 1000
+#define NPU_RATE_SLOW_FRAMES 2
+
+#define NPU_RATE_TRICKLE_PERIOD 5000
+#define NPU_RATE_TRICKLE_FRAMES 1
+
+#define NPU_RATE_UNCERTAIN_FRAMES 50 // 5 s at burst rate
+
+class NpuScheduler
+{
+public:
+    typedef enum _State : uint8_t
+    {
+        Stopped = 0,
+        Burst,
+        Fast,
+        Slow,
+        Trickle,
+
+        StateCount,
+    } State;
+
+    typedef enum _FrameResult : uint8_t
+    {
+        FrameEmpty = 0,  // no box at all
+        FrameUncertain,  // boxes, but none above the score threshold
+        FrameConfident,  // at least one box above the score threshold
+    } FrameResult;
+
+    NpuScheduler() : _state(Stopped), _emptyFrames(0), _uncertainFrames(0)
+    {
+        clearSession();
+        for (int i = 0; i < StateCount; i++)
+        {
+            _totalCount[i] = 0;
+        }
+    }
+
+    // session start (PIR edge): burst at max rate, reset per-session counters
+    void start(void)
+    {
+        clearSession();
+        enter(Burst);
+    }
+
+    void stop(void)
+    {
+        enter(Stopped);
+    }
+
+    // account one inference done in the current state, then pick the next state
+    // return true if the state (and so the period) has changed
+    bool onFrame(FrameResult result)
+    {
+        if (_state == Stopped)
+        {
+            return false;
+        }
+
+        _sessionCount[_state]++;
+        _totalCount[_state]++;
+
+        State prev = _state;
+        if (result == FrameUncertain && ++_uncertainFrames > NPU_RATE_UNCERTAIN_FRAMES)
+        {
+            result = FrameEmpty;
+        }
+        switch (result)
+        {
+        case FrameConfident:
+            _uncertainFrames = 0;
+            enter(Burst);
+            break;
+        case FrameUncertain:
+            _emptyFrames = 0; // someone is there, hold the current rate
+            break;
+        case FrameEmpty:
+        default:
+            if (++_emptyFrames >= framesOf(_state))
+            {
+                enter(static_cast<State>((_state + 1) % StateCount));
+            }
+            break;
+        }
+        return _state != prev;
+    }
+
+    State state(void) const
+    {
+        return _state;
+    }
+
+    bool isRunning(void) const
+    {
+        return _state != Stopped;
+    }
+
+    // inference period of the current state in unit of ms, 0 if stopped
+    uint32_t period(void) const
+    {
+        return periodOf(_state);
+    }
+
+    uint32_t sessionCount(State state) const
+    {
+        return _sessionCount[state];
+    }
+
+    uint32_t sessionTotal(void) const
+    {
+        uint32_t sum = 0;
+        for (int i = 0; i < StateCount; i++)
+        {
+            sum += _sessionCount[i];
+        }
+        return sum;
+    }
+
+    uint32_t totalCount(State state) const
+    {
+        return _totalCount[state];
+    }
+
+    static uint32_t periodOf(State state)
+    {
+        switch (state)
+        {
+        case Burst:
+            return NPU_RATE_BURST_PERIOD;
+        case Fast:
+            return NPU_RATE_FAST_PERIOD;
+        case Slow:
+            return NPU_RATE_SLOW_PERIOD;
+        case Trickle:
+            return NPU_RATE_TRICKLE_PERIOD;
+        case Stopped:
+        default:
+            return 0;
+        }
+    }
+
+    static const char *getStateString(State state)
+    {
+        switch (state)
+        {
+        case Burst:
+            return "burst";
+        case Fast:
+            return "4Hz";
+        case Slow:
+            return "1Hz";
+        case Trickle:
+            return "0.2Hz";
+        case Stopped:
+        default:
+            return "stopped";
+        }
+    }
+
+private:
+    State _state;
+    uint16_t _emptyFrames;
+    uint16_t _uncertainFrames; // in a row since the session start or the last confident frame
+    uint32_t _sessionCount[StateCount];
+    uint32_t _totalCount[StateCount];
+
+    void enter(State state)
+    {
+        _state = state;
+        _emptyFrames = 0;
+    }
+
+    void clearSession(void)
+    {
+        _uncertainFrames = 0;
+        for (int i = 0; i < StateCount; i++)
+        {
+            _sessionCount[i] = 0;
+        }
+    }
+
+    static uint16_t framesOf(State state)
+    {
+        switch (state)
+        {
+        case Burst:
+            return NPU_RATE_BURST_FRAMES;
+        case Fast:
+            return NPU_RATE_FAST_FRAMES;
+        case Slow:
+            return NPU_RATE_SLOW_FRAMES;
+        case Trickle:
+            return NPU_RATE_TRICKLE_FRAMES;
+        case Stopped:
+        default:
+            return 0;
+        }
+    }
+};
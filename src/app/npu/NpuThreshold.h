@@ -0,0 +1,158 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Per-class score thresholds, indexed by the model's class id (box target)
+//   role  : what a box of the class stands for, Ignore drops the box
+//   enter : min score for a box to count as evidence on a track which has none yet
+//   leave : min score to keep counting once the track has evidence (leave <= enter),
+//           so a visitor scoring around the threshold does not flicker in and out
+// Class ids >= NPU_CLASS_MAX share the last entry
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_CLASS_MAX 8
+
+#define NPU_THRESHOLD_ENTER 60 // default thresholds, in unit of score (0..100)
+#define NPU_THRESHOLD_LEAVE 50
+
+class NpuThreshold
+{
+public:
+    typedef enum _Role : uint8_t
+    {
+        Ignore = 0,
+        Tenant,
+        Stranger,
+
+        RoleCount,
+    } Role;
+
+    struct Entry
+    {
+        uint8_t role;
+        uint8_t enter;
+        uint8_t leave;
+    };
+
+    // defaults: class 0 is the tenant, any other class is a stranger
+    NpuThreshold()
+    {
+        for (int i = 0; i < NPU_CLASS_MAX; i++)
+        {
+            _entries[i].role = (i == 0) ? Tenant : Stranger;
+            _entries[i].enter = NPU_THRESHOLD_ENTER;
+            _entries[i].leave = NPU_THRESHOLD_LEAVE;
+        }
+    }
+
+    // return false if the thresholds are out of range or leave > enter
+    bool set(uint8_t classId, uint8_t enter, uint8_t leave)
+    {
+        if (!isValid(Stranger, enter, leave))
+        {
+            return false;
+        }
+        Entry &entry = _entries[slotOf(classId)];
+        entry.enter = enter;
+        entry.leave = leave;
+        return true;
+    }
+
+    bool setRole(uint8_t classId, Role role)
+    {
+        if (role >= RoleCount)
+        {
+            return false;
+        }
+        _entries[slotOf(classId)].role = role;
+        return true;
+    }
+
+    // replace the whole table, e.g. read from NVS; return false and keep the table if any entry is invalid
+    bool load(const Entry *entries, int count)
+    {
+        if (count != NPU_CLASS_MAX)
+        {
+            return false;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            if (!isValid(entries[i].role, entries[i].enter, entries[i].leave))
+            {
+                return false;
+            }
+        }
+        for (int i = 0; i < count; i++)
+        {
+            _entries[i] = entries[i];
+        }
+        return true;
+    }
+
+    const Entry *entries(void) const
+    {
+        return _entries;
+    }
+    const Entry &entry(uint8_t classId) const
+    {
+        return _entries[slotOf(classId)];
+    }
+
+    Role roleOf(uint8_t classId) const
+    {
+        return static_cast<Role>(entry(classId).role);
+    }
+    uint8_t enterOf(uint8_t classId) const
+    {
+        return entry(classId).enter;
+    }
+    uint8_t leaveOf(uint8_t classId) const
+    {
+        return entry(classId).leave;
+    }
+
+    static const char *getRoleString(Role role)
+    {
+        switch (role)
+        {
+        case Tenant:
+            return "tenant";
+        case Stranger:
+            return "stranger";
+        case Ignore:
+        default:
+            return "ignore";
+        }
+    }
+
+private:
+    Entry _entries[NPU_CLASS_MAX];
+
+    static uint8_t slotOf(uint8_t classId)
+    {
+        return classId < NPU_CLASS_MAX ? classId : NPU_CLASS_MAX - 1;
+    }
+
+    static bool isValid(uint8_t role, uint8_t enter, uint8_t leave)
+    {
+        return role < RoleCount && enter <= 100 && leave <= enter;
+    }
+};
@@ -0,0 +1,200 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include "./NpuTracker.h"
+
+NpuTracker::NpuTracker() : _nextId(1), _engagedCount(0), _decisionCount(0)
+{
+    reset();
+}
+
+void NpuTracker::reset(void)
+{
+    memset(_tracks, 0, sizeof(_tracks));
+    _engagedCount = 0;
+}
+
+int NpuTracker::update(const NpuBox *boxes, int count, const NpuThreshold &threshold, Decision *decisions, int maxDecisions)
+{
+    bool isMatched[NPU_TRACK_MAX] = {false};
+    int decided = 0;
+    _engagedCount = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        const NpuBox &box = boxes[i];
+        int t = match(box, isMatched);
+        if (t < 0)
+        {
+            t = allocate();
+            if (t < 0)
+            {
+                continue; // no free slot, drop the box for this frame
+            }
+        }
+
+        Track &track = _tracks[t];
+        isMatched[t] = true;
+        track.box = box;
+        track.misses = 0;
+        if (track.age < UINT8_MAX)
+        {
+            track.age++;
+        }
+
+        uint8_t level = track.isEngaged ? threshold.leaveOf(box.target) : threshold.enterOf(box.target);
+        track.isEngaged = box.score >= level;
+        if (!track.isEngaged)
+        {
+            continue;
+        }
+        _engagedCount++;
+
+        if (vote(track, box) && decided < maxDecisions)
+        {
+            decisions[decided].trackId = track.id;
+            decisions[decided].target = track.decision;
+            decisions[decided].score = box.score;
+            decisions[decided].box = box;
+            decided++;
+            _decisionCount++;
+        }
+    }
+
+    // age out tracks which have no box in this frame
+    for (int t = 0; t < NPU_TRACK_MAX; t++)
+    {
+        if (_tracks[t].id && !isMatched[t] && ++_tracks[t].misses > NPU_TRACK_MAX_MISSES)
+        {
+            memset(&_tracks[t], 0, sizeof(Track));
+        }
+    }
+    return decided;
+}
+
+int NpuTracker::activeCount(void) const
+{
+    int count = 0;
+    for (int t = 0; t < NPU_TRACK_MAX; t++)
+    {
+        if (_tracks[t].id)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+int NpuTracker::match(const NpuBox &box, const bool *isMatched) const
+{
+    int best = -1;
+    uint8_t bestIou = 0;
+    uint32_t bestDistance2 = UINT32_MAX;
+
+    for (int t = 0; t < NPU_TRACK_MAX; t++)
+    {
+        const Track &track = _tracks[t];
+        if (!track.id || isMatched[t])
+        {
+            continue;
+        }
+
+        uint8_t iou = box.iou(track.box);
+        if (iou >= NPU_TRACK_IOU_MIN)
+        {
+            if (iou > bestIou)
+            {
+                best = t;
+                bestIou = iou;
+            }
+        }
+        else if (bestIou == 0)
+        {
+            // fall back to centroid distance: center moved less than half of the track size
+            uint32_t radius = (track.box.w > track.box.h ? track.box.w : track.box.h) / 2;
+            uint32_t distance2 = box.distance2(track.box);
+            if (distance2 <= radius * radius && distance2 < bestDistance2)
+            {
+                best = t;
+                bestDistance2 = distance2;
+            }
+        }
+    }
+    return best;
+}
+
+int NpuTracker::allocate(void)
+{
+    int victim = -1;
+    for (int t = 0; t < NPU_TRACK_MAX; t++)
+    {
+        if (!_tracks[t].id)
+        {
+            victim = t;
+            break;
+        }
+        // all slots busy: recycle the track which has been missing the longest
+        if (_tracks[t].misses && (victim < 0 || _tracks[t].misses > _tracks[victim].misses))
+        {
+            victim = t;
+        }
+    }
+    if (victim < 0)
+    {
+        return -1;
+    }
+
+    memset(&_tracks[victim], 0, sizeof(Track));
+    _tracks[victim].id = _nextId;
+    _tracks[victim].decision = -1;
+    _nextId = (_nextId == UINT8_MAX) ? 1 : _nextId + 1;
+    return victim;
+}
+
+// count the vote of a box above threshold, return true if the track gets decided by this box
+bool NpuTracker::vote(Track &track, const NpuBox &box)
+{
+    if (track.decision >= 0)
+    {
+        return false;
+    }
+
+    uint8_t slot = slotOf(box.target);
+    if (track.votes[slot] < UINT8_MAX)
+    {
+        track.votes[slot]++;
+    }
+
+    uint8_t others = 0;
+    for (int c = 0; c < NPU_TRACK_CLASS_MAX; c++)
+    {
+        if (c != slot && track.votes[c] > others)
+        {
+            others = track.votes[c];
+        }
+    }
+
+    if (box.score >= NPU_TRACK_CONFIDENT || track.votes[slot] >= others + NPU_TRACK_VOTES)
+    {
+        track.decision = box.target;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,102 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include "./NpuBox.h"
+#include "./NpuThreshold.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Multi-frame tracker with temporal voting
+// Boxes are matched to tracks by IoU (or centroid distance for small/fast boxes), so a
+// visitor keeps the same track id across frames. Each track accumulates per-class votes
+// and emits a decision once, when a class gets NPU_TRACK_VOTES votes ahead of any other
+// class, or a single box reaches NPU_TRACK_CONFIDENT.
+// A box votes when its score is above the enter threshold of its class, or above the leave
+// threshold while its track is engaged (the previous box of the track voted).
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_TRACK_MAX 8         // max number of concurrent tracks
+#define NPU_TRACK_CLASS_MAX 4   // targets >= NPU_TRACK_CLASS_MAX share the last slot
+#define NPU_TRACK_IOU_MIN 30    // in percent, min IoU to match a box to a track
+#define NPU_TRACK_MAX_MISSES 3  // number of frames a track survives without a matched box
+#define NPU_TRACK_VOTES 2       // votes (boxes above score threshold) a class needs to decide a track
+#define NPU_TRACK_CONFIDENT 85  // score that decides a track in a single frame
+
+class NpuTracker
+{
+public:
+    struct Track
+    {
+        NpuBox box;  // last matched box
+        uint8_t id;  // 0 = free slot
+        uint8_t age; // number of frames since the track is created
+        uint8_t misses;
+        bool isEngaged; // the last matched box was above the threshold
+        uint8_t votes[NPU_TRACK_CLASS_MAX];
+        int16_t decision; // decided target, -1 = undecided
+    };
+
+    // decision emitted by update(), at most one per track lifetime
+    struct Decision
+    {
+        uint8_t trackId;
+        uint8_t target;
+        uint8_t score;
+        NpuBox box; // box which decided the track
+    };
+
+    NpuTracker();
+
+    void reset(void);
+
+    // feed the boxes of one frame; boxes below threshold count as evidence-free matches
+    // return the number of decisions written to decisions[]
+    int update(const NpuBox *boxes, int count, const NpuThreshold &threshold, Decision *decisions, int maxDecisions);
+
+    int activeCount(void) const;
+
+    // number of boxes above threshold in the last update()
+    int engagedCount(void) const
+    {
+        return _engagedCount;
+    }
+    uint32_t decisionCount(void) const
+    {
+        return _decisionCount;
+    }
+    const Track &track(int i) const
+    {
+        return _tracks[i];
+    }
+
+private:
+    Track _tracks[NPU_TRACK_MAX];
+    uint8_t _nextId;
+    uint8_t _engagedCount;
+    uint32_t _decisionCount;
+
+    int match(const NpuBox &box, const bool *isMatched) const;
+    int allocate(void);
+    bool vote(Track &track, const NpuBox &box);
+
+    static uint8_t slotOf(uint8_t target)
+    {
+        return target < NPU_TRACK_CLASS_MAX ? target : NPU_TRACK_CLASS_MAX - 1;
+    }
+};
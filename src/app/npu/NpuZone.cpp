@@ -0,0 +1,146 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "./NpuZone.h"
+
+bool NpuZone::set(Rule rule, const NpuPoint *points, uint8_t pointCount)
+{
+    if (pointCount < 2 || pointCount > NPU_ZONE_POINT_MAX)
+    {
+        return false;
+    }
+
+    _rule = rule;
+    _pointCount = pointCount;
+    for (int i = 0; i < pointCount; i++)
+    {
+        _points[i] = points[i];
+    }
+    _dropCount = 0;
+    return true;
+}
+
+bool NpuZone::contains(NpuPoint point) const
+{
+    if (_pointCount == 2)
+    {
+        // rectangle given by 2 opposite corners, edges included
+        int16_t left = _points[0].x < _points[1].x ? _points[0].x : _points[1].x;
+        int16_t right = _points[0].x < _points[1].x ? _points[1].x : _points[0].x;
+        int16_t top = _points[0].y < _points[1].y ? _points[0].y : _points[1].y;
+        int16_t bottom = _points[0].y < _points[1].y ? _points[1].y : _points[0].y;
+        return point.x >= left && point.x <= right && point.y >= top && point.y <= bottom;
+    }
+
+    // crossing number: count the edges crossed by a ray from the point towards +x
+    // the crossing x is compared by cross-multiplying with the edge height, so no division
+    bool isInside = false;
+    for (int i = 0, j = _pointCount - 1; i < _pointCount; j = i++)
+    {
+        const NpuPoint &a = _points[j];
+        const NpuPoint &b = _points[i];
+        if ((a.y > point.y) != (b.y > point.y))
+        {
+            int32_t edge = (int32_t)(b.x - a.x) * (point.y - a.y);
+            int32_t offset = (int32_t)(point.x - a.x) * (b.y - a.y);
+            if (b.y > a.y ? offset < edge : offset > edge)
+            {
+                isInside = !isInside;
+            }
+        }
+    }
+    return isInside;
+}
+
+bool NpuZoneFilter::add(NpuZone::Rule rule, const NpuPoint *points, uint8_t pointCount)
+{
+    if (_zoneCount >= NPU_ZONE_MAX || !_zones[_zoneCount].set(rule, points, pointCount))
+    {
+        return false;
+    }
+    if (rule == NpuZone::Include)
+    {
+        _includeCount++;
+    }
+    _zoneCount++;
+    return true;
+}
+
+void NpuZoneFilter::clear(void)
+{
+    _zoneCount = 0;
+    _includeCount = 0;
+    _outsideCount = 0;
+}
+
+void NpuZoneFilter::resetCount(void)
+{
+    for (int i = 0; i < _zoneCount; i++)
+    {
+        _zones[i].resetCount();
+    }
+    _outsideCount = 0;
+}
+
+int NpuZoneFilter::filter(NpuBox *boxes, int count)
+{
+    if (_zoneCount == 0)
+    {
+        return count;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (isKept(boxes[i]))
+        {
+            boxes[kept++] = boxes[i];
+        }
+    }
+    return kept;
+}
+
+bool NpuZoneFilter::isKept(const NpuBox &box)
+{
+    NpuPoint anchor = anchorOf(box);
+
+    bool isIncluded = (_includeCount == 0);
+    for (int i = 0; i < _zoneCount; i++)
+    {
+        NpuZone &zone = _zones[i];
+        if (zone.rule() == NpuZone::Exclude)
+        {
+            if (zone.contains(anchor))
+            {
+                zone.drop();
+                return false;
+            }
+        }
+        else if (!isIncluded && zone.contains(anchor))
+        {
+            isIncluded = true;
+        }
+    }
+
+    if (!isIncluded)
+    {
+        _outsideCount++;
+    }
+    return isIncluded;
+}
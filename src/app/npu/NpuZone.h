@@ -0,0 +1,144 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include "./NpuBox.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Region-of-interest zones in NPU pixel space
+// A zone is a rectangle (2 corners) or a polygon (3..NPU_ZONE_POINT_MAX vertices).
+// A box is tested by its anchor, the bottom center of the box (where a person stands),
+// so someone on the sidewalk behind the porch is not taken in by a porch zone.
+// A box is kept when
+//   - it is inside at least one Include zone, or there is no Include zone at all, and
+//   - it is not inside any Exclude zone
+// Geometry is integer only: a crossing test with 32-bit products, no division.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_ZONE_MAX 4       // max number of zones
+#define NPU_ZONE_POINT_MAX 8 // max number of vertices of a polygon zone
+
+struct NpuPoint
+{
+    int16_t x;
+    int16_t y;
+};
+
+class NpuZone
+{
+public:
+    typedef enum _Rule : uint8_t
+    {
+        Include = 0,
+        Exclude,
+    } Rule;
+
+    NpuZone() : _rule(Include), _pointCount(0), _dropCount(0), _points()
+    {
+    }
+
+    // return false if pointCount is out of 2..NPU_ZONE_POINT_MAX
+    bool set(Rule rule, const NpuPoint *points, uint8_t pointCount);
+
+    bool contains(NpuPoint point) const;
+
+    Rule rule(void) const
+    {
+        return _rule;
+    }
+    uint8_t pointCount(void) const
+    {
+        return _pointCount;
+    }
+    const NpuPoint &point(int i) const
+    {
+        return _points[i];
+    }
+
+    // number of boxes dropped by this zone
+    uint32_t dropCount(void) const
+    {
+        return _dropCount;
+    }
+    void drop(void)
+    {
+        _dropCount++;
+    }
+    void resetCount(void)
+    {
+        _dropCount = 0;
+    }
+
+    static const char *getRuleString(Rule rule)
+    {
+        return rule == Exclude ? "exclude" : "include";
+    }
+
+private:
+    Rule _rule;
+    uint8_t _pointCount;
+    uint32_t _dropCount;
+    NpuPoint _points[NPU_ZONE_POINT_MAX];
+};
+
+class NpuZoneFilter
+{
+public:
+    NpuZoneFilter() : _zones(), _zoneCount(0), _includeCount(0), _outsideCount(0)
+    {
+    }
+
+    // return false if the table is full or the zone is invalid
+    bool add(NpuZone::Rule rule, const NpuPoint *points, uint8_t pointCount);
+    void clear(void);
+
+    // drop the boxes rejected by the zones, compacting boxes[] in place
+    // return the number of boxes kept
+    int filter(NpuBox *boxes, int count);
+
+    int zoneCount(void) const
+    {
+        return _zoneCount;
+    }
+    const NpuZone &zone(int i) const
+    {
+        return _zones[i];
+    }
+
+    // number of boxes dropped for being outside of every Include zone
+    uint32_t outsideCount(void) const
+    {
+        return _outsideCount;
+    }
+    void resetCount(void);
+
+    static NpuPoint anchorOf(const NpuBox &box)
+    {
+        NpuPoint point = {(int16_t)box.x, (int16_t)(box.y + box.h / 2)};
+        return point;
+    }
+
+private:
+    NpuZone _zones[NPU_ZONE_MAX];
+    uint8_t _zoneCount;
+    uint8_t _includeCount;
+    uint32_t _outsideCount;
+
+    bool isKept(const NpuBox &box);
+};
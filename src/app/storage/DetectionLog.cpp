@@ -0,0 +1,132 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "./DetectionLog.h"
+
+DetectionLog::DetectionLog() : _partition(nullptr),
+                               _head(0),
+                               _nextSeq(0),
+                               _batch(),
+                               _batchCount(0),
+                               _droppedCount(0),
+                               _flushCount(0),
+                               _eraseCount(0)
+{
+}
+
+bool DetectionLog::begin(void)
+{
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)DETECTION_LOG_SUBTYPE, DETECTION_LOG_PARTITION);
+    if (!_partition)
+    {
+        return false;
+    }
+
+    // the head sector is the one whose first record has the highest seq
+    DetectionRecord record;
+    uint32_t headSector = 0;
+    uint32_t headSeq = 0;
+    bool isFound = false;
+    for (uint32_t sector = 0; sector < _partition->size; sector += DETECTION_LOG_SECTOR)
+    {
+        if (readRecord(sector, &record) && record.isValid() && (!isFound || record.seq > headSeq))
+        {
+            headSector = sector;
+            headSeq = record.seq;
+            isFound = true;
+        }
+    }
+
+    // then the head is right after the last written record of that sector; a torn record
+    // (power lost while writing) is skipped, as its bytes are not erased any more
+    _head = headSector;
+    if (isFound)
+    {
+        _nextSeq = headSeq + 1;
+        for (uint32_t offset = headSector; offset < headSector + DETECTION_LOG_SECTOR; offset += DETECTION_RECORD_SIZE)
+        {
+            if (!readRecord(offset, &record) || record.isErased())
+            {
+                break;
+            }
+            if (record.isValid() && record.seq >= _nextSeq)
+            {
+                _nextSeq = record.seq + 1;
+            }
+            _head = offset + DETECTION_RECORD_SIZE;
+        }
+        _head %= _partition->size;
+    }
+    return true;
+}
+
+bool DetectionLog::append(DetectionRecord &record)
+{
+    if (!_partition || isBatchFull())
+    {
+        _droppedCount++;
+        return false;
+    }
+
+    record.seq = _nextSeq++;
+    record.seal();
+    _batch[_batchCount++] = record;
+    return true;
+}
+
+bool DetectionLog::flush(void)
+{
+    if (!_partition || _batchCount == 0)
+    {
+        return true;
+    }
+
+    bool isOk = true;
+    for (int i = 0; i < _batchCount && isOk;)
+    {
+        if (_head % DETECTION_LOG_SECTOR == 0)
+        {
+            isOk = esp_partition_erase_range(_partition, _head, DETECTION_LOG_SECTOR) == ESP_OK;
+            _eraseCount++;
+        }
+
+        // write as many records as fit in the current sector in one go
+        int count = (DETECTION_LOG_SECTOR - _head % DETECTION_LOG_SECTOR) / DETECTION_RECORD_SIZE;
+        if (count > _batchCount - i)
+        {
+            count = _batchCount - i;
+        }
+        isOk = isOk && esp_partition_write(_partition, _head, &_batch[i], count * DETECTION_RECORD_SIZE) == ESP_OK;
+        _head = (_head + count * DETECTION_RECORD_SIZE) % _partition->size;
+        i += count;
+    }
+
+    if (!isOk)
+    {
+        _droppedCount += _batchCount;
+    }
+    _batchCount = 0;
+    _flushCount++;
+    return isOk;
+}
+
+bool DetectionLog::readRecord(uint32_t offset, DetectionRecord *record) const
+{
+    return esp_partition_read(_partition, offset, record, sizeof(DetectionRecord)) == ESP_OK;
+}
@@ -0,0 +1,99 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <esp_partition.h>
+#include "./DetectionRecord.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Append-only ring log of DetectionRecord in the "detlog" flash partition (partitions.csv)
+//   append() only copies the record into a RAM batch; the batch is written to flash by
+//   flush() when the NPU goes idle, so the hot path never waits on flash. A record which
+//   finds the batch full is dropped and counted (droppedCount()).
+//   A sector is erased right before its first record is written, so the oldest sector
+//   is dropped when the log wraps. begin() recovers the head from the highest seq.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define DETECTION_LOG_PARTITION "detlog"
+#define DETECTION_LOG_SUBTYPE 0x40 // custom data subtype
+#define DETECTION_LOG_SECTOR 4096  // flash erase unit
+#define DETECTION_LOG_BATCH 8      // records per flash write
+
+class DetectionLog
+{
+public:
+    DetectionLog();
+
+    // find the partition and the head; return false if there is no partition
+    bool begin(void);
+
+    // return false if the batch is full (flush() not called) or the log is not ready
+    bool append(DetectionRecord &record);
+    bool isBatchFull(void) const
+    {
+        return _batchCount >= DETECTION_LOG_BATCH;
+    }
+
+    // write the pending batch to flash; return false on flash error
+    bool flush(void);
+
+    bool isReady(void) const
+    {
+        return _partition != nullptr;
+    }
+    uint32_t capacity(void) const
+    {
+        return _partition ? _partition->size / DETECTION_RECORD_SIZE : 0;
+    }
+    uint32_t head(void) const
+    {
+        return _head;
+    }
+    uint32_t nextSeq(void) const
+    {
+        return _nextSeq;
+    }
+    uint8_t pending(void) const
+    {
+        return _batchCount;
+    }
+    uint32_t droppedCount(void) const
+    {
+        return _droppedCount;
+    }
+    uint32_t flushCount(void) const
+    {
+        return _flushCount;
+    }
+    uint32_t eraseCount(void) const
+    {
+        return _eraseCount;
+    }
+
+private:
+    const esp_partition_t *_partition;
+    uint32_t _head; // byte offset of the next record in the partition
+    uint32_t _nextSeq;
+    DetectionRecord _batch[DETECTION_LOG_BATCH];
+    uint8_t _batchCount;
+    uint32_t _droppedCount;
+    uint32_t _flushCount;
+    uint32_t _eraseCount;
+
+    bool readRecord(uint32_t offset, DetectionRecord *record) const;
+};
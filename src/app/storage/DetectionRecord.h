@@ -0,0 +1,83 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Detection record of DetectionLog, 32 bytes, little endian as stored in flash
+// Shared with tools/detlog, the Linux reader of a dumped partition image
+// An erased record reads all 0xff, i.e. seq == DETECTION_SEQ_ERASED
+////////////////////////////////////////////////////////////////////////////////////////////
+#define DETECTION_RECORD_SIZE 32
+#define DETECTION_SEQ_ERASED 0xffffffffUL
+
+struct __attribute__((packed)) DetectionRecord
+{
+    uint32_t seq;         // record number since the log is created, never wraps in practice
+    uint32_t timeMs;      // millis() at the decision
+    uint16_t frameSeq;    // NpuFrame sequence
+    int8_t decision;      // IpcParam, IpcNpuStrangerDetected or IpcNpuTenderDetected
+    uint8_t target;       // class id
+    uint8_t score;        // score of the box which decided the track
+    uint8_t trackId;      // NpuTracker track id
+    uint8_t boxCount;     // boxes in the frame
+    uint16_t x;           // box center, in pixel of the model input
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t inferenceMs; // invoke() round trip of the frame
+    uint8_t reserved[5];  // 0xff
+    uint16_t crc;         // CRC-16/CCITT of the bytes above
+
+    void seal(void)
+    {
+        memset(reserved, 0xff, sizeof(reserved));
+        crc = crcOf(this, offsetof(DetectionRecord, crc));
+    }
+
+    bool isErased(void) const
+    {
+        return seq == DETECTION_SEQ_ERASED;
+    }
+
+    bool isValid(void) const
+    {
+        return !isErased() && crc == crcOf(this, offsetof(DetectionRecord, crc));
+    }
+
+    static uint16_t crcOf(const void *data, size_t length)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        uint16_t crc = 0xffff;
+        while (length--)
+        {
+            crc ^= (uint16_t)(*p++) << 8;
+            for (int i = 0; i < 8; i++)
+            {
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+        }
+        return crc;
+    }
+};
+
+static_assert(sizeof(DetectionRecord) == DETECTION_RECORD_SIZE, "DetectionRecord must be 32 bytes");
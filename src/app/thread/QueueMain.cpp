@@ -20,17 +20,14 @@
 #include "./QueueMain.h"
 #include "../AppContext.h"
 #include "../AppDef.h"
-
-////////////////////////////////////////////////////////////////////////////////////////////
-#define NO_OBJECT_COUNT 10 // (number of seconds) x (timer frequency): e.g. 5 seconds x 2 Hz = 10
+#include "../npu/NpuFrame.h"
+#include "../util/EventDispatch.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 //
 ////////////////////////////////////////////////////////////////////////////////////////////
-#define TASK_QUEUE_SIZE 2048 // message queue size for app task
-
-#define LOW_POWER_COUNT 5       // in unit of seconds
-#define NO_OBJECT_COUNT (5 * 2) // (expiry seconds) x (timer frequency)
+#define TASK_QUEUE_SIZE 2048 // message queue size for app task, bulk lane
+#define URGENT_QUEUE_SIZE 32 // urgent lane: GPIO edges, debounce ticks, buttons, 1Hz timer
 
 namespace freertos
 {
@@ -40,44 +37,45 @@ namespace freertos
     ////////////////////////////////////////////////////////////////////////////////////////////
     static uint8_t ucQueueStorageArea[TASK_QUEUE_SIZE * sizeof(Message)];
     static StaticQueue_t xStaticQueue;
+    static uint8_t ucUrgentQueueStorageArea[URGENT_QUEUE_SIZE * sizeof(Message)];
+    static StaticQueue_t xUrgentStaticQueue;
 
     /////////////////////////////////////////////////////////////////////////////
     QueueMain::QueueMain() : ardufreertos::MessageBus(TASK_QUEUE_SIZE, ucQueueStorageArea, &xStaticQueue),
                              _isInternetConnected(false),
                              _isMessageSending(false),
-                             _idleCount(0),
-                             _noObjCount(0),
                              _lastNpuResult(IpcNpuNoObjectDetected),
+                             _pendingAlert(IpcNull),
                              _isNpuRunning(false),
-                             _debounceTimer(queue(), EventSystem, SysSoftwareTimer),
-                             _buttonBoot(queue()),
+                             _session(0),
+                             _sessionOriginMs(0),
+                             _urgentLane(xQueueCreateStatic(URGENT_QUEUE_SIZE, sizeof(Message), ucUrgentQueueStorageArea, &xUrgentStaticQueue)),
+                             _laneSet(xQueueCreateSet(TASK_QUEUE_SIZE + URGENT_QUEUE_SIZE)),
+                             _lanePolicy(),
+                             _coalescer(),
+                             _urgentStats("main.urgent", _urgentLane.queue(), URGENT_QUEUE_SIZE),
+                             _bulkStats("main.bulk", queue(), TASK_QUEUE_SIZE),
+                             _profile("QueueMain", getArduinoLoopTaskStackSize()),
+                             _edgeRing(_urgentLane.queue()),
+                             _debounceTimer(&_urgentLane),
+                             _buttonBoot(_urgentLane.queue(), &_edgeRing),
                              _pirInt(),
-                             _timer1Hz("Timer 1Hz",
-                                       pdMS_TO_TICKS(1000),
-                                       [](TimerHandle_t xTimer)
-                                       {
-                                           if (_instance)
-                                           {
-                                               auto context = reinterpret_cast<AppContext *>(_instance->context());
-                                               if (context && context->queueMain)
-                                               {
-                                                   static_cast<freertos::QueueMain *>(context->queueMain)->postEvent(EventSystem, SysSoftwareTimer, 0, (uint32_t)xTimer);
-                                               }
-                                           }
-                                       }),
-
-                             handlerMap()
+                             _timer1Hz("Timer 1Hz", &_urgentLane, 1000),
+                             _power(),
+                             _console(&Serial)
     {
         _instance = this;
 
-        handlerMap = {
-            __EVENT_MAP(QueueMain, EventIpc),
-            __EVENT_MAP(QueueMain, EventMessageStatus),
-            __EVENT_MAP(QueueMain, EventInternetStatus),
-            __EVENT_MAP(QueueMain, EventGpioISR),
-            __EVENT_MAP(QueueMain, EventSystem),
-            __EVENT_MAP(QueueMain, EventNull), // {EventNull, &QueueMain::handlerEventNull},
-        };
+        // frames repeating the decision of a pending frame (IpcNpuNoObjectDetected during the
+        // idle countdown) are merged into it, the newest scores win; so are 1Hz ticks
+        _coalescer.addRule(EventNpuFrame, COALESCE_ANY_PARAM, CoalesceByEvent);
+        _coalescer.addRule(EventSystem, SysSoftwareTimer, CoalesceByLParam);
+        _urgentStats.attach(&_coalescer);
+        _bulkStats.attach(&_coalescer);
+
+        // both lanes are empty yet, as xQueueAddToSet() requires
+        xQueueAddToSet(queue(), _laneSet);
+        xQueueAddToSet(_urgentLane.queue(), _laneSet);
     }
 
     void QueueMain::start(void *ctx)
@@ -94,66 +92,134 @@ namespace freertos
         _debounceTimer.attachButton(&_buttonBoot);
 
         LOG_TRACE("_pirInt.enableInterrupt()");
-        _pirInt.enableInterrupt(this);
+        _pirInt.enableInterrupt(&_edgeRing);
+
+        // edge interrupts as PirInt and ButtonBoot attach them
+        _power.addWakeGpio(_pirInt.getPin(), HIGH, GPIO_INTR_POSEDGE);
+        _power.addWakeGpio(_buttonBoot.getPin(), _buttonBoot.getActiveState(), GPIO_INTR_ANYEDGE);
+        _power.begin();
     }
 
-    void QueueMain::onMessage(const Message &msg)
+    void QueueMain::messageLoop(uint32_t ms)
     {
-        auto func = handlerMap[msg.event];
-        if (func)
+        receive(pdMS_TO_TICKS(ms));
+    }
+
+    void QueueMain::messageLoopForever(void)
+    {
+        for (;;)
         {
-            (this->*func)(msg);
+            receive(portMAX_DELAY);
         }
-        else
+    }
+
+    // The set holds one entry per message in either lane. Each entry taken from the set is
+    // paired with exactly one message received, from the lane LanePolicy picks rather than
+    // from the lane the entry names, so the set and the lanes stay in step.
+    void QueueMain::receive(TickType_t ticks)
+    {
+        if (!xQueueSelectFromSet(_laneSet, ticks))
+        {
+            return;
+        }
+
+        MessageLane lane = _lanePolicy.next(uxQueueMessagesWaiting(_urgentLane.queue()) > 0, uxQueueMessagesWaiting(queue()) > 0);
+        Message msg;
+        if (lane != LaneCount && xQueueReceive(lane == LaneUrgent ? _urgentLane.queue() : queue(), &msg, 0) == pdPASS)
         {
-            LOG_TRACE("Unsupported event=", msg.event, ", iParam=", msg.iParam, ", uParam=", msg.uParam, ", lParam=", msg.lParam);
+            (lane == LaneUrgent ? _urgentStats : _bulkStats).onReceive(msg);
+            _coalescer.onReceive(msg);
+            onMessage(msg);
         }
     }
 
+    void QueueMain::onMessage(const Message &msg)
+    {
+        typedef EventDispatch<QueueMain, &QueueMain::handlerUnsupported,
+                              __EVENT_ENTRY(QueueMain, EventIpc),
+                              __EVENT_ENTRY(QueueMain, EventNpuFrame),
+                              __EVENT_ENTRY(QueueMain, EventMessageStatus),
+                              __EVENT_ENTRY(QueueMain, EventInternetStatus),
+                              __EVENT_ENTRY(QueueMain, EventGpioISR),
+                              __EVENT_ENTRY(QueueMain, EventGpioRing),
+                              __EVENT_ENTRY(QueueMain, EventSystem),
+                              __EVENT_ENTRY(QueueMain, EventNull)>
+            Dispatch;
+        _profile.begin(msg.event);
+        Trace::start(msg);
+        Dispatch::dispatch(*this, msg);
+        Trace::end(msg);
+        _profile.end();
+    }
+
+    // default handler of Dispatch: the event has no entry in the table
+    void QueueMain::handlerUnsupported(const Message &msg)
+    {
+        LOG_TRACE("Unsupported event=", msg.event, ", iParam=", msg.iParam, ", uParam=", msg.uParam, ", lParam=", msg.lParam);
+    }
+
     /////////////////////////////////////////////////////////////////////////////
     __EVENT_FUNC_DEFINITION(QueueMain, EventIpc, msg) // void QueueMain::handlerEventIpc(const Message &msg)
     {
         // LOG_TRACE("EventIpc(", msg.event, "), iParam = ", msg.iParam, ", uParam = ", msg.uParam, ", lParam = ", msg.lParam);
         switch (msg.iParam)
         {
-        case IpcNpuNoObjectDetected:
-        case IpcNpuObjectUnclassified:
-            LOG_TRACE(msg.iParam == IpcNpuNoObjectDetected ? "IpcNpuNoObjectDetected" : "IpcNpuObjectUnclassified");
-            if (_noObjCount++ >= NO_OBJECT_COUNT && !_pirInt.isActive())
+        case IpcNpuIdle:
+        {
+            // NpuScheduler in ThreadNpu has backed off to stop
+            auto appCtx = static_cast<AppContext *>(context());
+            if (_pirInt.isActive())
             {
+                LOG_TRACE("IpcNpuIdle, PIR still active: restart NPU");
+                // a new session from now: the visitor has not been seen for the whole back-off
+                _session++;
+                _sessionOriginMs = millis();
+                QueueStats::post(appCtx->threadNpu, EventIpc, IpcNpuStart, _session, _sessionOriginMs);
+            }
+            else
+            {
+                LOG_TRACE("IpcNpuIdle");
                 _isNpuRunning = false;
-
-                auto appCtx = static_cast<AppContext *>(context());
-                postEvent(appCtx->threadNpu, EventIpc, IpcNpuStop);
-                _noObjCount = 0;
-                _lastNpuResult = msg.iParam;
+                QueueStats::post(appCtx->threadNpu, EventIpc, IpcNpuStop);
+                _lastNpuResult = IpcNpuNoObjectDetected;
 
                 LOG_TRACE("_pirInt.enableInterrupt()");
-                _pirInt.enableInterrupt(this);
+                _pirInt.enableInterrupt(&_edgeRing);
             }
             break;
+        }
+        default:
+            LOG_TRACE("unsupported iParam: ", msg.iParam);
+            break;
+        }
+    }
+    __EVENT_FUNC_DEFINITION(QueueMain, EventNpuFrame, msg) // void QueueMain::handlerEventNpuFrame(const Message &msg)
+    {
+        // one summary per inference, whatever the number of boxes in the frame
+        NpuFrame frame = NpuFrame::unpack(msg.iParam, msg.uParam, msg.lParam);
+        // LOG_TRACE("EventNpuFrame: seq=", frame.seq, ", boxes=", frame.boxCount, ", tenant=", frame.tenantScore, ", stranger=", frame.strangerScore, ", ms=", frame.inferenceMs);
+        switch (frame.decision)
+        {
+        case IpcNpuNoObjectDetected:
+        case IpcNpuObjectUnclassified:
+            LOG_TRACE(frame.decision == IpcNpuNoObjectDetected ? "IpcNpuNoObjectDetected" : "IpcNpuObjectUnclassified", ", seq=", frame.seq, ", boxes=", frame.boxCount);
+            break;
         case IpcNpuStrangerDetected:
             LOG_TRACE("IpcNpuStrangerDetected, _lastNpuResult=", _lastNpuResult);
-            _noObjCount = 0;
-            if (!_isMessageSending && _lastNpuResult != IpcNpuStrangerDetected)
+            if (_lastNpuResult != IpcNpuStrangerDetected)
             {
-                _lastNpuResult = IpcNpuStrangerDetected;
-                auto appCtx = static_cast<AppContext *>(context());
-                postEvent(appCtx->threadMessaging, EventSendMessage, IpcNpuStrangerDetected);
+                sendAlert(IpcNpuStrangerDetected);
             }
             break;
         case IpcNpuTenderDetected:
             LOG_TRACE("IpcNpuTenderDetected, _lastNpuResult=", _lastNpuResult);
-            _noObjCount = 0;
-            if (!_isMessageSending && _lastNpuResult != IpcNpuTenderDetected)
+            if (_lastNpuResult != IpcNpuTenderDetected)
             {
-                _lastNpuResult = IpcNpuTenderDetected;
-                auto appCtx = static_cast<AppContext *>(context());
-                postEvent(appCtx->threadMessaging, EventSendMessage, IpcNpuTenderDetected);
+                sendAlert(IpcNpuTenderDetected);
             }
             break;
         default:
-            LOG_TRACE("unsupported iParam: ", msg.iParam);
+            LOG_TRACE("unsupported decision: ", frame.decision);
             break;
         }
     }
@@ -166,17 +232,16 @@ namespace freertos
         case MessageStatus::Sending:
             LOG_WARN("MessageStatus::Sending");
             _isMessageSending = true;
-            _idleCount = 0;
             break;
 
         case MessageStatus::SentSuccess:
-            LOG_WARN("MessageStatus::SentSuccess");
+            LOG_WARN("MessageStatus::SentSuccess, session=", msg.uParam);
             _isMessageSending = false;
             break;
 
         case MessageStatus::SentFail:
             _isMessageSending = false;
-            LOG_WARN("MessageStatus::SentFail");
+            LOG_WARN("MessageStatus::SentFail, session=", msg.uParam);
             break;
 
         default:
@@ -184,6 +249,47 @@ namespace freertos
             _isMessageSending = false;
             break;
         }
+
+        if (!_isMessageSending && _pendingAlert != IpcNull)
+        {
+            IpcParam decision = _pendingAlert;
+            _pendingAlert = IpcNull;
+            if (decision != _lastNpuResult)
+            {
+                sendAlert(decision);
+            }
+        }
+    }
+
+    // NpuTracker decides a track once, so a decision which comes while a message is being
+    // sent is held, not dropped, and sent on its EventMessageStatus. One pending alert at
+    // most, a stranger is not overwritten by a tenant
+    void QueueMain::sendAlert(IpcParam decision)
+    {
+        if (_isMessageSending)
+        {
+            if (_pendingAlert != IpcNpuStrangerDetected)
+            {
+                _pendingAlert = decision;
+            }
+            LOG_TRACE("message being sent, alert pending: ", decision);
+            return;
+        }
+
+        auto appCtx = static_cast<AppContext *>(context());
+        AlertLatency::mark(_session, _sessionOriginMs, AlertLatency::Decision);
+        if (!QueueStats::post(appCtx->threadMessaging, EventSendMessage, decision, _session, _sessionOriginMs))
+        {
+            return;
+        }
+        // sending from now: a decision in the next frames must not post a second message
+        // before ThreadMessaging reports MessageStatus::Sending
+        _isMessageSending = true;
+        _lastNpuResult = decision;
+        if (decision == IpcNpuStrangerDetected)
+        {
+            QueueStats::post(appCtx->threadNpu, EventIpc, IpcNpuSnapshot);
+        }
     }
     __EVENT_FUNC_DEFINITION(QueueMain, EventInternetStatus, msg) // void QueueMain::handlerEventInternetStatus(const Message &msg)
     {
@@ -195,9 +301,31 @@ namespace freertos
     __EVENT_FUNC_DEFINITION(QueueMain, EventGpioISR, msg) // void QueueMain::handlerEventGpioISR(const Message &msg)
     {
         // LOG_TRACE("EventGpioISR(", msg.event, "), iParam = ", msg.iParam, ", uParam = ", msg.uParam, ", lParam = ", msg.lParam);
+        GpioEdge edge;
+        edge.ms = msg.lParam;
+        edge.pin = msg.iParam;
+        edge.level = msg.uParam;
+        onGpioEdge(edge);
+    }
+    __EVENT_FUNC_DEFINITION(QueueMain, EventGpioRing, msg) // void QueueMain::handlerEventGpioRing(const Message &msg)
+    {
+        // every edge since the ISRs posted this message, in one pass
+        _edgeRing.beginDrain();
+        GpioEdge edge;
+        uint16_t batch = 0;
+        while (_edgeRing.pop(&edge))
+        {
+            onGpioEdge(edge);
+            batch++;
+        }
+        _edgeRing.endDrain(batch);
+    }
 
-        uint8_t pin = msg.iParam;
-        uint8_t value = msg.uParam;
+    void QueueMain::onGpioEdge(const GpioEdge &edge)
+    {
+        uint8_t pin = edge.pin;
+        uint8_t value = edge.level;
+        _power.keepAwake();
         if (pin == _pirInt.getPin())
         {
             if (_isNpuRunning)
@@ -209,13 +337,16 @@ namespace freertos
             LOG_TRACE("_pirInt.disableInterrupt()");
             _pirInt.disableInterrupt();
 
+            // the ISR time of the edge; from light sleep, the ISR runs after the chip woke up,
+            // so the wake-up is not part of the latency
+            _session++;
+            _sessionOriginMs = edge.ms;
             auto appCtx = static_cast<AppContext *>(context());
-            postEvent(appCtx->threadNpu, EventIpc, IpcNpuStart);
+            QueueStats::post(appCtx->threadNpu, EventIpc, IpcNpuStart, _session, _sessionOriginMs);
         }
         else if (pin == _buttonBoot.getPin())
         {
-            uint32_t ms = msg.lParam;
-            _buttonBoot.onEventIsr(value, ms);
+            _buttonBoot.onEventIsr(value, edge.ms);
         }
         else
         {
@@ -230,7 +361,7 @@ namespace freertos
         switch (src)
         {
         case SysSoftwareTimer:
-            handlerSoftwareTimer((TimerHandle_t)(msg.lParam));
+            handlerSoftwareTimer(msg.lParam);
             break;
         case SysButtonClick:
         {
@@ -260,36 +391,129 @@ namespace freertos
     }
     /////////////////////////////////////////////////////////////////////////////
 
-    void QueueMain::handlerSoftwareTimer(TimerHandle_t xTimer)
+    void QueueMain::handlerSoftwareTimer(uint32_t timerId)
     {
-        if (xTimer == _debounceTimer.timer())
+        if (timerId == _debounceTimer.id())
         {
             // LOG_TRACE("debounceTimer::timer()");
             _debounceTimer.onEventTimer();
         }
-        else if (xTimer == _timer1Hz.timer())
+        else if (timerId == _timer1Hz.id())
         {
             // LOG_TRACE("_timer1Hz");
             // LOG_TRACE("_pirInt.read() retutns ", _pirInt.read());
+            bool isInput = pollConsole();
+            TaskProfile::onTick();
 
-            if (_isInternetConnected &&
-                !_isMessageSending &&
-                !_pirInt.isActive() &&
-                (_idleCount++ >= LOW_POWER_COUNT))
-            {
-                _idleCount = 0;
-            }
-            else
-            {
-                // LOG_TRACE("_idleCount=", _idleCount);
-            }
+            _power.onIdleTick(!isInput && isIdle());
         }
         else
         {
-            LOG_TRACE("unsupported timer handle=0x%04x", (uint32_t)(xTimer));
+            LOG_TRACE("unsupported timer id=", timerId);
         }
     }
 
+    // no job in flight in any thread
+    bool QueueMain::isIdle(void)
+    {
+        return _isInternetConnected &&
+               !_isMessageSending &&
+               !_isNpuRunning &&
+               !_pirInt.isActive() &&
+               !_buttonBoot.isDebounceActive();
+    }
+
+    bool QueueMain::pollConsole(void)
+    {
+        bool isInput = false;
+        ConsoleLine line;
+        while (_console.read(&line))
+        {
+            isInput = true;
+            auto appCtx = static_cast<AppContext *>(context());
+            switch (line.command)
+            {
+            case ConsoleHelp:
+                Console::printHelp();
+                break;
+            case ConsoleBusLanes:
+                printLanes();
+                break;
+            case ConsoleQueueReport:
+                QueueStats::report();
+                break;
+            case ConsoleTimerReport:
+                TimerService::instance().report();
+                break;
+            case ConsolePowerReport:
+                if (line.argc > 0)
+                {
+                    _power.setEnabled(line.argv[0] != 0);
+                }
+                _power.report();
+                break;
+            case ConsoleTaskReport:
+                if (line.argc > 0 && line.argv[0] == 1)
+                {
+                    TaskProfile::reset();
+                }
+                TaskProfile::report();
+                break;
+            case ConsoleAlertLatency:
+                if (line.argc > 0 && line.argv[0] == 1)
+                {
+                    AlertLatency::reset();
+                }
+                AlertLatency::report();
+                break;
+            case ConsoleTrace:
+                if (line.argc > 0 && line.argv[0] == 3)
+                {
+                    // over HTTP, by the thread which owns the network
+                    QueueStats::post(appCtx->threadMessaging, EventSystem, SysConsoleCommand, line.command, line.pack());
+                    break;
+                }
+                if (line.argc > 0 && line.argv[0] == 2)
+                {
+                    TraceHexWriter writer(Serial);
+                    Trace::dump(writer);
+                    writer.finish();
+                    break;
+                }
+                if (line.argc > 0)
+                {
+                    Trace::setEnabled(line.argv[0] != 0);
+                }
+                Trace::report();
+                break;
+            case ConsoleNpuPerf:
+            case ConsoleNpuZone:
+            case ConsoleNpuThreshold:
+            case ConsoleNpuRole:
+            case ConsoleNpuSnapshot:
+            case ConsoleNpuCascade:
+            case ConsoleNpuLog:
+            case ConsoleNpuBench:
+                QueueStats::post(appCtx->threadNpu, EventSystem, SysConsoleCommand, line.command, line.pack());
+                break;
+            default:
+                LOG_TRACE("unsupported ConsoleCommand=", line.command);
+                break;
+            }
+        }
+        return isInput;
+    }
+
+    void QueueMain::printLanes(void)
+    {
+        const LanePolicy::Stats &stats = _lanePolicy.stats();
+        PRINTLN("urgent: served=", stats.served[LaneUrgent], ", pending=", uxQueueMessagesWaiting(_urgentLane.queue()), "/", URGENT_QUEUE_SIZE);
+        PRINTLN("bulk: served=", stats.served[LaneBulk], ", pending=", uxQueueMessagesWaiting(queue()), "/", TASK_QUEUE_SIZE);
+        PRINTLN("bulk starved=", stats.bulkStarved, ", forced=", stats.bulkForced, ", longest urgent run=", stats.maxUrgentRun);
+        PRINTLN("gpio edges=", _edgeRing.edges(), ", drains=", _edgeRing.drains(), ", largest drain=", _edgeRing.maxBatch(),
+                ", overflows=", _edgeRing.overflows(), " (ring of ", GPIO_EDGE_RING_SIZE, ")");
+    }
+
     void QueueMain::debounce(uint32_t start, uint32_t ms)
     {
         // simple debounce
@@ -18,12 +18,19 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #pragma once
-#include <map>
 #include "../ArduProfFreeRTOS.h"
 #include "../AppEvent.h"
 #include "../driver/peripheral/ButtonBoot.h"
 #include "../driver/peripheral/button/DebounceTimer.h"
+#include "../driver/peripheral/gpio/GpioEdgeRing.h"
 #include "../driver/peripheral/gpio/PirInt.h"
+#include "../driver/power/PowerManager.h"
+#include "../util/AlertLatency.h"
+#include "../util/Console.h"
+#include "../util/MessageLanes.h"
+#include "../util/QueueStats.h"
+#include "../util/TaskProfile.h"
+#include "../util/TimerService.h"
 
 namespace freertos
 {
@@ -35,29 +42,49 @@ namespace freertos
         virtual void start(void *);
         virtual void onMessage(const Message &msg) override;
 
-        static void printChipInfo(void);
+        // in place of MessageBus::messageLoop(), serve the urgent lane first, see MessageLanes.h
+        void messageLoop(uint32_t ms);
+        void messageLoopForever(void);
 
-    protected:
-        typedef void (QueueMain::*funcPtr)(const Message &);
-        std::map<int16_t, funcPtr> handlerMap;
+        static void printChipInfo(void);
 
     private:
         static QueueMain *_instance;
 
         bool _isInternetConnected;
         bool _isMessageSending;
-        uint32_t _idleCount;
-        uint32_t _noObjCount;
         int16_t _lastNpuResult;
+        IpcParam _pendingAlert; // decision held while a message is being sent, IpcNull = none
         bool _isNpuRunning;
+        uint16_t _session;         // NPU session, see AlertLatency
+        uint32_t _sessionOriginMs; // PIR edge which started it
 
+        // urgent lane; the queue of MessageBus is the bulk lane, where the other threads post
+        ardufreertos::MessageQueue _urgentLane;
+        QueueSetHandle_t _laneSet;
+        LanePolicy _lanePolicy;
+        MessageCoalescer _coalescer; // of both lanes
+        QueueStats _urgentStats;
+        QueueStats _bulkStats;
+        TaskProfile _profile; // of loopTask
+
+        GpioEdgeRing _edgeRing; // PIR and BOOT edges, before _buttonBoot which enables its interrupt
         DebounceTimer _debounceTimer;
         ButtonBoot _buttonBoot;
         PirInt _pirInt;
 
-        ardufreertos::PeriodicTimer _timer1Hz;
+        WheelTimer _timer1Hz;
+        PowerManager _power;
+
+        Console _console;
 
-        void handlerSoftwareTimer(TimerHandle_t xTimer);
+        void handlerSoftwareTimer(uint32_t timerId);
+        bool pollConsole(void);
+        bool isIdle(void);
+        void receive(TickType_t ticks);
+        void printLanes(void);
+        void onGpioEdge(const GpioEdge &edge);
+        void sendAlert(IpcParam decision);
 
         void debounce(uint32_t start, uint32_t ms);
 
@@ -69,11 +96,14 @@ namespace freertos
         // declare event handler
         ///////////////////////////////////////////////////////////////////////
         __EVENT_FUNC_DECLARATION(EventIpc)
+        __EVENT_FUNC_DECLARATION(EventNpuFrame)
         __EVENT_FUNC_DECLARATION(EventMessageStatus)
         __EVENT_FUNC_DECLARATION(EventInternetStatus)
         __EVENT_FUNC_DECLARATION(EventGpioISR)
+        __EVENT_FUNC_DECLARATION(EventGpioRing)
         __EVENT_FUNC_DECLARATION(EventSystem)
         __EVENT_FUNC_DECLARATION(EventNull) // void handlerEventNull(const Message &msg);
+        void handlerUnsupported(const Message &msg);
     };
 
 } // namespace freertos
@@ -21,12 +21,17 @@
 #include <UrlEncode.h>
 #include "./ThreadMessaging.h"
 #include "../AppContext.h"
+#include "../util/Console.h"
+#include "../util/EventDispatch.h"
+#include "../util/HttpChunkedWriter.h"
 #include "../../../secret.h"
 
 #define CONNECT_TIMEOUT 30 // in unit of seconds
 
 #define TCP_RX_BUFFER_SIZE 1024
 
+#define TRACE_HTTP_TIMEOUT 5000 // in unit of ms, wait for the HTTP status line of a trace upload
+
 namespace freertos
 {
     ////////////////////////////////////////////////////////////////////////////////////////////
@@ -65,34 +70,22 @@ namespace freertos
     ////////////////////////////////////////////////////////////////////////////////////////////
 
     ThreadMessaging::ThreadMessaging() : ThreadBase(TASK_QUEUE_SIZE, ucQueueStorageArea, &xStaticQueue),
+                                         _queueStats("messaging", queue(), TASK_QUEUE_SIZE),
+                                         _coalescer(),
+                                         _profile(TASK_NAME, TASK_STACK_SIZE),
                                          _wifi(this),
                                          _isInternetReady(false),
+                                         _session(0),
+                                         _sessionOriginMs(0),
+                                         _clientState(Ready),
                                          _tcpClient(),
                                          _isHttpStatusLineReceived(false),
-                                         _clientState(Ready),
-                                         _timer1Hz("Timer 1Hz",
-                                                   pdMS_TO_TICKS(1000),
-                                                   [](TimerHandle_t xTimer)
-                                                   {
-                                                       if (_instance)
-                                                       {
-                                                           auto context = reinterpret_cast<AppContext *>(_instance->context());
-                                                           if (context && context->threadMessaging)
-                                                           {
-                                                               static_cast<freertos::ThreadMessaging *>(context->threadMessaging)->postEvent(EventSystem, SysSoftwareTimer, 0, (uint32_t)xTimer);
-                                                           }
-                                                       }
-                                                   }),
-                                         handlerMap()
+                                         _timer1Hz("Timer 1Hz", this, 1000)
     {
         _instance = this;
 
-        handlerMap = {
-            __EVENT_MAP(ThreadMessaging, EventSystem),
-            __EVENT_MAP(ThreadMessaging, EventSendMessage),
-            __EVENT_MAP(ThreadMessaging, EventWifiStatus),
-            __EVENT_MAP(ThreadMessaging, EventNull), // {EventNull, &ThreadMessaging::handlerEventNull},
-        };
+        _coalescer.addRule(EventSystem, SysSoftwareTimer, CoalesceByLParam);
+        _queueStats.attach(&_coalescer);
     }
 
     __EVENT_FUNC_DEFINITION(ThreadMessaging, EventSendMessage, msg) // void ThreadMessaging::handlerEventSendMessage(const Message &msg)
@@ -105,14 +98,17 @@ namespace freertos
             return;
         }
 
+        _session = msg.uParam;
+        _sessionOriginMs = msg.lParam;
         if (_isInternetReady)
         {
-            postEvent(appCtx->queueMain, EventMessageStatus, MessageStatus::Sending);
+            QueueStats::post(appCtx->queueMain, EventMessageStatus, MessageStatus::Sending, _session, _sessionOriginMs);
             sendWhatsapp(msg.iParam == IpcNpuTenderDetected ? "doorbell: tenant" : "doorbell: alert - stranger!");
         }
         else
         {
-            postEvent(appCtx->queueMain, EventMessageStatus, MessageStatus::SentFail);
+            AlertLatency::fail(_session, _sessionOriginMs);
+            QueueStats::post(appCtx->queueMain, EventMessageStatus, MessageStatus::SentFail, _session, _sessionOriginMs);
         }
     }
 
@@ -155,7 +151,7 @@ namespace freertos
             auto appCtx = static_cast<AppContext *>(context());
             if (appCtx && appCtx->queueMain)
             {
-                appCtx->queueMain->postEvent(EventInternetStatus, InternetStatus::Connect);
+                QueueStats::post(appCtx->queueMain, EventInternetStatus, InternetStatus::Connect);
             }
             break;
         }
@@ -166,7 +162,7 @@ namespace freertos
             auto appCtx = static_cast<AppContext *>(context());
             if (appCtx && appCtx->queueMain)
             {
-                appCtx->queueMain->postEvent(EventInternetStatus, InternetStatus::Disconnect);
+                QueueStats::post(appCtx->queueMain, EventInternetStatus, InternetStatus::Disconnect);
             }
             break;
         }
@@ -219,7 +215,10 @@ namespace freertos
         switch (src)
         {
         case SysSoftwareTimer:
-            handlerSoftwareTimer((TimerHandle_t)(msg.lParam));
+            handlerSoftwareTimer(msg.lParam);
+            break;
+        case SysConsoleCommand:
+            handlerConsoleCommand(msg);
             break;
         default:
             LOG_TRACE("unsupported SystemTriggerSource=", src);
@@ -235,15 +234,26 @@ namespace freertos
     void ThreadMessaging::onMessage(const Message &msg)
     {
         // LOG_DEBUG("event=", msg.event, ", iParam=", msg.iParam, ", uParam=", msg.uParam, ", lParam=", msg.lParam);
-        auto func = handlerMap[msg.event];
-        if (func)
-        {
-            (this->*func)(msg);
-        }
-        else
-        {
-            LOG_DEBUG("Unsupported event = ", msg.event, ", iParam = ", msg.iParam, ", uParam = ", msg.uParam, ", lParam = ", msg.lParam);
-        }
+        _queueStats.onReceive(msg);
+        Message latest = msg;
+        _coalescer.onReceive(latest);
+        typedef EventDispatch<ThreadMessaging, &ThreadMessaging::handlerUnsupported,
+                              __EVENT_ENTRY(ThreadMessaging, EventSystem),
+                              __EVENT_ENTRY(ThreadMessaging, EventSendMessage),
+                              __EVENT_ENTRY(ThreadMessaging, EventWifiStatus),
+                              __EVENT_ENTRY(ThreadMessaging, EventNull)>
+            Dispatch;
+        _profile.begin(latest.event);
+        Trace::start(latest);
+        Dispatch::dispatch(*this, latest);
+        Trace::end(latest);
+        _profile.end();
+    }
+
+    // default handler of Dispatch: the event has no entry in the table
+    void ThreadMessaging::handlerUnsupported(const Message &msg)
+    {
+        LOG_DEBUG("Unsupported event = ", msg.event, ", iParam = ", msg.iParam, ", uParam = ", msg.uParam, ", lParam = ", msg.lParam);
     }
 
     void ThreadMessaging::start(void *ctx)
@@ -298,6 +308,7 @@ namespace freertos
 
             if (_tcpClient.connect(apiHost, apiPort))
             {
+                AlertLatency::mark(_session, _sessionOriginMs, AlertLatency::Connect);
                 LOG_TRACE("connecting to server=", apiHost, ", port=", apiPort);
                 _clientState = Connecting;
                 _connectTimeout = 0;
@@ -307,18 +318,79 @@ namespace freertos
             else
             {
                 LOG_TRACE("Fail to connect server=", apiHost, ", port=", apiPort);
+                responseSendMessage(MessageStatus::SentFail); // QueueMain would wait for a status forever
             }
         }
     }
 
+    void ThreadMessaging::handlerConsoleCommand(const Message &msg)
+    {
+        ConsoleCommand command = static_cast<ConsoleCommand>(msg.uParam);
+        switch (command)
+        {
+        case ConsoleTrace:
+            uploadTrace();
+            break;
+        default:
+            LOG_TRACE("unsupported ConsoleCommand=", command);
+            break;
+        }
+    }
+
+    // blocks the thread until the server answers; the records stop meanwhile, see Trace::dump()
+    void ThreadMessaging::uploadTrace(void)
+    {
+        if (!_isInternetReady || _clientState != Ready)
+        {
+            PRINTLN("trace upload skipped: ", _isInternetReady ? "a message is being sent" : "no internet");
+            return;
+        }
+        if (!_tcpClient.connect(SNAPSHOT_HOST, SNAPSHOT_PORT))
+        {
+            PRINTLN("trace upload skipped: fail to connect server=", SNAPSHOT_HOST, ", port=", SNAPSHOT_PORT);
+            return;
+        }
+
+        _tcpClient.print("POST ");
+        _tcpClient.print(TRACE_PATH);
+        _tcpClient.println(" HTTP/1.1");
+        _tcpClient.print("Host: ");
+        _tcpClient.println(SNAPSHOT_HOST);
+        _tcpClient.println("Content-Type: application/octet-stream");
+        _tcpClient.println("Transfer-Encoding: chunked");
+        _tcpClient.println("Connection: close");
+        _tcpClient.println();
+
+        HttpChunkedWriter<WiFiClient> writer(_tcpClient);
+        int status = 0;
+        if (Trace::dump(writer) && writer.finish())
+        {
+            char line[32];
+            _tcpClient.setTimeout(TRACE_HTTP_TIMEOUT);
+            size_t n = _tcpClient.readBytesUntil('\n', line, sizeof(line) - 1);
+            line[n] = '\0';
+            sscanf(line, "HTTP/%*d.%*d %d", &status);
+        }
+        _tcpClient.stop();
+        PRINTLN("trace upload: ", (status >= 200 && status < 300) ? "ok" : "fail", ", HTTP ", status, ", ", writer.bytes(), " bytes");
+    }
+
     void ThreadMessaging::responseSendMessage(MessageStatus status)
     {
         _timer1Hz.stop();
         _clientState = Ready;
+        if (status == MessageStatus::SentSuccess)
+        {
+            AlertLatency::mark(_session, _sessionOriginMs, AlertLatency::Status);
+        }
+        else
+        {
+            AlertLatency::fail(_session, _sessionOriginMs);
+        }
 
         auto appCtx = static_cast<AppContext *>(context());
         configASSERT(appCtx && appCtx->queueMain);
-        appCtx->queueMain->postEvent(EventMessageStatus, status);
+        QueueStats::post(appCtx->queueMain, EventMessageStatus, status, _session, _sessionOriginMs);
     }
 
     bool ThreadMessaging::readHttpResponse(int *ptrResponseCode)
@@ -330,7 +402,7 @@ namespace freertos
         while (tcpSize > 0)
         {
             // LOG_DEBUG("tcpSize=", tcpSize);
-            if (tcpSize >= sizeof(_shareRxBuf))
+            if ((size_t)tcpSize >= sizeof(_shareRxBuf))
             {
                 tcpSize = sizeof(_shareRxBuf) - 1; // truncate data if oversize
             }
@@ -383,9 +455,9 @@ namespace freertos
         LOG_TRACE("_messageText=", _messageText);
     }
 
-    void ThreadMessaging::handlerSoftwareTimer(TimerHandle_t xTimer)
+    void ThreadMessaging::handlerSoftwareTimer(uint32_t timerId)
     {
-        if (xTimer == _timer1Hz.timer())
+        if (timerId == _timer1Hz.id())
         {
             // LOG_TRACE("_timer1Hz");
             switch (_clientState)
@@ -399,6 +471,7 @@ namespace freertos
                 {
                     LOG_TRACE("Connected server: IP=", _tcpClient.remoteIP(), ", port=", _tcpClient.remotePort());
                     writeText(_messageText);
+                    AlertLatency::mark(_session, _sessionOriginMs, AlertLatency::Written);
                     _clientState = Connected;
                     _connectTimeout = 0;
                 }
@@ -451,7 +524,7 @@ namespace freertos
         }
         else
         {
-            LOG_TRACE("unsupported timer handle=0x%04x", (uint32_t)(xTimer));
+            LOG_TRACE("unsupported timer id=", timerId);
         }
     }
 
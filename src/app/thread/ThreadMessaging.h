@@ -19,10 +19,13 @@
  */
 #pragma once
 #include <WiFi.h>
-#include <map>
 #include "../ArduProfFreeRTOS.h"
 #include "../AppEvent.h"
 #include "../driver/wifi/WifiBase.h"
+#include "../util/AlertLatency.h"
+#include "../util/QueueStats.h"
+#include "../util/TaskProfile.h"
+#include "../util/TimerService.h"
 
 #define MESSAGE_TEXT_SIZE 256
 
@@ -35,20 +38,24 @@ namespace freertos
         virtual void start(void *);
 
     protected:
-        typedef void (ThreadMessaging::*handlerFunc)(const Message &);
-        std::map<int16_t, handlerFunc> handlerMap;
         virtual void onMessage(const Message &msg);
 
         virtual void run(void);
 
     private:
         static ThreadMessaging *_instance;
+
+        QueueStats _queueStats;
+        MessageCoalescer _coalescer;
+        TaskProfile _profile;
         static uint8_t _shareRxBuf[];
 
         TaskHandle_t _taskInitHandle;
         WifiBase _wifi;
         bool _isInternetReady;
         char _messageText[MESSAGE_TEXT_SIZE];
+        uint16_t _session;         // of the message being sent, see AlertLatency
+        uint32_t _sessionOriginMs;
 
         typedef enum _ClientState
         {
@@ -62,12 +69,12 @@ namespace freertos
         WiFiClient _tcpClient;
         bool _isHttpStatusLineReceived;
         uint32_t _connectTimeout;
-        ardufreertos::PeriodicTimer _timer1Hz;
+        WheelTimer _timer1Hz;
 
         virtual void setup(void);
         virtual void delayInit(void);
 
-        void handlerSoftwareTimer(TimerHandle_t xTimer);
+        void handlerSoftwareTimer(uint32_t timerId);
 
         void sendWhatsapp(const char *s);
         void prepareText(const char *s);
@@ -76,6 +83,9 @@ namespace freertos
 
         void responseSendMessage(MessageStatus status);
 
+        void handlerConsoleCommand(const Message &msg);
+        void uploadTrace(void);
+
         ///////////////////////////////////////////////////////////////////////
         // declare event handler
         ///////////////////////////////////////////////////////////////////////
@@ -83,5 +93,6 @@ namespace freertos
         __EVENT_FUNC_DECLARATION(EventWifiStatus)
         __EVENT_FUNC_DECLARATION(EventSystem)
         __EVENT_FUNC_DECLARATION(EventNull) // void handlerEventNull(const Message &msg);
+        void handlerUnsupported(const Message &msg);
     };
 } // namespace freertos
\ No newline at end of file
@@ -17,17 +17,91 @@
  * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <Preferences.h>
+#include <Wire.h>
 #include "./ThreadNpu.h"
 #include "../AppContext.h"
+#include "../AppDef.h"
+#include "../driver/npu/NpuLinkBench.h"
+#include "../util/Console.h"
+#include "../util/EventDispatch.h"
+#include "../util/HttpChunkedWriter.h"
+#include "../../../secret.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////
-#define NO_OBJECT_COUNT 10 // (number of seconds) x (timer frequency): e.g. 5 seconds x 2 Hz = 10
+// NPU trigger mode
+//   NPU_TRIGGER_TIMER:     invoke inference on every tick of _timerInference
+//   NPU_TRIGGER_INTERRUPT: in the burst state, invoke inference back-to-back, paced by the
+//                          WE2 raising npuINT when it has finished a frame, so the detection
+//                          rate follows the NPU's real frame rate
+// In both modes, the slower states of NpuScheduler run on _timerInference
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_TRIGGER_TIMER 0
+#define NPU_TRIGGER_INTERRUPT 1
+#define NPU_TRIGGER_MODE NPU_TRIGGER_TIMER
+
+#define NPU_INT_TIMEOUT 1000 // in unit of ms, re-kick inference if npuINT stays silent
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Region-of-interest zones, in pixel of the model input (NPU_MODEL_INPUT_SIZE square, see NpuModel.h)
+// A rectangle is given by 2 opposite corners, a polygon by its vertices (see NpuZone.h)
+// Set NPU_ZONE_FILTER to 1 after adjusting zoneTable to the camera view
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_ZONE_FILTER 0
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Per-class thresholds (NpuThreshold) persist in NVS, set by the "thr" and "role" console commands
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NVS_NAMESPACE "npu"
+#define NVS_KEY_THRESHOLD "threshold"
+#define NVS_KEY_CASCADE "cascade"
 
 ////////////////////////////////////////////////////////////////////////////////////////////
-#define AI_TARGET_TENANT 0
-#define AI_TARGET_STRANGER 1
+// Two-stage cascade (see NpuCascade.h): SSCMA model ids, as flashed by SenseCraft
+// NPU_MODEL_PRESENCE 0 runs the identity model alone, on the model loaded at boot
+// Both are overridden by the "cascade" console command, saved in NVS
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_MODEL_PRESENCE 0 // small person detector
+#define NPU_MODEL_IDENTITY 1 // tenant/stranger model
 
-#define AI_SCORE_THRESHOLD 60
+////////////////////////////////////////////////////////////////////////////////////////////
+// JPEG snapshot of a stranger, streamed from the WE2 to SNAPSHOT_HOST (see secret.h)
+// The upload blocks ThreadNpu, with no inference meanwhile, for at most NPU_SNAPSHOT_BUDGET:
+// the connect, then the NPU reply, then the HTTP status line in what is left
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_SNAPSHOT_UPLOAD 1             // 0: never upload snapshot
+#define NPU_SNAPSHOT_BUDGET 3000          // in unit of ms, max time of one upload
+#define NPU_SNAPSHOT_CONNECT_TIMEOUT 1000 // in unit of ms, part of the budget
+#define NPU_SNAPSHOT_HTTP_TIMEOUT 500     // in unit of ms, part of the budget kept for the HTTP status line
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// NPU link (I2C) transfer mode of NpuAt/NpuSnapshot, see NpuLink.h
+// The "bench" console command sweeps NPU_BENCH_CLOCKS x NPU_BENCH_CHUNKS, then restores
+// the default clock of SSCMA::begin()
+////////////////////////////////////////////////////////////////////////////////////////////
+#define NPU_LINK_MODE NpuLinkBulk
+#define NPU_LINK_CHUNK NPU_LINK_CHUNK_MAX
+#define NPU_I2C_ADDRESS 0x62    // SSCMA default
+#define NPU_I2C_WAIT_DELAY 2    // in unit of ms, SSCMA default
+#define NPU_BENCH_INVOKES 10    // invoke() round trips per clock
+#define NPU_BENCH_DIRECT_CHUNK NPU_SNAPSHOT_CHUNK // baseline: the reads of NpuSnapshot on a Direct link
+
+static const uint32_t NPU_BENCH_CLOCKS[] = {100000, 400000, 1000000}; // "bench <n>" takes n up to 2, see Console.cpp
+static const int NPU_BENCH_CHUNKS[] = {32, 64, 128, 256, 512, 1024};
+
+#if NPU_ZONE_FILTER
+static const struct
+{
+    NpuZone::Rule rule;
+    uint8_t pointCount;
+    NpuPoint points[NPU_ZONE_POINT_MAX];
+} zoneTable[] = {
+    // street and sidewalk across the top of the image
+    {NpuZone::Exclude, 2, {{0, 0}, {NPU_MODEL_INPUT_SIZE - 1, 47}}},
+    // porch, a trapezoid in perspective
+    {NpuZone::Include, 4, {{24, 48}, {168, 48}, {NPU_MODEL_INPUT_SIZE - 1, NPU_MODEL_INPUT_SIZE - 1}, {0, NPU_MODEL_INPUT_SIZE - 1}}},
+};
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 // Thread
@@ -56,43 +130,47 @@ namespace freertos
     ////////////////////////////////////////////////////////////////////////////////////////////
 
     ThreadNpu::ThreadNpu() : ThreadBase(TASK_QUEUE_SIZE, ucQueueStorageArea, &xStaticQueue),
+                             _queueStats("npu", queue(), TASK_QUEUE_SIZE),
+                             _coalescer(),
+                             _profile(TASK_NAME, TASK_STACK_SIZE),
                              _ai(),
+                             _link(_ai),
                              _isNpuRunning(false),
-                             _timer1Hz("Timer 1Hz",
-                                       pdMS_TO_TICKS(1000),
-                                       [](TimerHandle_t xTimer)
-                                       {
-                                           if (_instance)
-                                           {
-                                               auto context = reinterpret_cast<AppContext *>(_instance->context());
-                                               if (context && context->threadNpu)
-                                               {
-                                                   static_cast<freertos::ThreadNpu *>(context->threadNpu)->postEvent(EventSystem, SysSoftwareTimer, 0, (uint32_t)xTimer);
-                                               }
-                                           }
-                                       }),
-                             _timer2Hz("Timer 2Hz",
-                                       pdMS_TO_TICKS(500),
-                                       [](TimerHandle_t xTimer)
-                                       {
-                                           if (_instance)
-                                           {
-                                               auto context = reinterpret_cast<AppContext *>(_instance->context());
-                                               if (context && context->threadNpu)
-                                               {
-                                                   static_cast<freertos::ThreadNpu *>(context->threadNpu)->postEvent(EventSystem, SysSoftwareTimer, 0, (uint32_t)xTimer);
-                                               }
-                                           }
-                                       }),
-                             handlerMap()
+                             _lastInferenceMs(0),
+                             _frameSeq(0),
+                             _session(0),
+                             _sessionOriginMs(0),
+                             _isSessionFirstFrame(false),
+                             _npuInt(),
+                             _scheduler(),
+                             _pipeline(),
+                             _perf(),
+                             _snapshot(),
+                             _snapshotReport(),
+                             _snapshotClient(),
+                             _models{NPU_MODEL_PRESENCE, NPU_MODEL_IDENTITY},
+                             _loadedModel(0),
+                             _modelSwitchCount(0),
+                             _detectionLog(),
+                             _timerInference("Timer NPU", this, NPU_RATE_BURST_PERIOD),
+                             _timer1Hz("Timer 1Hz", this, 1000)
     {
         _instance = this;
 
-        handlerMap = {
-            __EVENT_MAP(ThreadNpu, EventIpc),
-            __EVENT_MAP(ThreadNpu, EventSystem),
-            __EVENT_MAP(ThreadNpu, EventNull), // {EventNull, &ThreadMessaging::handlerEventNull},
-        };
+        // a tick of a timer still pending is absorbed, an inference slower than the burst
+        // period does not pile inference ticks up
+        _coalescer.addRule(EventSystem, SysSoftwareTimer, CoalesceByLParam);
+        _queueStats.attach(&_coalescer);
+
+#if NPU_ZONE_FILTER
+        for (size_t i = 0; i < dim(zoneTable); i++)
+        {
+            if (!_pipeline.zones().add(zoneTable[i].rule, zoneTable[i].points, zoneTable[i].pointCount))
+            {
+                LOG_ERROR("invalid zoneTable[", i, "]");
+            }
+        }
+#endif
     }
 
     __EVENT_FUNC_DEFINITION(ThreadNpu, EventIpc, msg) // void ThreadNpu::handlerEventIpc(const Message &msg)
@@ -103,17 +181,37 @@ namespace freertos
         {
         case IpcNpuStart:
             LOG_TRACE("IpcNpuStart");
+            _session = msg.uParam;
+            _sessionOriginMs = msg.lParam;
+            _isSessionFirstFrame = true;
+            AlertLatency::mark(_session, _sessionOriginMs, AlertLatency::Wake);
             if (!_isNpuRunning)
             {
                 _isNpuRunning = true;
-                _timer2Hz.start();
+                _scheduler.start();
+                _pipeline.reset();
+                selectModel(_pipeline.cascade().stage());
+#if NPU_TRIGGER_MODE == NPU_TRIGGER_INTERRUPT
+                _npuInt.enableInterrupt(this);
+#endif
+                applySchedule();
+                runInference(); // kick the first frame right away instead of waiting for a tick
             }
             break;
 
         case IpcNpuStop:
             LOG_TRACE("IpcNpuStop");
-            _isNpuRunning = false;
-            _timer2Hz.stop();
+            if (_isNpuRunning)
+            {
+                stopInference();
+            }
+            break;
+
+        case IpcNpuSnapshot:
+            LOG_TRACE("IpcNpuSnapshot");
+#if NPU_SNAPSHOT_UPLOAD
+            uploadSnapshot();
+#endif
             break;
 
         default:
@@ -121,6 +219,22 @@ namespace freertos
             break;
         }
     }
+    __EVENT_FUNC_DEFINITION(ThreadNpu, EventGpioISR, msg) // void ThreadNpu::handlerEventGpioISR(const Message &msg)
+    {
+        // LOG_TRACE("EventGpioISR(", msg.event, "), iParam = ", msg.iParam, ", uParam = ", msg.uParam, ", lParam = ", msg.lParam);
+        uint8_t pin = msg.iParam;
+        if (pin == _npuInt.getPin())
+        {
+            if (_isNpuRunning && _scheduler.state() == NpuScheduler::Burst)
+            {
+                runInference();
+            }
+        }
+        else
+        {
+            LOG_TRACE("unsupported pin: GPIO", pin);
+        }
+    }
     __EVENT_FUNC_DEFINITION(ThreadNpu, EventSystem, msg) // void ThreadNpu::handlerEventSystem(const Message &msg)
     {
         // LOG_TRACE("EventSystem(", msg.event, "), iParam = ", msg.iParam, ", uParam = ", msg.uParam, ", lParam = ", msg.lParam);
@@ -128,7 +242,10 @@ namespace freertos
         switch (src)
         {
         case SysSoftwareTimer:
-            handlerSoftwareTimer((TimerHandle_t)(msg.lParam));
+            handlerSoftwareTimer(msg.lParam);
+            break;
+        case SysConsoleCommand:
+            handlerConsoleCommand(msg);
             break;
         default:
             LOG_TRACE("unsupported SystemTriggerSource=", src);
@@ -144,15 +261,26 @@ namespace freertos
     void ThreadNpu::onMessage(const Message &msg)
     {
         // LOG_TRACE("event=", msg.event, ", iParam=", msg.iParam, ", uParam=", msg.uParam, ", lParam=", msg.lParam);
-        auto func = handlerMap[msg.event];
-        if (func)
-        {
-            (this->*func)(msg);
-        }
-        else
-        {
-            LOG_TRACE("Unsupported event = ", msg.event, ", iParam = ", msg.iParam, ", uParam = ", msg.uParam, ", lParam = ", msg.lParam);
-        }
+        _queueStats.onReceive(msg);
+        Message latest = msg;
+        _coalescer.onReceive(latest);
+        typedef EventDispatch<ThreadNpu, &ThreadNpu::handlerUnsupported,
+                              __EVENT_ENTRY(ThreadNpu, EventIpc),
+                              __EVENT_ENTRY(ThreadNpu, EventGpioISR),
+                              __EVENT_ENTRY(ThreadNpu, EventSystem),
+                              __EVENT_ENTRY(ThreadNpu, EventNull)>
+            Dispatch;
+        _profile.begin(latest.event);
+        Trace::start(latest);
+        Dispatch::dispatch(*this, latest);
+        Trace::end(latest);
+        _profile.end();
+    }
+
+    // default handler of Dispatch: the event has no entry in the table
+    void ThreadNpu::handlerUnsupported(const Message &msg)
+    {
+        LOG_TRACE("Unsupported event = ", msg.event, ", iParam = ", msg.iParam, ", uParam = ", msg.uParam, ", lParam = ", msg.lParam);
     }
 
     void ThreadNpu::start(void *ctx)
@@ -178,6 +306,13 @@ namespace freertos
         ThreadBase::setup();
 
         _ai.begin();
+        _link.setMode(NPU_LINK_MODE, NPU_LINK_CHUNK);
+        loadThreshold();
+        loadCascade();
+        if (!_detectionLog.begin())
+        {
+            LOG_WARN("no \"", DETECTION_LOG_PARTITION, "\" partition, detection log disabled");
+        }
 
         _timer1Hz.start();
         // _timer1Hz.stop();
@@ -203,80 +338,501 @@ namespace freertos
         //////////////////////////////////////////////////////////////
     }
 
-    void ThreadNpu::handlerSoftwareTimer(TimerHandle_t xTimer)
+    void ThreadNpu::handlerSoftwareTimer(uint32_t timerId)
     {
-        if (xTimer == _timer1Hz.timer())
+        if (timerId == _timer1Hz.id())
         {
             // LOG_TRACE("_timer1Hz");
+#if NPU_TRIGGER_MODE == NPU_TRIGGER_INTERRUPT
+            if (_isNpuRunning &&
+                _scheduler.state() == NpuScheduler::Burst &&
+                (millis() - _lastInferenceMs) >= NPU_INT_TIMEOUT)
+            {
+                LOG_TRACE("npuINT timeout, re-kick inference");
+                runInference();
+            }
+#endif
         }
-        else if (xTimer == _timer2Hz.timer())
+        else if (timerId == _timerInference.id())
         {
-            // LOG_TRACE("_timer2Hz");
+            // LOG_TRACE("_timerInference");
             if (_isNpuRunning)
             {
-                doInference();
+                runInference();
             }
             else
             {
-                _timer2Hz.stop();
+                _timerInference.stop();
             }
         }
         else
         {
-            LOG_TRACE("unsupported timer handle=0x%04x", (uint32_t)(xTimer));
+            LOG_TRACE("unsupported timer id=", timerId);
         }
     }
 
-    void ThreadNpu::doInference(void)
+    void ThreadNpu::handlerConsoleCommand(const Message &msg)
     {
-        if (!_ai.invoke() && _ai.boxes().size() > 0)
+        ConsoleCommand command = static_cast<ConsoleCommand>(msg.uParam);
+        ConsoleLine line = ConsoleLine::unpack(command, msg.lParam);
+        switch (command)
         {
-            // LOG_TRACE("perf: prepocess=", _ai.perf().prepocess, ", inference=", _ai.perf().inference, ", postpocess=", _ai.perf().postprocess);
-            // LOG_TRACE("_ai.boxes().size()=", _ai.boxes().size(), ", .classes().size()=", _ai.classes().size(), ", .points().size()=", _ai.points().size(), ", .keypoints().size()=", _ai.keypoints().size());
-
-            auto appCtx = static_cast<AppContext *>(context());
-            for (int i = 0; i < _ai.boxes().size(); i++)
+        case ConsoleNpuPerf:
+            printPerf();
+            break;
+        case ConsoleNpuZone:
+            if (line.argc && line.argv[0])
             {
-                auto target = _ai.boxes()[i].target;
-                auto score = _ai.boxes()[i].score;
-                // LOG_TRACE("Box[", i, "], target=", _ai.boxes()[i].target, ", score=", _ai.boxes()[i].score,
-                //           ", x=", _ai.boxes()[i].x, ", y=", _ai.boxes()[i].y, ", w=", _ai.boxes()[i].w, ", h=", _ai.boxes()[i].h);
-
-                if (score >= AI_SCORE_THRESHOLD)
+                _pipeline.zones().resetCount();
+            }
+            printZones();
+            break;
+        case ConsoleNpuThreshold:
+            if (line.argc == 3)
+            {
+                if (_pipeline.threshold().set(line.argv[0], line.argv[1], line.argv[2]))
                 {
-                    postEvent(appCtx->queueMain, EventIpc, target == AI_TARGET_TENANT ? IpcNpuTenderDetected : IpcNpuStrangerDetected, score);
+                    saveThreshold();
                 }
                 else
                 {
-                    postEvent(appCtx->queueMain, EventIpc, IpcNpuObjectUnclassified);
+                    PRINTLN("invalid threshold, expect 0 <= leave <= enter <= 100");
                 }
             }
-            for (int i = 0; i < _ai.classes().size(); i++)
+            printThreshold();
+            break;
+        case ConsoleNpuSnapshot:
+            if (line.argc && line.argv[0])
+            {
+                uploadSnapshot();
+            }
+            printSnapshot();
+            break;
+        case ConsoleNpuCascade:
+            if (line.argc == 2)
+            {
+                _models[NpuCascade::Presence] = line.argv[0];
+                _models[NpuCascade::Identity] = line.argv[1];
+                saveCascade();
+                applyCascade();
+            }
+            printCascade();
+            break;
+        case ConsoleNpuBench:
+            runLinkBench(line.argc ? line.argv[0] : -1);
+            break;
+        case ConsoleNpuLog:
+            if (line.argc && line.argv[0])
+            {
+                _detectionLog.flush();
+            }
+            printLog();
+            break;
+        case ConsoleNpuRole:
+            if (line.argc == 2 && _pipeline.threshold().setRole(line.argv[0], static_cast<NpuThreshold::Role>(line.argv[1])))
+            {
+                saveThreshold();
+            }
+            else
+            {
+                PRINTLN("invalid role, expect role <class> <0=ignore|1=tenant|2=stranger>");
+            }
+            printThreshold();
+            break;
+        default:
+            LOG_TRACE("unsupported ConsoleCommand=", command);
+            break;
+        }
+    }
+
+    void ThreadNpu::logDecisions(const NpuFrame &frame)
+    {
+        for (int i = 0; i < _pipeline.decisionCount(); i++)
+        {
+            const NpuTracker::Decision &decision = _pipeline.decision(i);
+            bool isTenant = _pipeline.threshold().roleOf(decision.target) == NpuThreshold::Tenant;
+
+            DetectionRecord record = {};
+            record.timeMs = _lastInferenceMs;
+            record.frameSeq = frame.seq;
+            record.decision = isTenant ? IpcNpuTenderDetected : IpcNpuStrangerDetected;
+            record.target = decision.target;
+            record.score = decision.score;
+            record.trackId = decision.trackId;
+            record.boxCount = frame.boxCount;
+            record.x = decision.box.x;
+            record.y = decision.box.y;
+            record.w = decision.box.w;
+            record.h = decision.box.h;
+            record.inferenceMs = frame.inferenceMs;
+
+            // no flush here: a full batch drops the record, see DetectionLog
+            _detectionLog.append(record);
+        }
+    }
+
+    void ThreadNpu::printLog(void)
+    {
+        if (!_detectionLog.isReady())
+        {
+            PRINTLN("detection log disabled, no \"", DETECTION_LOG_PARTITION, "\" partition");
+            return;
+        }
+        PRINTLN("detection log: capacity=", _detectionLog.capacity(), " records, head=", _detectionLog.head(), ", next seq=", _detectionLog.nextSeq(),
+                ", pending=", _detectionLog.pending());
+        PRINTLN("flushes=", _detectionLog.flushCount(), ", sector erases=", _detectionLog.eraseCount(), ", dropped=", _detectionLog.droppedCount());
+    }
+
+    void ThreadNpu::loadCascade(void)
+    {
+        Preferences prefs;
+        uint8_t models[NpuCascade::StageCount];
+        if (prefs.begin(NVS_NAMESPACE, true))
+        {
+            if (prefs.getBytes(NVS_KEY_CASCADE, models, sizeof(models)) == sizeof(models))
             {
-                LOG_TRACE("Class[", i, "], target=", _ai.classes()[i].target, ", score=", _ai.classes()[i].score);
+                memcpy(_models, models, sizeof(_models));
+                LOG_DEBUG("cascade models loaded from NVS");
             }
+            prefs.end();
+        }
+        applyCascade();
+    }
+
+    void ThreadNpu::saveCascade(void)
+    {
+        Preferences prefs;
+        if (!prefs.begin(NVS_NAMESPACE, false) || prefs.putBytes(NVS_KEY_CASCADE, _models, sizeof(_models)) == 0)
+        {
+            LOG_ERROR("failed to save cascade models to NVS");
+        }
+        prefs.end();
+    }
+
+    void ThreadNpu::applyCascade(void)
+    {
+        _pipeline.setCascade(_models[NpuCascade::Presence] != 0);
+        if (_isNpuRunning)
+        {
+            selectModel(_pipeline.cascade().stage());
+        }
+    }
+
+    // with no cascade, the identity model runs alone: the model loaded at boot until the
+    // cascade has switched models once, the identity model loaded back from then on
+    void ThreadNpu::selectModel(NpuCascade::Stage stage)
+    {
+        uint8_t model = _pipeline.isCascade() ? _models[stage] : _models[NpuCascade::Identity];
+        if (model == 0 || model == _loadedModel || (!_pipeline.isCascade() && _modelSwitchCount == 0))
+        {
+            return;
+        }
 
-            for (int i = 0; i < _ai.points().size(); i++)
+        char command[16];
+        snprintf(command, sizeof(command), "MODEL=%u", model);
+        uint32_t start = millis();
+        int code = NpuAt<NpuLink<SSCMA>>::command(_link, command, "MODEL");
+        _perf.record(NpuPerf::Switch, millis() - start);
+        _modelSwitchCount++;
+
+        if (code == 0)
+        {
+            _loadedModel = model;
+            LOG_TRACE("model ", model, " loaded for stage ", NpuCascade::getStageString(stage));
+        }
+        else
+        {
+            _loadedModel = 0; // retry on the next switch
+            LOG_ERROR("AT+", command, " failed, code=", code);
+        }
+    }
+
+    void ThreadNpu::printCascade(void)
+    {
+        const NpuCascade &cascade = _pipeline.cascade();
+        uint32_t presence = cascade.frameCount(NpuCascade::Presence);
+        uint32_t identity = cascade.frameCount(NpuCascade::Identity);
+        PRINTLN("cascade: ", _pipeline.isCascade() ? "on" : "off", ", presence model=", _models[NpuCascade::Presence], ", identity model=", _models[NpuCascade::Identity],
+                ", stage=", NpuCascade::getStageString(cascade.stage()));
+        PRINTLN("frames: presence=", presence, ", identity=", identity, ", identity ratio=", (presence + identity) ? identity * 100 / (presence + identity) : 0, "%");
+        PRINTLN("promotions=", cascade.promotionCount(), ", model switches=", _modelSwitchCount, ", switch avg=", _perf.stats(NpuPerf::Switch).avg(), " ms");
+    }
+
+    void ThreadNpu::uploadSnapshot(void)
+    {
+        if (WiFi.status() != WL_CONNECTED)
+        {
+            LOG_DEBUG("snapshot skipped: no WiFi");
+            return;
+        }
+        uint32_t start = millis();
+        if (!_snapshotClient.connect(SNAPSHOT_HOST, SNAPSHOT_PORT, NPU_SNAPSHOT_CONNECT_TIMEOUT))
+        {
+            LOG_DEBUG("snapshot skipped: fail to connect server=", SNAPSHOT_HOST, ", port=", SNAPSHOT_PORT);
+            return;
+        }
+
+        // the JPEG size is unknown until the end of the NPU reply, so the body is chunked
+        _snapshotClient.print("POST ");
+        _snapshotClient.print(SNAPSHOT_PATH);
+        _snapshotClient.println(" HTTP/1.1");
+        _snapshotClient.print("Host: ");
+        _snapshotClient.println(SNAPSHOT_HOST);
+        _snapshotClient.println("Content-Type: image/jpeg");
+        _snapshotClient.println("Transfer-Encoding: chunked");
+        _snapshotClient.println("Connection: close");
+        _snapshotClient.println();
+
+        HttpChunkedWriter<WiFiClient> writer(_snapshotClient);
+        uint32_t elapsed = millis() - start;
+        uint32_t streamMs = elapsed + NPU_SNAPSHOT_HTTP_TIMEOUT < NPU_SNAPSHOT_BUDGET ? NPU_SNAPSHOT_BUDGET - NPU_SNAPSHOT_HTTP_TIMEOUT - elapsed : 0;
+        _snapshotReport = _snapshot.stream(_link, writer, streamMs);
+        int status = 0;
+        if (_snapshotReport.isOk && writer.finish())
+        {
+            elapsed = millis() - start;
+            status = readHttpStatus(elapsed < NPU_SNAPSHOT_BUDGET ? NPU_SNAPSHOT_BUDGET - elapsed : 0);
+            _snapshotReport.isOk = (status >= 200 && status < 300);
+        }
+        _snapshotClient.stop();
+
+        LOG_INFO("snapshot: ", _snapshotReport.isOk ? "ok" : "fail", ", HTTP ", status, ", ", _snapshotReport.bytes, " bytes in ", _snapshotReport.ms, " ms, ",
+                 _snapshotReport.bytesPerSecond(), " bytes/s, upload ", millis() - start, " ms");
+    }
+
+    int ThreadNpu::readHttpStatus(uint32_t timeoutMs)
+    {
+        char line[32];
+        _snapshotClient.setTimeout(timeoutMs);
+        size_t n = _snapshotClient.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[n] = '\0';
+
+        int status = 0;
+        if (sscanf(line, "HTTP/%*d.%*d %d", &status) != 1)
+        {
+            LOG_DEBUG("snapshot: no HTTP status line");
+        }
+        return status;
+    }
+
+    void ThreadNpu::printSnapshot(void)
+    {
+        PRINTLN("snapshot: ", _snapshotReport.isOk ? "ok" : "fail", ", ", _snapshotReport.bytes, " bytes in ", _snapshotReport.ms, " ms, ",
+                _snapshotReport.bytesPerSecond(), " bytes/s");
+    }
+
+    // blocks the thread for a few seconds per clock, the inference ticks queue up meanwhile
+    void ThreadNpu::runLinkBench(int clockIndex)
+    {
+        if (clockIndex >= (int)dim(NPU_BENCH_CLOCKS))
+        {
+            PRINTLN("invalid clock, expect bench <0..", dim(NPU_BENCH_CLOCKS) - 1, ">");
+            return;
+        }
+        for (int i = 0; i < (int)dim(NPU_BENCH_CLOCKS); i++)
+        {
+            if (clockIndex >= 0 && clockIndex != i)
             {
-                LOG_TRACE("Point[", i, "], target=", _ai.points()[i].target, ", score=", _ai.points()[i].score, ", x=", _ai.points()[i].x, ", y=", _ai.points()[i].y);
+                continue;
             }
-            for (int i = 0; i < _ai.keypoints().size(); i++)
+            _ai.begin(&Wire, -1, NPU_I2C_ADDRESS, NPU_I2C_WAIT_DELAY, NPU_BENCH_CLOCKS[i]);
+            PRINTLN("clock ", NPU_BENCH_CLOCKS[i], " Hz");
+
+            uint32_t roundTripUs = 0;
+            uint32_t computeMs = 0;
+            int okCount = 0;
+            for (int n = 0; n < NPU_BENCH_INVOKES; n++)
             {
-                LOG_TRACE("keypoint[", i, "], target=", _ai.keypoints()[i].box.target, ", score=", _ai.keypoints()[i].box.score,
-                          ", box:[x=", _ai.keypoints()[i].box.x, ", y=", _ai.keypoints()[i].box.y, ", w=", _ai.keypoints()[i].box.w, ", h=", _ai.keypoints()[i].box.h, "]");
-                LOG_TRACE("points:[");
-                for (int j = 0; j < _ai.keypoints()[i].points.size(); j++)
+                uint32_t start = micros();
+                if (!_ai.invoke())
                 {
-                    LOG_TRACE("\t[", _ai.keypoints()[i].points[j].x, ", ", _ai.keypoints()[i].points[j].y, "]");
+                    roundTripUs += micros() - start;
+                    computeMs += _ai.perf().prepocess + _ai.perf().inference + _ai.perf().postprocess;
+                    okCount++;
                 }
-                LOG_TRACE("]");
             }
+            if (okCount)
+            {
+                uint32_t roundTripMs = roundTripUs / 1000 / okCount;
+                computeMs /= okCount;
+                PRINTLN("  invoke: ", roundTripMs, " ms round trip, ", computeMs, " ms compute, ",
+                        roundTripMs > computeMs ? roundTripMs - computeMs : 0, " ms transport");
+            }
+            else
+            {
+                PRINTLN("  invoke: fail");
+            }
+
+            NpuLinkBench<SSCMA>::Result result = NpuLinkBench<SSCMA>::transfer(_link, NpuLinkDirect, NPU_BENCH_DIRECT_CHUNK);
+            PRINTLN("  direct ", NPU_BENCH_DIRECT_CHUNK, ": ", result.bytes, " bytes, ", result.bytesPerSecond(), " bytes/s, ",
+                    result.transactions, " transactions, first byte ", result.firstByteUs / 1000, " ms");
+            for (int c = 0; c < (int)dim(NPU_BENCH_CHUNKS); c++)
+            {
+                result = NpuLinkBench<SSCMA>::transfer(_link, NpuLinkBulk, NPU_BENCH_CHUNKS[c]);
+                PRINTLN("  bulk ", NPU_BENCH_CHUNKS[c], ": ", result.bytes, " bytes, ", result.bytesPerSecond(), " bytes/s, ",
+                        result.transactions, " transactions, first byte ", result.firstByteUs / 1000, " ms");
+            }
+        }
+
+        _ai.begin();
+        _link.setMode(NPU_LINK_MODE, NPU_LINK_CHUNK);
+    }
+
+    void ThreadNpu::loadThreshold(void)
+    {
+        Preferences prefs;
+        if (!prefs.begin(NVS_NAMESPACE, true))
+        {
+            LOG_DEBUG("no NVS namespace ", NVS_NAMESPACE, ", default thresholds");
+            return;
+        }
+
+        NpuThreshold::Entry entries[NPU_CLASS_MAX];
+        if (prefs.getBytesLength(NVS_KEY_THRESHOLD) == sizeof(entries) &&
+            prefs.getBytes(NVS_KEY_THRESHOLD, entries, sizeof(entries)) == sizeof(entries) &&
+            _pipeline.threshold().load(entries, NPU_CLASS_MAX))
+        {
+            LOG_DEBUG("thresholds loaded from NVS");
         }
         else
         {
+            LOG_DEBUG("default thresholds");
+        }
+        prefs.end();
+    }
+
+    void ThreadNpu::saveThreshold(void)
+    {
+        Preferences prefs;
+        if (!prefs.begin(NVS_NAMESPACE, false) ||
+            prefs.putBytes(NVS_KEY_THRESHOLD, _pipeline.threshold().entries(), sizeof(NpuThreshold::Entry) * NPU_CLASS_MAX) == 0)
+        {
+            LOG_ERROR("failed to save thresholds to NVS");
+        }
+        prefs.end();
+    }
+
+    void ThreadNpu::printThreshold(void)
+    {
+        PRINTLN("class\trole\tenter\tleave");
+        for (int i = 0; i < NPU_CLASS_MAX; i++)
+        {
+            const NpuThreshold::Entry &entry = _pipeline.threshold().entry(i);
+            PRINTLN(i, "\t", NpuThreshold::getRoleString(static_cast<NpuThreshold::Role>(entry.role)), "\t", entry.enter, "\t", entry.leave);
+        }
+    }
+
+    void ThreadNpu::printZones(void)
+    {
+        NpuZoneFilter &zones = _pipeline.zones();
+        if (zones.zoneCount() == 0)
+        {
+            PRINTLN("no zone, every box is kept");
+            return;
+        }
+        for (int i = 0; i < zones.zoneCount(); i++)
+        {
+            const NpuZone &zone = zones.zone(i);
+            PRINTLN("zone[", i, "] ", NpuZone::getRuleString(zone.rule()), ", points=", zone.pointCount(), ", dropped=", zone.dropCount());
+        }
+        PRINTLN("outside of include zones: dropped=", zones.outsideCount());
+    }
+
+    void ThreadNpu::printPerf(void)
+    {
+        PRINTLN("NPU latency in ms (host in us), last ", _perf.stats(NpuPerf::Invoke).count(), " of ", _perf.stats(NpuPerf::Invoke).total(), " frames");
+        PRINTLN("phase\tmin\tavg\tp95\tmax");
+        for (int i = 0; i < NpuPerf::PhaseCount; i++)
+        {
+            NpuPerf::Phase phase = static_cast<NpuPerf::Phase>(i);
+            const LatencyStats &stats = _perf.stats(phase);
+            PRINTLN(NpuPerf::getPhaseString(phase), "\t", stats.min(), "\t", stats.avg(), "\t", stats.percentile(95), "\t", stats.max());
+        }
+    }
+
+    void ThreadNpu::runInference(void)
+    {
+        if (_scheduler.onFrame(doInference()))
+        {
+            applySchedule();
+        }
+    }
+
+    void ThreadNpu::applySchedule(void)
+    {
+        NpuScheduler::State state = _scheduler.state();
+        if (state == NpuScheduler::Stopped)
+        {
+            LOG_TRACE("NPU idle, session inferences=", _scheduler.sessionTotal(),
+                      ": burst=", _scheduler.sessionCount(NpuScheduler::Burst),
+                      ", 4Hz=", _scheduler.sessionCount(NpuScheduler::Fast),
+                      ", 1Hz=", _scheduler.sessionCount(NpuScheduler::Slow),
+                      ", 0.2Hz=", _scheduler.sessionCount(NpuScheduler::Trickle));
+            stopInference();
+
             auto appCtx = static_cast<AppContext *>(context());
-            postEvent(appCtx->queueMain, EventIpc, IpcNpuNoObjectDetected);
+            QueueStats::post(appCtx->queueMain, EventIpc, IpcNpuIdle);
+            return;
+        }
+
+        LOG_TRACE("NPU rate: ", NpuScheduler::getStateString(state));
+#if NPU_TRIGGER_MODE == NPU_TRIGGER_INTERRUPT
+        if (state == NpuScheduler::Burst)
+        {
+            _timerInference.stop(); // npuINT paces the burst
+            return;
+        }
+#endif
+        // changePeriod() also starts a stopped timer
+        _timerInference.changePeriod(_scheduler.period());
+    }
+
+    void ThreadNpu::stopInference(void)
+    {
+        _isNpuRunning = false;
+        _scheduler.stop();
+        _timerInference.stop();
+#if NPU_TRIGGER_MODE == NPU_TRIGGER_INTERRUPT
+        _npuInt.disableInterrupt();
+#endif
+        _detectionLog.flush(); // the flash write stall happens while nobody is in front of the door
+    }
+
+    NpuScheduler::FrameResult ThreadNpu::doInference(void)
+    {
+        _lastInferenceMs = millis();
+
+        NpuFrame frame = {};
+        frame.seq = _frameSeq++;
+
+        uint32_t startUs = micros();
+        bool isOk = !_ai.invoke();
+        uint32_t hostStartUs = micros();
+        uint32_t invokeMs = (hostStartUs - startUs) / 1000;
+        frame.inferenceMs = invokeMs;
+        if (isOk)
+        {
+            _perf.recordInvoke(_ai.perf().prepocess, _ai.perf().inference, _ai.perf().postprocess, invokeMs);
+        }
+
+        NpuCascade::Stage stage = _pipeline.cascade().stage();
+        NpuScheduler::FrameResult result = _pipeline.process(_ai, isOk, frame);
+
+        auto appCtx = static_cast<AppContext *>(context());
+        QueueStats::post(appCtx->queueMain, EventNpuFrame, frame.decision, frame.packScores(), frame.packInfo());
+        if (_isSessionFirstFrame)
+        {
+            _isSessionFirstFrame = false;
+            AlertLatency::mark(_session, _sessionOriginMs, AlertLatency::FirstInference);
+        }
+        _perf.record(NpuPerf::Host, micros() - hostStartUs);
+        logDecisions(frame);
+
+        if (_pipeline.cascade().stage() != stage)
+        {
+            selectModel(_pipeline.cascade().stage());
         }
+        return result;
     }
 
 } // namespace freertos
\ No newline at end of file
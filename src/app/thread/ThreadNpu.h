@@ -19,9 +19,22 @@
  */
 #pragma once
 #include <Seeed_Arduino_SSCMA.h>
-#include <map>
+#include <WiFi.h>
 #include "../ArduProfFreeRTOS.h"
 #include "../AppEvent.h"
+#include "../driver/npu/NpuAt.h"
+#include "../driver/npu/NpuLink.h"
+#include "../driver/npu/NpuSnapshot.h"
+#include "../driver/peripheral/gpio/NpuInt.h"
+#include "../npu/NpuFrame.h"
+#include "../npu/NpuPerf.h"
+#include "../npu/NpuPipeline.h"
+#include "../npu/NpuScheduler.h"
+#include "../storage/DetectionLog.h"
+#include "../util/AlertLatency.h"
+#include "../util/QueueStats.h"
+#include "../util/TaskProfile.h"
+#include "../util/TimerService.h"
 
 namespace freertos
 {
@@ -32,8 +45,6 @@ namespace freertos
         virtual void start(void *);
 
     protected:
-        typedef void (ThreadNpu::*handlerFunc)(const Message &);
-        std::map<int16_t, handlerFunc> handlerMap;
         virtual void onMessage(const Message &msg);
 
         virtual void run(void);
@@ -41,25 +52,79 @@ namespace freertos
     private:
         static ThreadNpu *_instance;
 
+        QueueStats _queueStats;
+        MessageCoalescer _coalescer;
+        TaskProfile _profile;
+
         SSCMA _ai;
+        NpuLink<SSCMA> _link; // raw transport of _ai for NpuAt and NpuSnapshot
         bool _isNpuRunning;
+        uint32_t _lastInferenceMs;
+        uint16_t _frameSeq;
+        uint16_t _session;         // of the last IpcNpuStart, see AlertLatency
+        uint32_t _sessionOriginMs;
+        bool _isSessionFirstFrame;
+
+        NpuInt _npuInt;
+        NpuScheduler _scheduler;
+        typedef NpuModelBox NpuModel; // output policy of the model flashed on the WE2, see NpuModel.h
+        NpuPipeline<SSCMA, NpuModel> _pipeline;
+        NpuPerf _perf;
+
+        NpuSnapshot<NpuLink<SSCMA>> _snapshot;
+        NpuSnapshot<NpuLink<SSCMA>>::Report _snapshotReport;
+        WiFiClient _snapshotClient;
+
+        uint8_t _models[NpuCascade::StageCount]; // SSCMA model id per cascade stage, presence 0 = no cascade
+        uint8_t _loadedModel;                    // model id loaded on the WE2, 0 = unknown
+        uint32_t _modelSwitchCount;
+
+        DetectionLog _detectionLog;
 
         TaskHandle_t _taskInitHandle;
 
-        ardufreertos::PeriodicTimer _timer2Hz;
-        ardufreertos::PeriodicTimer _timer1Hz;
+        WheelTimer _timerInference;
+        WheelTimer _timer1Hz;
 
         virtual void setup(void);
         virtual void delayInit(void);
 
-        void handlerSoftwareTimer(TimerHandle_t xTimer);
-        void doInference(void);
+        void handlerSoftwareTimer(uint32_t timerId);
+        void runInference(void);
+        void applySchedule(void);
+        void stopInference(void);
+        NpuScheduler::FrameResult doInference(void);
+
+        void handlerConsoleCommand(const Message &msg);
+        void printPerf(void);
+        void printZones(void);
+
+        void loadThreshold(void);
+        void saveThreshold(void);
+        void printThreshold(void);
+
+        void loadCascade(void);
+        void saveCascade(void);
+        void applyCascade(void);
+        void selectModel(NpuCascade::Stage stage);
+        void printCascade(void);
+
+        void logDecisions(const NpuFrame &frame);
+        void printLog(void);
+
+        void uploadSnapshot(void);
+        int readHttpStatus(uint32_t timeoutMs);
+        void printSnapshot(void);
+
+        void runLinkBench(int clockIndex);
 
         ///////////////////////////////////////////////////////////////////////
         // declare event handler
         ///////////////////////////////////////////////////////////////////////
         __EVENT_FUNC_DECLARATION(EventIpc)
+        __EVENT_FUNC_DECLARATION(EventGpioISR)
         __EVENT_FUNC_DECLARATION(EventSystem)
         __EVENT_FUNC_DECLARATION(EventNull) // void handlerEventNull(const Message &msg);
+        void handlerUnsupported(const Message &msg);
     };
 } // namespace freertos
\ No newline at end of file
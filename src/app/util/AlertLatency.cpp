@@ -0,0 +1,177 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "./AlertLatency.h"
+#include "../AppLog.h"
+
+portMUX_TYPE AlertLatency::_mux = portMUX_INITIALIZER_UNLOCKED;
+AlertLatency::Session AlertLatency::_sessions[ALERT_SESSIONS];
+uint8_t AlertLatency::_sessionCount = 0;
+uint8_t AlertLatency::_nextSlot = 0;
+LatencyStats AlertLatency::_stats[StageCount];
+LatencyStats AlertLatency::_total;
+uint32_t AlertLatency::_failures = 0;
+
+static uint16_t toStat(uint32_t ms)
+{
+    return ms < UINT16_MAX ? ms : UINT16_MAX;
+}
+
+void AlertLatency::mark(uint16_t session, uint32_t originMs, Stage stage)
+{
+    uint32_t now = millis();
+    uint32_t stageMs[StageCount];
+    uint8_t marked = 0;
+    uint32_t totalMs = 0;
+    uint8_t alert = 0;
+
+    portENTER_CRITICAL(&_mux);
+    Session *entry = find(session, originMs);
+    if (entry->marked & (1 << stage))
+    {
+        portEXIT_CRITICAL(&_mux);
+        return; // e.g. the first inference: the first stamp counts
+    }
+    entry->stampMs[stage] = now;
+    entry->marked |= 1 << stage;
+    if (stage == Status)
+    {
+        // the stages stamped, each since the one before
+        uint32_t last = entry->startMs;
+        for (int i = 0; i < StageCount; i++)
+        {
+            if (entry->marked & (1 << i))
+            {
+                stageMs[i] = entry->stampMs[i] - last;
+                last = entry->stampMs[i];
+                _stats[i].record(toStat(stageMs[i]));
+            }
+        }
+        marked = entry->marked;
+        totalMs = now - entry->startMs;
+        _total.record(toStat(totalMs));
+        alert = ++entry->alerts;
+        end(entry, now);
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (stage == Status)
+    {
+        LOG_INFO("alert ", alert, " of session ", session, ": ", totalMs, " ms, wake=", (marked & (1 << Wake)) ? stageMs[Wake] : 0,
+                 ", first inference=", (marked & (1 << FirstInference)) ? stageMs[FirstInference] : 0,
+                 ", decision=", (marked & (1 << Decision)) ? stageMs[Decision] : 0,
+                 ", connect=", (marked & (1 << Connect)) ? stageMs[Connect] : 0,
+                 ", written=", (marked & (1 << Written)) ? stageMs[Written] : 0,
+                 ", status=", stageMs[Status]);
+    }
+}
+
+void AlertLatency::fail(uint16_t session, uint32_t originMs)
+{
+    portENTER_CRITICAL(&_mux);
+    Session *entry = find(session, originMs);
+    entry->alerts++;
+    end(entry, millis());
+    _failures++;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlertLatency::report(void)
+{
+    portENTER_CRITICAL(&_mux);
+    uint32_t total = _total.total();
+    uint32_t failures = _failures;
+    portEXIT_CRITICAL(&_mux);
+    PRINTLN("alert latency in ms, from the PIR edge to the HTTP status: ", total, " alerts, ", failures, " failed, last ", _total.count(), " kept");
+    PRINTLN("stage\tmin\tavg\tp50\tp95\tmax");
+    for (int i = 0; i <= StageCount; i++)
+    {
+        // a copy: the other threads record meanwhile
+        portENTER_CRITICAL(&_mux);
+        LatencyStats stats = i < StageCount ? _stats[i] : _total;
+        portEXIT_CRITICAL(&_mux);
+        PRINTLN(i < StageCount ? getStageString(static_cast<Stage>(i)) : "total", "\t", stats.min(), "\t", stats.avg(), "\t",
+                stats.percentile(50), "\t", stats.percentile(95), "\t", stats.max());
+    }
+}
+
+void AlertLatency::reset(void)
+{
+    portENTER_CRITICAL(&_mux);
+    for (int i = 0; i < StageCount; i++)
+    {
+        _stats[i].reset();
+    }
+    _total.reset();
+    _failures = 0;
+    portEXIT_CRITICAL(&_mux);
+}
+
+const char *AlertLatency::getStageString(Stage stage)
+{
+    switch (stage)
+    {
+    case Wake:
+        return "wake";
+    case FirstInference:
+        return "first inference";
+    case Decision:
+        return "decision";
+    case Connect:
+        return "TCP connect";
+    case Written:
+        return "request written";
+    case Status:
+        return "status received";
+    default:
+        return "unknown";
+    }
+}
+
+// under _mux; a new session takes the slot of the oldest
+AlertLatency::Session *AlertLatency::find(uint16_t session, uint32_t originMs)
+{
+    for (int i = 0; i < _sessionCount; i++)
+    {
+        if (_sessions[i].session == session && _sessions[i].originMs == originMs)
+        {
+            return &_sessions[i];
+        }
+    }
+    Session *entry = &_sessions[_nextSlot];
+    _nextSlot = (_nextSlot + 1) % ALERT_SESSIONS;
+    if (_sessionCount < ALERT_SESSIONS)
+    {
+        _sessionCount++;
+    }
+    entry->session = session;
+    entry->originMs = originMs;
+    entry->startMs = originMs;
+    entry->marked = 0;
+    entry->alerts = 0;
+    return entry;
+}
+
+void AlertLatency::end(Session *entry, uint32_t nowMs)
+{
+    // the next alert of the session starts here: its decision is the first stage it stamps,
+    // wake and first inference are stamped once per session
+    entry->startMs = nowMs;
+    entry->marked = 0;
+}
@@ -0,0 +1,96 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "../ArduProfFreeRTOS.h"
+#include "./LatencyStats.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// End-to-end latency of the alerts, from the PIR edge to the HTTP status of the message,
+// all values in unit of ms
+//   QueueMain numbers each NPU session (a visit) and keeps the time of the PIR edge which
+//   started it (millis() of the ISR) as its origin. From light sleep, the ISR runs once
+//   the chip is up again: the wake-up of the chip comes before the origin. Both travel
+//   with the messages of the session: IpcNpuStart, EventSendMessage and
+//   EventMessageStatus, uParam=session, lParam=origin. EventNpuFrame has no bit left for
+//   them: a frame belongs to the session of the last IpcNpuStart of ThreadNpu.
+//   The thread which ends a stage stamps it with mark():
+//     Wake           : ThreadNpu starts the NPU, once QueueMain has dispatched the edge
+//     FirstInference : result of the first inference of the session
+//     Decision       : QueueMain posts EventSendMessage
+//     Connect        : TCP connection to the messaging server established
+//     Written        : HTTP request written, on the next 1 Hz poll of ThreadMessaging
+//     Status         : HTTP status line received, on a later poll; ends the alert
+//   Each stage is the time since the stamp before it; the alert goes into the LatencyStats
+//   of each stage and of the total. A second alert of the same session (a stranger after
+//   the tenant) has no wake and first inference of its own: its decision and its total
+//   count from the end of the alert before it, the status or fail(). fail() counts an
+//   alert which got no HTTP status.
+// Sessions are kept in a small table, keyed by session and origin; a new one takes the slot
+// of the oldest. The threads stamp under a lock.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define ALERT_SESSIONS 4
+
+class AlertLatency
+{
+public:
+    typedef enum _Stage : uint8_t
+    {
+        Wake = 0,
+        FirstInference,
+        Decision,
+        Connect,
+        Written,
+        Status,
+
+        StageCount,
+    } Stage;
+
+    static void mark(uint16_t session, uint32_t originMs, Stage stage);
+    static void fail(uint16_t session, uint32_t originMs);
+
+    // print count, failures, and min/avg/p50/p95/max of each stage and of the total
+    static void report(void);
+    static void reset(void);
+
+    static const char *getStageString(Stage stage);
+
+private:
+    struct Session
+    {
+        uint16_t session;
+        uint32_t originMs;
+        uint32_t startMs; // origin, or the end of the previous alert of the session
+        uint32_t stampMs[StageCount];
+        uint8_t marked; // bit per Stage
+        uint8_t alerts; // ended, by a status or fail()
+    };
+
+    static portMUX_TYPE _mux;
+    static Session _sessions[ALERT_SESSIONS];
+    static uint8_t _sessionCount;
+    static uint8_t _nextSlot;
+    static LatencyStats _stats[StageCount];
+    static LatencyStats _total;
+    static uint32_t _failures;
+
+    static Session *find(uint16_t session, uint32_t originMs);
+    static void end(Session *entry, uint32_t nowMs);
+};
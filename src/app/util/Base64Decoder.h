@@ -0,0 +1,96 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Incremental base64 decoder: input may be split at any character, so a stream can be
+// decoded through a small buffer. Characters outside of the base64 alphabet are skipped.
+////////////////////////////////////////////////////////////////////////////////////////////
+class Base64Decoder
+{
+public:
+    Base64Decoder() : _bits(0), _bitCount(0)
+    {
+    }
+
+    void reset(void)
+    {
+        _bits = 0;
+        _bitCount = 0;
+    }
+
+    // max number of bytes written by decode() for length input characters
+    static int outputSize(int length)
+    {
+        return (length * 3) / 4 + 1;
+    }
+
+    // decode length characters into out, return the number of bytes written
+    int decode(const char *in, int length, uint8_t *out)
+    {
+        int n = 0;
+        for (int i = 0; i < length; i++)
+        {
+            int8_t value = valueOf(in[i]);
+            if (value < 0)
+            {
+                continue; // '=' padding, whitespace or escaped '/'
+            }
+            _bits = (_bits << 6) | (uint8_t)value;
+            _bitCount += 6;
+            if (_bitCount >= 8)
+            {
+                _bitCount -= 8;
+                out[n++] = (uint8_t)(_bits >> _bitCount);
+            }
+        }
+        return n;
+    }
+
+private:
+    uint32_t _bits;
+    uint8_t _bitCount;
+
+    static int8_t valueOf(char c)
+    {
+        if (c >= 'A' && c <= 'Z')
+        {
+            return c - 'A';
+        }
+        if (c >= 'a' && c <= 'z')
+        {
+            return c - 'a' + 26;
+        }
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0' + 52;
+        }
+        if (c == '+')
+        {
+            return 62;
+        }
+        if (c == '/')
+        {
+            return 63;
+        }
+        return -1;
+    }
+};
@@ -0,0 +1,130 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include "./Console.h"
+#include "../AppDef.h"
+#include "../AppLog.h"
+
+static const struct
+{
+    const char *name;
+    ConsoleCommand command;
+    uint8_t argMax[CONSOLE_ARG_MAX]; // max value per argument (min is 0), 0 = no such argument
+    const char *help;
+} commandTable[] = {
+    {"help", ConsoleHelp, {}, "list commands"},
+    {"queues", ConsoleQueueReport, {}, "depth, high-water mark, post failures and wait per queue, with suggested depths"},
+    {"timers", ConsoleTimerReport, {}, "timers of the timer wheel: period, state, expiries, and timer daemon wake-ups"},
+    {"tasks", ConsoleTaskReport, {1}, "stack peak and busy share per task, time and stack peak per event handler, \"tasks 1\" resets"},
+    {"trace", ConsoleTrace, {3}, "message trace rings, \"trace <0|1>\" stops/starts, \"trace 2\" dumps on serial, \"trace 3\" uploads, see tools/trace"},
+    {"alert", ConsoleAlertLatency, {1}, "alert latency from PIR edge to HTTP status, min/avg/p50/p95/max per stage, \"alert 1\" resets"},
+    {"power", ConsolePowerReport, {1}, "time active, idle and with the sleep lock released, wake-ups per pin, \"power <0|1>\" disables/enables light sleep"},
+    {"lanes", ConsoleBusLanes, {}, "message lanes of the main loop: served, pending and starvation counters"},
+    {"perf", ConsoleNpuPerf, {}, "NPU latency min/avg/p95/max per phase"},
+    {"zone", ConsoleNpuZone, {1}, "zones and dropped boxes, \"zone 1\" resets the counters"},
+    {"thr", ConsoleNpuThreshold, {255, 100, 100}, "class thresholds, \"thr <class> <enter> <leave>\" sets and saves"},
+    {"snap", ConsoleNpuSnapshot, {1}, "last snapshot upload, \"snap 1\" uploads a new one"},
+    {"cascade", ConsoleNpuCascade, {255, 255}, "cascade stats, \"cascade <presence> <identity>\" sets and saves the model ids, presence 0 disables"},
+    {"bench", ConsoleNpuBench, {2}, "NPU link throughput per bus clock and chunk size, \"bench <n>\" runs clock n only"},
+    {"log", ConsoleNpuLog, {1}, "detection log in flash, \"log 1\" flushes the pending records"},
+    {"role", ConsoleNpuRole, {255, 2}, "\"role <class> <0=ignore|1=tenant|2=stranger>\" sets and saves"},
+};
+
+bool Console::read(ConsoleLine *line)
+{
+    while (_stream && _stream->available() > 0)
+    {
+        int c = _stream->read();
+        if (c == '\r' || c == '\n')
+        {
+            _line[_length] = '\0';
+            bool isCommand = _length > 0 && parse(line);
+            _length = 0;
+            if (isCommand)
+            {
+                return true;
+            }
+        }
+        else if (_length < CONSOLE_LINE_SIZE - 1)
+        {
+            _line[_length++] = (char)c;
+        }
+    }
+    return false;
+}
+
+bool Console::parse(ConsoleLine *line)
+{
+    char *save = nullptr;
+    char *token = strtok_r(_line, " \t", &save);
+    if (!token)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < dim(commandTable); i++)
+    {
+        if (strcmp(token, commandTable[i].name) == 0)
+        {
+            line->command = commandTable[i].command;
+            line->argc = 0;
+            while ((token = strtok_r(nullptr, " \t", &save)) != nullptr)
+            {
+                // arguments are packed in 8 bits each, see ConsoleLine::pack()
+                if (line->argc >= CONSOLE_ARG_MAX || commandTable[i].argMax[line->argc] == 0)
+                {
+                    PRINTLN("too many arguments for ", commandTable[i].name, ", type \"help\" for usage");
+                    return false;
+                }
+                char *end = nullptr;
+                long value = strtol(token, &end, 0);
+                if (*end != '\0' || value < 0 || value > commandTable[i].argMax[line->argc])
+                {
+                    PRINTLN("invalid argument ", token, " of ", commandTable[i].name, ", expect 0..", (int)commandTable[i].argMax[line->argc]);
+                    return false;
+                }
+                line->argv[line->argc++] = value;
+            }
+            return true;
+        }
+    }
+    PRINTLN("unknown command: ", token, ", type \"help\" for a list of commands");
+    return false;
+}
+
+void Console::printHelp(void)
+{
+    for (size_t i = 0; i < dim(commandTable); i++)
+    {
+        PRINTLN(commandTable[i].name, "\t", commandTable[i].help);
+    }
+}
+
+const char *Console::getCommandString(ConsoleCommand command)
+{
+    for (size_t i = 0; i < dim(commandTable); i++)
+    {
+        if (commandTable[i].command == command)
+        {
+            return commandTable[i].name;
+        }
+    }
+    return "unknown";
+}
@@ -0,0 +1,79 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "../AppEvent.h"
+
+#define CONSOLE_LINE_SIZE 48
+#define CONSOLE_ARG_MAX 3
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Line based diagnostic console on Serial, e.g. "perf"
+// Console only parses lines into ConsoleCommand; QueueMain routes them to the owning thread
+// as EventSystem/SysConsoleCommand, so every report is printed from its own thread context
+////////////////////////////////////////////////////////////////////////////////////////////
+struct ConsoleLine
+{
+    ConsoleCommand command;
+    uint8_t argc;
+    int32_t argv[CONSOLE_ARG_MAX];
+
+    // argc and the arguments (8 bits each, range checked by Console::parse) packed into the lParam of SysConsoleCommand
+    uint32_t pack(void) const
+    {
+        uint32_t lParam = (uint32_t)argc << 24;
+        for (int i = 0; i < argc; i++)
+        {
+            lParam |= ((uint32_t)argv[i] & 0xff) << (16 - 8 * i);
+        }
+        return lParam;
+    }
+
+    static ConsoleLine unpack(ConsoleCommand command, uint32_t lParam)
+    {
+        ConsoleLine line = {command, (uint8_t)(lParam >> 24), {0}};
+        for (int i = 0; i < line.argc && i < CONSOLE_ARG_MAX; i++)
+        {
+            line.argv[i] = (lParam >> (16 - 8 * i)) & 0xff;
+        }
+        return line;
+    }
+};
+
+class Console
+{
+public:
+    Console(Stream *stream) : _stream(stream), _length(0)
+    {
+    }
+
+    // consume pending input, return true when a complete known command is received
+    bool read(ConsoleLine *line);
+
+    static void printHelp(void);
+    static const char *getCommandString(ConsoleCommand command);
+
+private:
+    Stream *_stream;
+    char _line[CONSOLE_LINE_SIZE];
+    uint8_t _length;
+
+    bool parse(ConsoleLine *line);
+};
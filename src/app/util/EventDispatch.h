@@ -0,0 +1,190 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "../ArduProfFreeRTOS.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Compile-time event dispatch table, in place of a std::map<int16_t, handlerFunc>
+//   typedef EventDispatch<QueueMain, &QueueMain::handlerUnsupported,
+//                         __EVENT_ENTRY(QueueMain, EventIpc),
+//                         __EVENT_ENTRY(QueueMain, EventNull)> Dispatch;
+//   Dispatch::dispatch(*this, msg);
+// The table is a const array of one byte per event in [min event, max event], holding the
+// index of the handler (0 = the default handler), so a dispatch is a bounds check and two
+// loads, with no heap and no lookup. The table lives in flash; with the AppEvent numbering
+// it is about 400 bytes per thread.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+// counterpart of __EVENT_MAP, as a type: {event, &cls::handler<event>}
+#define __EVENT_ENTRY(cls, event) EventEntry<cls, (event), &cls::handler##event>
+
+template <typename T, int16_t Event, void (T::*Handler)(const Message &)>
+struct EventEntry
+{
+    static constexpr int16_t event = Event;
+    static constexpr void (T::*handler)(const Message &) = Handler;
+};
+
+namespace eventdispatch
+{
+    // C++11 stand-in for std::index_sequence, built in log(N) template depth
+    template <size_t... Is>
+    struct Indices
+    {
+    };
+
+    template <typename A, typename B>
+    struct Concat;
+    template <size_t... As, size_t... Bs>
+    struct Concat<Indices<As...>, Indices<Bs...>>
+    {
+        typedef Indices<As..., (sizeof...(As) + Bs)...> type;
+    };
+
+    template <size_t N>
+    struct MakeIndices
+    {
+        typedef typename Concat<typename MakeIndices<N / 2>::type, typename MakeIndices<N - N / 2>::type>::type type;
+    };
+    template <>
+    struct MakeIndices<0>
+    {
+        typedef Indices<> type;
+    };
+    template <>
+    struct MakeIndices<1>
+    {
+        typedef Indices<0> type;
+    };
+
+    template <typename... Entries>
+    struct Scan;
+
+    template <>
+    struct Scan<>
+    {
+        static constexpr int16_t minEvent(int16_t value)
+        {
+            return value;
+        }
+        static constexpr int16_t maxEvent(int16_t value)
+        {
+            return value;
+        }
+        static constexpr uint8_t indexOf(int16_t, uint8_t)
+        {
+            return 0;
+        }
+        static constexpr int countOf(int16_t)
+        {
+            return 0;
+        }
+        static constexpr bool isUnique(void)
+        {
+            return true;
+        }
+    };
+
+    template <typename E, typename... Es>
+    struct Scan<E, Es...>
+    {
+        static constexpr int16_t minEvent(int16_t value)
+        {
+            return Scan<Es...>::minEvent(E::event < value ? E::event : value);
+        }
+        static constexpr int16_t maxEvent(int16_t value)
+        {
+            return Scan<Es...>::maxEvent(E::event > value ? E::event : value);
+        }
+        // index of the entry of event, counting from index; 0 if none
+        static constexpr uint8_t indexOf(int16_t event, uint8_t index)
+        {
+            return E::event == event ? index : Scan<Es...>::indexOf(event, index + 1);
+        }
+        static constexpr int countOf(int16_t event)
+        {
+            return (E::event == event ? 1 : 0) + Scan<Es...>::countOf(event);
+        }
+        static constexpr bool isUnique(void)
+        {
+            return Scan<Es...>::countOf(E::event) == 0 && Scan<Es...>::isUnique();
+        }
+    };
+} // namespace eventdispatch
+
+template <typename T, void (T::*DefaultHandler)(const Message &), typename... Entries>
+class EventDispatch
+{
+public:
+    typedef void (T::*Handler)(const Message &);
+
+    static constexpr int16_t MinEvent = eventdispatch::Scan<Entries...>::minEvent(INT16_MAX);
+    static constexpr int16_t MaxEvent = eventdispatch::Scan<Entries...>::maxEvent(INT16_MIN);
+    static constexpr size_t Span = (size_t)(MaxEvent - MinEvent) + 1;
+
+    static_assert(sizeof...(Entries) > 0, "EventDispatch needs at least one entry");
+    static_assert(sizeof...(Entries) < UINT8_MAX, "EventDispatch has one byte per handler index");
+    static_assert(eventdispatch::Scan<Entries...>::isUnique(), "EventDispatch has an event twice");
+
+    static void dispatch(T &target, const Message &msg)
+    {
+        // an event below MinEvent wraps around to a large offset
+        size_t offset = (uint16_t)(msg.event - MinEvent);
+        (target.*_handlers[offset < Span ? _index[offset] : 0])(msg);
+    }
+
+    // true if event has its own handler
+    static bool isHandled(int16_t event)
+    {
+        size_t offset = (uint16_t)(event - MinEvent);
+        return offset < Span && _index[offset] != 0;
+    }
+
+private:
+    template <size_t... Is>
+    struct Table
+    {
+        static constexpr uint8_t index[sizeof...(Is)] = {eventdispatch::Scan<Entries...>::indexOf(MinEvent + Is, 1)...};
+    };
+    template <size_t... Is>
+    static constexpr Table<Is...> tableOf(eventdispatch::Indices<Is...>)
+    {
+        return Table<Is...>();
+    }
+    typedef decltype(tableOf(typename eventdispatch::MakeIndices<Span>::type())) IndexTable;
+
+    static constexpr const uint8_t (&_index)[Span] = IndexTable::index;
+    static constexpr Handler _handlers[sizeof...(Entries) + 1] = {DefaultHandler, Entries::handler...};
+};
+
+template <typename T, int16_t Event, void (T::*Handler)(const Message &)>
+constexpr void (T::*EventEntry<T, Event, Handler>::handler)(const Message &);
+
+template <typename T, void (T::*DefaultHandler)(const Message &), typename... Entries>
+template <size_t... Is>
+constexpr uint8_t EventDispatch<T, DefaultHandler, Entries...>::Table<Is...>::index[sizeof...(Is)];
+
+template <typename T, void (T::*DefaultHandler)(const Message &), typename... Entries>
+constexpr const uint8_t (&EventDispatch<T, DefaultHandler, Entries...>::_index)[EventDispatch<T, DefaultHandler, Entries...>::Span];
+
+template <typename T, void (T::*DefaultHandler)(const Message &), typename... Entries>
+constexpr typename EventDispatch<T, DefaultHandler, Entries...>::Handler EventDispatch<T, DefaultHandler, Entries...>::_handlers[sizeof...(Entries) + 1];
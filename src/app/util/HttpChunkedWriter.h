@@ -0,0 +1,70 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// HTTP/1.1 chunked transfer coding on top of a client socket (WiFiClient)
+// Every write() goes out as one chunk, so a body of unknown length is sent without buffering
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Client>
+class HttpChunkedWriter
+{
+public:
+    HttpChunkedWriter(Client &client) : _client(client), _bytes(0)
+    {
+    }
+
+    size_t write(const uint8_t *data, size_t length)
+    {
+        if (length == 0)
+        {
+            return 0;
+        }
+
+        char header[12];
+        int n = snprintf(header, sizeof(header), "%x\r\n", (unsigned)length);
+        if (_client.write((const uint8_t *)header, n) != (size_t)n ||
+            _client.write(data, length) != length ||
+            _client.write((const uint8_t *)"\r\n", 2) != 2)
+        {
+            return 0;
+        }
+        _bytes += length;
+        return length;
+    }
+
+    // last chunk, end of the body
+    bool finish(void)
+    {
+        return _client.write((const uint8_t *)"0\r\n\r\n", 5) == 5;
+    }
+
+    uint32_t bytes(void) const
+    {
+        return _bytes;
+    }
+
+private:
+    Client &_client;
+    uint32_t _bytes;
+};
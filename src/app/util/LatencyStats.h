@@ -0,0 +1,166 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Rolling latency statistics over the last LATENCY_WINDOW samples
+// Fixed size and allocation free: a ring of samples plus a bucket histogram which is kept in
+// sync with the ring, so min/avg/max/percentile are exact over the window (percentile is
+// reported as the upper edge of its bucket)
+////////////////////////////////////////////////////////////////////////////////////////////
+#define LATENCY_WINDOW 64
+
+class LatencyStats
+{
+public:
+    LatencyStats()
+    {
+        reset();
+    }
+
+    void reset(void)
+    {
+        memset(_samples, 0, sizeof(_samples));
+        memset(_buckets, 0, sizeof(_buckets));
+        _head = 0;
+        _size = 0;
+        _sum = 0;
+        _total = 0;
+    }
+
+    void record(uint16_t value)
+    {
+        if (_size == LATENCY_WINDOW)
+        {
+            uint16_t old = _samples[_head];
+            _buckets[bucketOf(old)]--;
+            _sum -= old;
+        }
+        else
+        {
+            _size++;
+        }
+        _samples[_head] = value;
+        _head = (_head + 1) % LATENCY_WINDOW;
+        _buckets[bucketOf(value)]++;
+        _sum += value;
+        _total++;
+    }
+
+    uint16_t count(void) const
+    {
+        return _size;
+    }
+    uint32_t total(void) const
+    {
+        return _total;
+    }
+
+    uint16_t min(void) const
+    {
+        uint16_t value = UINT16_MAX;
+        for (int i = 0; i < _size; i++)
+        {
+            value = _samples[i] < value ? _samples[i] : value;
+        }
+        return _size ? value : 0;
+    }
+    uint16_t max(void) const
+    {
+        uint16_t value = 0;
+        for (int i = 0; i < _size; i++)
+        {
+            value = _samples[i] > value ? _samples[i] : value;
+        }
+        return value;
+    }
+    uint16_t avg(void) const
+    {
+        return _size ? (uint16_t)(_sum / _size) : 0;
+    }
+
+    // smallest bucket edge which is >= percent of the samples, clamped to max()
+    uint16_t percentile(uint8_t percent) const
+    {
+        if (_size == 0)
+        {
+            return 0;
+        }
+        uint32_t rank = ((uint32_t)_size * percent + 99) / 100;
+        uint32_t seen = 0;
+        for (int b = 0; b < BucketCount; b++)
+        {
+            seen += _buckets[b];
+            if (seen >= rank)
+            {
+                uint16_t edge = upperEdge(b);
+                uint16_t top = max();
+                return edge < top ? edge : top;
+            }
+        }
+        return max();
+    }
+
+private:
+    // log-linear bucket upper edges, 4 buckets per power of 2
+    enum
+    {
+        BucketCount = 60, // covers 0..65535
+    };
+
+    uint16_t _samples[LATENCY_WINDOW];
+    uint8_t _buckets[BucketCount];
+    uint16_t _head;
+    uint16_t _size;
+    uint32_t _sum;
+    uint32_t _total;
+
+    static uint16_t upperEdge(int bucket)
+    {
+        if (bucket < 8)
+        {
+            return bucket; // 0..7 exact
+        }
+        int octave = bucket / 4 - 2;   // 8..15 -> 0, 16..31 -> 1, ...
+        int step = bucket % 4;
+        uint32_t base = 8UL << octave;
+        uint32_t edge = base + ((base / 4) * (step + 1)) - 1;
+        return edge > UINT16_MAX ? UINT16_MAX : (uint16_t)edge;
+    }
+
+    static int bucketOf(uint16_t value)
+    {
+        if (value < 8)
+        {
+            return value;
+        }
+        int octave = 0;
+        while ((8UL << (octave + 1)) <= value)
+        {
+            octave++;
+        }
+        uint32_t base = 8UL << octave;
+        int step = (int)((value - base) / (base / 4));
+        int bucket = (octave + 2) * 4 + step;
+        return bucket < BucketCount ? bucket : BucketCount - 1;
+    }
+};
@@ -0,0 +1,188 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "./MessageCoalescer.h"
+
+MessageCoalescer::MessageCoalescer() : _rules(),
+                                       _ruleCount(0),
+                                       _slots(),
+                                       _absorbed(0),
+                                       _untracked(0)
+{
+    portMUX_INITIALIZE(&_mux);
+}
+
+// to be called before any message is posted
+bool MessageCoalescer::addRule(int16_t event, int16_t iParam, CoalesceKey key)
+{
+    if (_ruleCount >= COALESCE_RULE_MAX)
+    {
+        return false;
+    }
+    Rule *rule = &_rules[_ruleCount++];
+    rule->event = event;
+    rule->iParam = iParam;
+    rule->key = key;
+    rule->posted = 0;
+    rule->received = 0;
+    return true;
+}
+
+bool MessageCoalescer::absorb(int16_t event, int16_t iParam, uint16_t uParam, uint32_t lParam)
+{
+    Rule *rule = findRule(event, iParam);
+    if (!rule)
+    {
+        return false;
+    }
+
+    bool isAbsorbed = false;
+    portENTER_CRITICAL(&_mux);
+    Slot *slot = findLast(rule, iParam, lParam);
+    if (slot && slot->iParam == iParam)
+    {
+        slot->uParam = uParam;
+        slot->lParam = lParam;
+        _absorbed++;
+        isAbsorbed = true;
+    }
+    else
+    {
+        if (slot)
+        {
+            // a new iParam: the pending message keeps its place and payload, and stops absorbing
+            slot->isLast = false;
+        }
+        slot = allocate();
+        if (slot)
+        {
+            slot->rule = rule;
+            slot->iParam = iParam;
+            slot->uParam = uParam;
+            slot->lParam = lParam;
+            slot->seq = rule->posted;
+            slot->isLast = true;
+        }
+        else
+        {
+            _untracked++;
+        }
+        rule->posted++;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return isAbsorbed;
+}
+
+void MessageCoalescer::onPostFailed(int16_t event, int16_t iParam, uint32_t lParam)
+{
+    Rule *rule = findRule(event, iParam);
+    if (!rule)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    rule->posted--;
+    Slot *slot = findLast(rule, iParam, lParam);
+    if (slot)
+    {
+        slot->rule = nullptr;
+    }
+    portEXIT_CRITICAL(&_mux);
+}
+
+void MessageCoalescer::onReceive(Message &msg)
+{
+    Rule *rule = findRule(msg.event, msg.iParam);
+    if (!rule)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    Slot *slot = findReceived(rule, msg, rule->received++);
+    if (slot)
+    {
+        msg.uParam = slot->uParam;
+        msg.lParam = slot->lParam;
+        slot->rule = nullptr;
+    }
+    portEXIT_CRITICAL(&_mux);
+}
+
+MessageCoalescer::Rule *MessageCoalescer::findRule(int16_t event, int16_t iParam)
+{
+    for (int i = 0; i < _ruleCount; i++)
+    {
+        if (_rules[i].event == event && (_rules[i].iParam == COALESCE_ANY_PARAM || _rules[i].iParam == iParam))
+        {
+            return &_rules[i];
+        }
+    }
+    return nullptr;
+}
+
+MessageCoalescer::Slot *MessageCoalescer::findLast(const Rule *rule, int16_t iParam, uint32_t lParam)
+{
+    for (int i = 0; i < COALESCE_SLOT_MAX; i++)
+    {
+        Slot *slot = &_slots[i];
+        if (slot->rule != rule || !slot->isLast)
+        {
+            continue;
+        }
+        if (rule->key == CoalesceByLParam && (slot->iParam != iParam || slot->lParam != lParam))
+        {
+            continue;
+        }
+        return slot;
+    }
+    return nullptr;
+}
+
+// the slot of a message just received: by sequence in a CoalesceByEvent stream, by key
+// otherwise, where a stream has one message in the queue at most
+MessageCoalescer::Slot *MessageCoalescer::findReceived(const Rule *rule, const Message &msg, uint16_t seq)
+{
+    for (int i = 0; i < COALESCE_SLOT_MAX; i++)
+    {
+        Slot *slot = &_slots[i];
+        if (slot->rule != rule)
+        {
+            continue;
+        }
+        if (rule->key == CoalesceByEvent ? slot->seq == seq : (slot->iParam == msg.iParam && slot->lParam == msg.lParam))
+        {
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+MessageCoalescer::Slot *MessageCoalescer::allocate(void)
+{
+    for (int i = 0; i < COALESCE_SLOT_MAX; i++)
+    {
+        if (!_slots[i].rule)
+        {
+            return &_slots[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,109 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "../ArduProfFreeRTOS.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Opt-in coalescing of the messages posted to a queue
+//   The consumer declares which messages are coalescable with addRule(), and attaches the
+//   coalescer to the QueueStats of its queue: QueueStats::post() then calls absorb() first,
+//   and a message absorbed by a pending one takes no queue slot. The consumer calls
+//   onReceive() on each message received, which hands it the payload of the last message
+//   absorbed (replace: the newest uParam/lParam win). absorbed() counts for every queue
+//   attached; QueueStats::report() prints the count of each queue, so the coalescer shared
+//   by the two lanes of QueueMain is not counted twice.
+//   A stream is the sequence of coalescable messages sharing a key:
+//     CoalesceByEvent : the event. A message is absorbed only if the last message posted
+//                       in the stream is still pending and has the same iParam, so a
+//                       change of iParam (e.g. the decision of EventNpuFrame) is never
+//                       merged away, nor moved ahead of the message it follows.
+//     CoalesceByLParam: the event, iParam and lParam, e.g. the ticks of each timer
+//                       (lParam = xTimer). A tick of a timer whose last tick is pending is
+//                       absorbed, so a slow consumer sees one tick, not a backlog of them.
+//   A coalescable message must be posted through QueueStats::post() only, never from an ISR
+//   or by postEvent(): CoalesceByEvent streams pair posts and receives by their order.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define COALESCE_RULE_MAX 4
+#define COALESCE_SLOT_MAX 8                  // coalescable messages tracked in the queue at a time
+#define COALESCE_ANY_PARAM ((int16_t)0x8000) // rule matching any iParam
+
+typedef enum _CoalesceKey : uint8_t
+{
+    CoalesceByEvent = 0,
+    CoalesceByLParam,
+} CoalesceKey;
+
+class MessageCoalescer
+{
+public:
+    MessageCoalescer();
+
+    bool addRule(int16_t event, int16_t iParam, CoalesceKey key);
+
+    // true: merged into the pending message of its stream, do not post it
+    // false: post it, it is now the pending message of its stream (if coalescable)
+    bool absorb(int16_t event, int16_t iParam, uint16_t uParam, uint32_t lParam);
+    // the post after absorb() returned false has failed
+    void onPostFailed(int16_t event, int16_t iParam, uint32_t lParam);
+
+    void onReceive(Message &msg);
+
+    uint32_t absorbed(void) const
+    {
+        return _absorbed;
+    }
+    uint32_t untracked(void) const
+    {
+        return _untracked;
+    }
+
+private:
+    struct Rule
+    {
+        int16_t event;
+        int16_t iParam;
+        CoalesceKey key;
+        uint16_t posted;   // CoalesceByEvent: sequence of the messages posted in the stream
+        uint16_t received; // and of those received, the queue being FIFO
+    };
+    // one message in the queue, with the payload of the last message it absorbed
+    struct Slot
+    {
+        Rule *rule; // nullptr: free
+        int16_t iParam;
+        uint16_t uParam;
+        uint32_t lParam;
+        uint16_t seq; // CoalesceByEvent: Rule::posted when it was posted
+        bool isLast;  // the last message posted in its stream, it may absorb
+    };
+
+    portMUX_TYPE _mux;
+    Rule _rules[COALESCE_RULE_MAX];
+    uint8_t _ruleCount;
+    Slot _slots[COALESCE_SLOT_MAX];
+    uint32_t _absorbed;
+    uint32_t _untracked; // coalescable messages posted while every slot was in use
+
+    Rule *findRule(int16_t event, int16_t iParam);
+    Slot *findLast(const Rule *rule, int16_t iParam, uint32_t lParam);
+    Slot *findReceived(const Rule *rule, const Message &msg, uint16_t seq);
+    Slot *allocate(void);
+};
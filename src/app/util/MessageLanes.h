@@ -0,0 +1,100 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Priority lanes of a message bus
+//   LaneUrgent: ISR and control events (GPIO edges, debounce ticks, buttons, 1Hz timer)
+//   LaneBulk  : data events (NPU frames, messaging status)
+// LanePolicy picks the lane to serve next: urgent first, but once LANE_URGENT_BURST urgent
+// messages in a row were served while a bulk message was waiting, the bulk lane gets one
+// turn, so a stuck ISR source cannot starve the NPU results for good.
+// Portable, no RTOS: QueueMain feeds it the pending state of its two FreeRTOS queues,
+// tools/lanebench feeds it a simulated load.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define LANE_URGENT_BURST 16
+
+typedef enum _MessageLane : uint8_t
+{
+    LaneUrgent = 0,
+    LaneBulk,
+    LaneCount, // also "no lane", both are empty
+} MessageLane;
+
+class LanePolicy
+{
+public:
+    struct Stats
+    {
+        uint32_t served[LaneCount];
+        uint32_t bulkStarved; // urgent served while bulk was waiting
+        uint32_t bulkForced;  // bulk served ahead of a waiting urgent, after LANE_URGENT_BURST
+        uint16_t maxUrgentRun; // longest run of urgent served while bulk was waiting
+    };
+
+    explicit LanePolicy(uint16_t urgentBurst = LANE_URGENT_BURST) : _urgentBurst(urgentBurst), _urgentRun(0), _stats()
+    {
+    }
+
+    MessageLane next(bool isUrgentPending, bool isBulkPending)
+    {
+        if (!isBulkPending)
+        {
+            _urgentRun = 0;
+            if (!isUrgentPending)
+            {
+                return LaneCount;
+            }
+            _stats.served[LaneUrgent]++;
+            return LaneUrgent;
+        }
+
+        if (isUrgentPending && _urgentRun < _urgentBurst)
+        {
+            _urgentRun++;
+            if (_urgentRun > _stats.maxUrgentRun)
+            {
+                _stats.maxUrgentRun = _urgentRun;
+            }
+            _stats.bulkStarved++;
+            _stats.served[LaneUrgent]++;
+            return LaneUrgent;
+        }
+
+        if (isUrgentPending)
+        {
+            _stats.bulkForced++;
+        }
+        _urgentRun = 0;
+        _stats.served[LaneBulk]++;
+        return LaneBulk;
+    }
+
+    const Stats &stats(void) const
+    {
+        return _stats;
+    }
+
+private:
+    uint16_t _urgentBurst;
+    uint16_t _urgentRun;
+    Stats _stats;
+};
@@ -0,0 +1,145 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "./QueueStats.h"
+#include "../AppLog.h"
+
+QueueStats *QueueStats::_first = nullptr;
+
+QueueStats::QueueStats(const char *name, QueueHandle_t queue, uint16_t capacity) : _next(_first),
+                                                                                   _name(name),
+                                                                                   _queue(queue),
+                                                                                   _capacity(capacity),
+                                                                                   _highWater(0),
+                                                                                   _postFailures(0),
+                                                                                   _received(0),
+                                                                                   _coalesced(0),
+                                                                                   _coalescer(nullptr),
+                                                                                   _traceQueue(Trace::addQueue(name)),
+                                                                                   _tagMs(0),
+                                                                                   _tagCountdown(0),
+                                                                                   _waitSumMs(0),
+                                                                                   _waitCount(0),
+                                                                                   _waitMaxMs(0)
+{
+    portMUX_INITIALIZE(&_mux);
+    _first = this;
+}
+
+void QueueStats::onReceive(const Message &msg)
+{
+    uint16_t waiting = uxQueueMessagesWaiting(_queue);
+    Trace::dequeue(_traceQueue, msg, waiting);
+    if (waiting + 1 > _highWater)
+    {
+        _highWater = waiting + 1;
+    }
+    _received++;
+
+    uint32_t now = millis();
+    if (_tagCountdown && --_tagCountdown == 0)
+    {
+        uint32_t wait = now - _tagMs;
+        _waitSumMs += wait;
+        _waitCount++;
+        if (wait > _waitMaxMs)
+        {
+            _waitMaxMs = wait;
+        }
+    }
+    if (!_tagCountdown && waiting)
+    {
+        _tagMs = now;
+        _tagCountdown = waiting;
+    }
+}
+
+bool QueueStats::post(ardufreertos::MessageQueue *dest, int16_t event, int16_t iParam, uint16_t uParam, uint32_t lParam)
+{
+    if (!dest)
+    {
+        return false;
+    }
+    QueueStats *stats = find(dest->queue());
+    MessageCoalescer *coalescer = stats ? stats->_coalescer : nullptr;
+    uint8_t traceQueue = stats ? stats->_traceQueue : TRACE_NO_QUEUE;
+    if (coalescer && coalescer->absorb(event, iParam, uParam, lParam))
+    {
+        portENTER_CRITICAL(&stats->_mux);
+        stats->_coalesced++;
+        portEXIT_CRITICAL(&stats->_mux);
+        Trace::post(traceQueue, TraceCoalesce, event, iParam);
+        return true;
+    }
+    // recorded first: a receiver of higher priority runs, and dequeues, within postEvent()
+    Trace::post(traceQueue, TracePost, event, iParam);
+    bool isOk = dest->postEvent(event, iParam, uParam, lParam);
+    if (!isOk)
+    {
+        Trace::post(traceQueue, TracePostFail, event, iParam);
+    }
+    if (!isOk && stats)
+    {
+        portENTER_CRITICAL(&stats->_mux);
+        stats->_postFailures++;
+        portEXIT_CRITICAL(&stats->_mux);
+        if (coalescer)
+        {
+            coalescer->onPostFailed(event, iParam, lParam);
+        }
+    }
+    return isOk;
+}
+
+uint16_t QueueStats::suggestedDepth(void) const
+{
+    uint16_t depth = QUEUE_STATS_MIN_DEPTH;
+    while (depth < _highWater * 2 && depth < _capacity)
+    {
+        depth *= 2;
+    }
+    return depth < _capacity ? depth : _capacity;
+}
+
+void QueueStats::report(void)
+{
+    uint32_t savedBytes = 0;
+    for (QueueStats *stats = _first; stats; stats = stats->_next)
+    {
+        uint16_t suggested = stats->suggestedDepth();
+        PRINTLN(stats->_name, ": depth=", stats->depth(), "/", stats->_capacity, ", high water=", stats->_highWater,
+                ", received=", stats->_received, ", coalesced=", stats->coalesced(), ", post failures=", stats->_postFailures,
+                ", wait avg/max=", stats->waitAvgMs(), "/", stats->_waitMaxMs, " ms (", stats->_waitCount, " samples), suggested depth=", suggested);
+        savedBytes += (stats->_capacity - suggested) * sizeof(Message);
+    }
+    PRINTLN("suggested depths free ", savedBytes, " bytes of queue storage, valid for the load seen since boot (",
+            millis() / 1000, " s)");
+}
+
+QueueStats *QueueStats::find(QueueHandle_t queue)
+{
+    for (QueueStats *stats = _first; stats; stats = stats->_next)
+    {
+        if (stats->_queue == queue)
+        {
+            return stats;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,117 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "../ArduProfFreeRTOS.h"
+#include "./MessageCoalescer.h"
+#include "./Trace.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Depth, high-water mark, post failures and time in queue of a message queue
+//   onReceive() is called by the consumer right after each receive: the depth seen then,
+//   plus the message just taken, is the depth the queue had reached, as a queue only
+//   shrinks on a receive. So the high-water mark is exact, not sampled.
+//   Messages carry no post time, so the time in queue is measured on samples: when a
+//   receive leaves n messages behind, the n-th next receive gets the one which was last
+//   then, and it has waited at least the time in between. Only messages which queued
+//   behind others are sampled, the wait of the others is about 0.
+//   post() is postEvent() of ArduProf, counting a failure (queue full) against the
+//   destination. Posts from ISRs go straight to the queue and are not counted. If the
+//   destination has a MessageCoalescer attached, a message it absorbs is not posted.
+//   Several tasks post to a queue: its post counters are incremented under a lock.
+//   Both record the message in the Trace, the queue being known to Trace by its name.
+// Every QueueStats registers itself in a list, which report() walks.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define QUEUE_STATS_MIN_DEPTH 8 // smallest depth report() suggests
+
+class QueueStats
+{
+public:
+    QueueStats(const char *name, QueueHandle_t queue, uint16_t capacity);
+
+    void onReceive(const Message &msg);
+    void attach(MessageCoalescer *coalescer)
+    {
+        _coalescer = coalescer;
+    }
+
+    static bool post(ardufreertos::MessageQueue *dest, int16_t event, int16_t iParam = 0, uint16_t uParam = 0, uint32_t lParam = 0);
+
+    // print every queue and a suggested depth: twice the high-water mark, as a power of two
+    static void report(void);
+
+    const char *name(void) const
+    {
+        return _name;
+    }
+    uint16_t depth(void) const
+    {
+        return uxQueueMessagesWaiting(_queue);
+    }
+    uint16_t highWater(void) const
+    {
+        return _highWater;
+    }
+    uint32_t postFailures(void) const
+    {
+        return _postFailures;
+    }
+    uint32_t received(void) const
+    {
+        return _received;
+    }
+    uint32_t waitAvgMs(void) const
+    {
+        return _waitCount ? _waitSumMs / _waitCount : 0;
+    }
+    uint32_t waitMaxMs(void) const
+    {
+        return _waitMaxMs;
+    }
+    // messages absorbed on their way to this queue, not to another queue sharing the coalescer
+    uint32_t coalesced(void) const
+    {
+        return _coalesced;
+    }
+    uint16_t suggestedDepth(void) const;
+
+private:
+    static QueueStats *_first;
+    QueueStats *_next;
+
+    const char *_name;
+    QueueHandle_t _queue;
+    uint16_t _capacity;
+    uint16_t _highWater;
+    uint32_t _postFailures;
+    uint32_t _received;
+    uint32_t _coalesced;
+    portMUX_TYPE _mux; // _postFailures and _coalesced, from the posting tasks
+    MessageCoalescer *_coalescer;
+    uint8_t _traceQueue;
+
+    uint32_t _tagMs;        // time of the receive which started the current sample
+    uint16_t _tagCountdown; // receives until the sampled message, 0 = no sample
+    uint32_t _waitSumMs;
+    uint32_t _waitCount;
+    uint32_t _waitMaxMs;
+
+    static QueueStats *find(QueueHandle_t queue);
+};
@@ -0,0 +1,96 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Lock-free single-producer/single-consumer ring
+//   push() is called by one producer only (e.g. the GPIO ISRs, which do not preempt one
+//   another), pop() by one consumer only (e.g. the QueueMain task). Each index is written
+//   by one side and read by the other, so plain atomic loads and stores with
+//   acquire/release ordering are enough: no critical section and no read-modify-write,
+//   which the ESP32-C3 (RV32IMC, no "A" extension) would emulate by masking interrupts.
+//   The indices run freely and wrap at 2^32; a slot is index & (N - 1).
+//   A full ring drops the new item and counts an overflow: an ISR cannot wait.
+// Portable, no RTOS: tools/spscstress runs it on the host from two threads.
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T, uint32_t N>
+class SpscRing
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing() : _head(0), _tail(0), _overflows(0)
+    {
+    }
+
+    // producer
+    bool push(const T &item)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N)
+        {
+            _overflows.store(_overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer
+    bool pop(T *item)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        *item = _items[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // either side, a snapshot; tail first, it never passes a head read after it
+    uint32_t size(void) const
+    {
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        return _head.load(std::memory_order_acquire) - tail;
+    }
+    uint32_t pushed(void) const
+    {
+        return _head.load(std::memory_order_relaxed);
+    }
+    uint32_t overflows(void) const
+    {
+        return _overflows.load(std::memory_order_relaxed);
+    }
+    static uint32_t capacity(void)
+    {
+        return N;
+    }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _head; // next slot to write, producer owned
+    std::atomic<uint32_t> _tail; // next slot to read, consumer owned
+    std::atomic<uint32_t> _overflows;
+};
@@ -0,0 +1,223 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <esp_timer.h>
+#include "./TaskProfile.h"
+#include "../AppLog.h"
+
+TaskProfile *TaskProfile::_first = nullptr;
+portMUX_TYPE TaskProfile::_mux = portMUX_INITIALIZER_UNLOCKED;
+uint16_t TaskProfile::_tickCount = 0;
+int64_t TaskProfile::_sampleUs = 0;
+int64_t TaskProfile::_resetUs = 0;
+
+// the task of the FreeRTOS timers, attached in sample()
+static TaskProfile timerDaemon("Tmr Svc", configTIMER_TASK_STACK_DEPTH);
+
+TaskProfile::TaskProfile(const char *name, uint32_t stackSize) : _next(_first),
+                                                                 _name(name),
+                                                                 _stackSize(stackSize),
+                                                                 _task(nullptr),
+                                                                 _stackFree(stackSize),
+                                                                 _isInside(false),
+                                                                 _handler(nullptr),
+                                                                 _startUs(0),
+                                                                 _excludedUs(0),
+                                                                 _busyUs(0),
+                                                                 _busyAtSample(0),
+                                                                 _share(0),
+                                                                 _sharePeak(0),
+                                                                 _handlers(),
+                                                                 _handlerCount(0),
+                                                                 _untracked(0)
+{
+    _first = this;
+}
+
+void TaskProfile::begin(int16_t event)
+{
+#if TASK_PROFILE
+    if (!_task)
+    {
+        _task = xTaskGetCurrentTaskHandle();
+    }
+    _handler = find(event);
+    portENTER_CRITICAL(&_mux);
+    _excludedUs = 0;
+    _isInside = true;
+    portEXIT_CRITICAL(&_mux);
+    _startUs = esp_timer_get_time();
+#endif
+}
+
+void TaskProfile::end(void)
+{
+#if TASK_PROFILE
+    int64_t elapsed = esp_timer_get_time() - _startUs;
+    uint32_t stackFree = uxTaskGetStackHighWaterMark(nullptr);
+
+    portENTER_CRITICAL(&_mux);
+    _isInside = false;
+    uint32_t us = elapsed > _excludedUs ? (uint32_t)(elapsed - _excludedUs) : 0;
+    // this handler preempted the ones still inside: its time is not theirs
+    for (TaskProfile *profile = _first; profile; profile = profile->_next)
+    {
+        if (profile->_isInside)
+        {
+            profile->_excludedUs += us;
+        }
+    }
+    _busyUs += us;
+    portEXIT_CRITICAL(&_mux);
+
+    if (stackFree < _stackFree)
+    {
+        _stackFree = stackFree;
+        if (_handler)
+        {
+            _handler->stackPeak = _stackSize - stackFree;
+        }
+    }
+    if (_handler)
+    {
+        _handler->count++;
+        _handler->busyUs += us;
+        if (us > _handler->maxUs)
+        {
+            _handler->maxUs = us;
+        }
+    }
+#endif
+}
+
+void TaskProfile::onTick(void)
+{
+    if (++_tickCount >= TASK_PROFILE_PERIOD)
+    {
+        _tickCount = 0;
+        sample();
+    }
+}
+
+void TaskProfile::sample(void)
+{
+    if (!timerDaemon._task)
+    {
+        timerDaemon._task = xTimerGetTimerDaemonTaskHandle();
+    }
+
+    int64_t now = esp_timer_get_time();
+    int64_t period = now - _sampleUs;
+    _sampleUs = now;
+    for (TaskProfile *profile = _first; profile; profile = profile->_next)
+    {
+        if (profile->_task)
+        {
+            uint32_t stackFree = uxTaskGetStackHighWaterMark(profile->_task);
+            if (stackFree < profile->_stackFree)
+            {
+                profile->_stackFree = stackFree;
+            }
+        }
+
+        portENTER_CRITICAL(&_mux);
+        uint64_t busy = profile->_busyUs - profile->_busyAtSample;
+        profile->_busyAtSample = profile->_busyUs;
+        portEXIT_CRITICAL(&_mux);
+        profile->_share = period > 0 ? (uint16_t)(busy * 1000 / period) : 0;
+        if (profile->_share > profile->_sharePeak)
+        {
+            profile->_sharePeak = profile->_share;
+        }
+    }
+}
+
+void TaskProfile::report(void)
+{
+    int64_t now = esp_timer_get_time();
+    for (TaskProfile *profile = _first; profile; profile = profile->_next)
+    {
+        uint32_t used = profile->_stackSize - profile->_stackFree;
+        uint32_t avg = now > _resetUs ? (uint32_t)(profile->_busyUs * 1000 / (now - _resetUs)) : 0;
+        PRINTLN(profile->_name, ": stack=", profile->_stackSize, ", peak=", used, " (", used * 100 / profile->_stackSize,
+                "%), suggested=", profile->suggestedStack(), ", busy=", profile->_share / 10, ".", profile->_share % 10,
+                "%, peak=", profile->_sharePeak / 10, ".", profile->_sharePeak % 10, "%, avg=", avg / 10, ".", avg % 10, "%");
+        for (int i = 0; i < profile->_handlerCount; i++)
+        {
+            const Handler &handler = profile->_handlers[i];
+            PRINTLN("  event ", handler.event, ": n=", handler.count, ", avg=", handler.count ? (uint32_t)(handler.busyUs / handler.count) : 0,
+                    " us, max=", handler.maxUs, " us, total=", (uint32_t)(handler.busyUs / 1000), " ms, stack peak=", handler.stackPeak);
+        }
+        if (profile->_untracked)
+        {
+            PRINTLN("  ", profile->_untracked, " messages of untracked events (over ", TASK_PROFILE_EVENTS, ")");
+        }
+    }
+    PRINTLN("busy: time inside handlers, blocked time included, share of the last ", TASK_PROFILE_PERIOD, " s period, its peak, and the average since ",
+            _resetUs ? "reset (" : "boot (", (uint32_t)((now - _resetUs) / 1000000), " s)");
+}
+
+void TaskProfile::reset(void)
+{
+    _resetUs = esp_timer_get_time();
+    for (TaskProfile *profile = _first; profile; profile = profile->_next)
+    {
+        portENTER_CRITICAL(&_mux);
+        profile->_busyUs = 0;
+        profile->_busyAtSample = 0;
+        portEXIT_CRITICAL(&_mux);
+        profile->_sharePeak = 0;
+        for (int i = 0; i < profile->_handlerCount; i++)
+        {
+            Handler &handler = profile->_handlers[i];
+            handler.count = 0;
+            handler.busyUs = 0;
+            handler.maxUs = 0;
+        }
+        profile->_untracked = 0;
+    }
+}
+
+TaskProfile::Handler *TaskProfile::find(int16_t event)
+{
+    for (int i = 0; i < _handlerCount; i++)
+    {
+        if (_handlers[i].event == event)
+        {
+            return &_handlers[i];
+        }
+    }
+    if (_handlerCount >= TASK_PROFILE_EVENTS)
+    {
+        _untracked++;
+        return nullptr;
+    }
+    Handler *handler = &_handlers[_handlerCount++];
+    handler->event = event;
+    return handler;
+}
+
+// the peak plus half of it, in multiples of TASK_PROFILE_ROUND, the current size if larger or
+// if no peak is known
+uint32_t TaskProfile::suggestedStack(void) const
+{
+    uint32_t used = _stackSize - _stackFree;
+    uint32_t size = (used + used / 2 + TASK_PROFILE_ROUND - 1) / TASK_PROFILE_ROUND * TASK_PROFILE_ROUND;
+    return size && size < _stackSize ? size : _stackSize;
+}
@@ -0,0 +1,98 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "../ArduProfFreeRTOS.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Stack use and busy time of a task, and of each of its event handlers
+//   begin()/end() bracket onMessage(). The time in between, less the handlers of other
+//   tasks which ran meanwhile (preemption), is busy time of the task, charged to the event.
+//   A handler which blocks (delay, I2C wait) stays busy while blocked, light sleep
+//   included: that is time the thread is not available for its queue either.
+//   The stack high-water mark is read after each handler; when it went down, the handler
+//   is charged with the new stack peak of the task. The mark never goes back up, so the
+//   peak of the handler which set it is exact, the peaks of the others are lower bounds.
+//   sample() reads the high-water mark of every task and turns the busy time since the
+//   last sample into a busy share. It is not a CPU share: a handler blocked on I2C or on
+//   the network counts as busy while the core runs others or idles. QueueMain calls
+//   onTick() every second, which samples every TASK_PROFILE_PERIOD seconds.
+// Stack sizes are in bytes, as StackType_t of ESP-IDF. Every TaskProfile registers itself
+// in a list, which report() walks; the timer daemon has one, with no handler.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define TASK_PROFILE 1         // 0: begin()/end() do nothing
+#define TASK_PROFILE_PERIOD 10 // in unit of seconds
+#define TASK_PROFILE_EVENTS 10 // event handlers per task
+#define TASK_PROFILE_ROUND 256 // suggested stack sizes are multiples of that, in bytes
+
+class TaskProfile
+{
+public:
+    TaskProfile(const char *name, uint32_t stackSize);
+
+    // in the task itself
+    void begin(int16_t event);
+    void end(void);
+
+    static void onTick(void);
+    static void sample(void);
+    // print every task and its handlers; reset() clears the busy times and the handler stats
+    static void report(void);
+    static void reset(void);
+
+private:
+    struct Handler
+    {
+        int16_t event;
+        uint16_t stackPeak; // used bytes, when this handler set the peak of the task
+        uint32_t count;
+        uint64_t busyUs;
+        uint32_t maxUs;
+    };
+
+    static TaskProfile *_first;
+    static portMUX_TYPE _mux;
+    static uint16_t _tickCount;
+    static int64_t _sampleUs; // time of the last sample
+    static int64_t _resetUs;  // time of the last reset()
+    TaskProfile *_next;
+
+    const char *_name;
+    uint32_t _stackSize;
+    TaskHandle_t _task;  // known from the first begin()
+    uint32_t _stackFree; // high-water mark: least free stack seen
+
+    bool _isInside;
+    Handler *_handler; // of the handler running
+    int64_t _startUs;
+    uint32_t _excludedUs;
+
+    uint64_t _busyUs;
+    uint64_t _busyAtSample;
+    uint16_t _share;     // in 0.1%, of the last sample period
+    uint16_t _sharePeak; // in 0.1%
+
+    Handler _handlers[TASK_PROFILE_EVENTS];
+    uint8_t _handlerCount;
+    uint32_t _untracked; // handlers over TASK_PROFILE_EVENTS
+
+    Handler *find(int16_t event);
+    uint32_t suggestedStack(void) const;
+};
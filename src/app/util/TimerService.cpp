@@ -0,0 +1,208 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "./TimerService.h"
+#include "./QueueStats.h"
+#include "../AppEvent.h"
+#include "../AppLog.h"
+
+#define TICK_RTOS pdMS_TO_TICKS(TIMER_SERVICE_TICK_MS) // RTOS ticks per wheel tick
+
+TimerService &TimerService::instance(void)
+{
+    static TimerService service;
+    return service;
+}
+
+TimerService::TimerService() : _timer(xTimerCreate("Timer wheel", 1, pdFALSE, nullptr,
+                                                   [](TimerHandle_t xTimer)
+                                                   {
+                                                       TimerService::instance().onTimer();
+                                                   })),
+                               _wheel(),
+                               _baseRtos(xTaskGetTickCount()),
+                               _baseTick(0),
+                               _isArmed(false),
+                               _armedExpiry(0),
+                               _timers(),
+                               _timerCount(0),
+                               _wakeups(0),
+                               _fired(0),
+                               _armFailures(0)
+{
+    portMUX_INITIALIZE(&_mux);
+}
+
+uint16_t TimerService::add(WheelTimer *timer)
+{
+    if (_timerCount >= TIMER_SERVICE_MAX)
+    {
+        LOG_ERROR("TIMER_SERVICE_MAX reached, ", timer->name(), " never fires");
+        return 0;
+    }
+    _timers[_timerCount++] = timer;
+    return _timerCount;
+}
+
+void TimerService::start(WheelTimer *timer, uint32_t periodMs)
+{
+    if (!timer->_id)
+    {
+        return;
+    }
+    uint32_t period = (periodMs + TIMER_SERVICE_TICK_MS / 2) / TIMER_SERVICE_TICK_MS;
+
+    portENTER_CRITICAL(&_mux);
+    _wheel.start(timer, period, now());
+    uint32_t expiry = timer->expiry();
+    bool isEarlier = !_isArmed || (int32_t)(expiry - _armedExpiry) < 0;
+    if (isEarlier)
+    {
+        _isArmed = true;
+        _armedExpiry = expiry;
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (isEarlier)
+    {
+        armUntilStable(expiry, pdMS_TO_TICKS(TIMER_SERVICE_ARM_WAIT_MS));
+    }
+}
+
+// the FreeRTOS timer stays armed: at worst one wake-up for nothing
+void TimerService::stop(WheelTimer *timer)
+{
+    portENTER_CRITICAL(&_mux);
+    _wheel.stop(timer);
+    portEXIT_CRITICAL(&_mux);
+}
+
+void TimerService::report(void)
+{
+    for (int i = 0; i < _timerCount; i++)
+    {
+        WheelTimer *timer = _timers[i];
+        PRINTLN(timer->_id, ": ", timer->_name, ", period=", timer->_periodMs, " ms, ", timer->isQueued() ? "running" : "stopped",
+                ", fired=", timer->_fired);
+    }
+    PRINTLN(_fired, " expiries in ", _wakeups, " wake-ups of the timer daemon, tick=", TIMER_SERVICE_TICK_MS, " ms, arm failures=",
+            _armFailures);
+}
+
+// wheel tick of the RTOS tick count, in a critical section
+uint32_t TimerService::now(void)
+{
+    TickType_t elapsed = xTaskGetTickCount() - _baseRtos;
+    return _baseTick + elapsed / TICK_RTOS;
+}
+
+// timer daemon task
+void TimerService::onTimer(void)
+{
+    ExpiredList list;
+    list.count = 0;
+
+    uint32_t next = 0;
+    portENTER_CRITICAL(&_mux);
+    uint32_t tick = now();
+    // move the base along, the RTOS tick count may wrap in between two wake-ups
+    _baseRtos += (tick - _baseTick) * TICK_RTOS;
+    _baseTick = tick;
+    _wheel.advance(tick, onExpiry, &list);
+    bool isArmed = _wheel.nextExpiry(&next);
+    _isArmed = isArmed;
+    _armedExpiry = next;
+    _wakeups++;
+    _fired += list.count;
+    portEXIT_CRITICAL(&_mux);
+
+    for (int i = 0; i < list.count; i++)
+    {
+        QueueStats::post(list.timers[i]->_owner, EventSystem, SysSoftwareTimer, 0, list.timers[i]->_id);
+    }
+
+    // the daemon cannot wait for room in its own queue
+    if (isArmed)
+    {
+        armUntilStable(next, 0);
+    }
+}
+
+// a task may start an earlier timer and arm for it between the critical section of the
+// caller and its arm(), which would then arm for the later expiry: arm again until
+// _armedExpiry is stable
+void TimerService::armUntilStable(uint32_t expiry, TickType_t wait)
+{
+    for (;;)
+    {
+        bool isOk = arm(expiry, wait);
+        portENTER_CRITICAL(&_mux);
+        if (!isOk && _isArmed && _armedExpiry == expiry)
+        {
+            // the FreeRTOS timer is dormant, or armed for a later expiry: the next start() arms it
+            _isArmed = false;
+            _armFailures++;
+        }
+        bool isStable = !_isArmed || _armedExpiry == expiry;
+        expiry = _armedExpiry;
+        portEXIT_CRITICAL(&_mux);
+        if (isStable)
+        {
+            return;
+        }
+    }
+}
+
+// false when the command queue of the timer daemon stayed full
+bool TimerService::arm(uint32_t expiry, TickType_t wait)
+{
+    portENTER_CRITICAL(&_mux);
+    TickType_t target = _baseRtos + (expiry - _baseTick) * TICK_RTOS;
+    portEXIT_CRITICAL(&_mux);
+
+    TickType_t ticks = target - xTaskGetTickCount();
+    if ((int32_t)ticks <= 0)
+    {
+        ticks = 1;
+    }
+    // xTimerChangePeriod() also starts a dormant timer
+    return xTimerChangePeriod(_timer, ticks, wait) == pdPASS;
+}
+
+void TimerService::onExpiry(WheelNode *node, void *ctx)
+{
+    auto list = static_cast<ExpiredList *>(ctx);
+    auto timer = static_cast<WheelTimer *>(node);
+    timer->_fired++;
+    if (list->count < TIMER_SERVICE_MAX)
+    {
+        list->timers[list->count++] = timer;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+WheelTimer::WheelTimer(const char *name, ardufreertos::MessageQueue *owner, uint32_t periodMs) : WheelNode(),
+                                                                                                  _name(name),
+                                                                                                  _owner(owner),
+                                                                                                  _periodMs(periodMs),
+                                                                                                  _id(0),
+                                                                                                  _fired(0)
+{
+    _id = TimerService::instance().add(this);
+}
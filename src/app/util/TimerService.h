@@ -0,0 +1,130 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "../ArduProfFreeRTOS.h"
+#include "./TimerWheel.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// One timer wheel for every thread, driven by a single one-shot FreeRTOS timer
+//   A WheelTimer belongs to a thread (its owner queue). On expiry the TimerService posts
+//   EventSystem/SysSoftwareTimer with lParam = WheelTimer::id() straight to that queue.
+//   The FreeRTOS timer is armed to the earliest expiry of the wheel only, not every tick,
+//   and the wheel aligns the timers on multiples of their period: the 1Hz timers of all the
+//   threads expire together, with the NPU inference timer on every 1 s boundary, and cost
+//   one wake-up of the timer daemon between them, where each had its own timer before.
+//   The wheel runs in ticks of TIMER_SERVICE_TICK_MS; a period is rounded to whole ticks.
+// start()/stop() are called from the tasks, the expiries run in the timer daemon task: the
+// wheel is guarded by a critical section, the posts are made outside it.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define TIMER_SERVICE_TICK_MS 5      // DebounceTimerInterval, the shortest period
+#define TIMER_SERVICE_MAX 8          // WheelTimer objects
+#define TIMER_SERVICE_ARM_WAIT_MS 10 // a task waits that long for room in the queue of the timer daemon
+
+class WheelTimer;
+
+class TimerService
+{
+public:
+    static TimerService &instance(void);
+
+    uint16_t add(WheelTimer *timer); // 0: no room
+    void start(WheelTimer *timer, uint32_t periodMs);
+    void stop(WheelTimer *timer);
+
+    void report(void);
+
+private:
+    TimerService();
+
+    TimerHandle_t _timer;
+    portMUX_TYPE _mux;
+    TimerWheel _wheel;
+    TickType_t _baseRtos; // RTOS tick count of wheel tick _baseTick, moved along in onTimer()
+    uint32_t _baseTick;
+    bool _isArmed;
+    uint32_t _armedExpiry; // wheel tick the FreeRTOS timer is armed for
+
+    WheelTimer *_timers[TIMER_SERVICE_MAX];
+    uint8_t _timerCount;
+    uint32_t _wakeups;     // expiries of the FreeRTOS timer
+    uint32_t _fired;       // expiries of the wheel timers
+    uint32_t _armFailures; // xTimerChangePeriod() failed, the queue of the timer daemon full
+
+    struct ExpiredList
+    {
+        WheelTimer *timers[TIMER_SERVICE_MAX];
+        uint8_t count;
+    };
+
+    uint32_t now(void);
+    void onTimer(void);
+    void armUntilStable(uint32_t expiry, TickType_t wait);
+    bool arm(uint32_t expiry, TickType_t wait);
+    static void onExpiry(WheelNode *node, void *ctx);
+};
+
+class WheelTimer : public WheelNode
+{
+public:
+    WheelTimer(const char *name, ardufreertos::MessageQueue *owner, uint32_t periodMs);
+
+    // start or restart, aligned on a multiple of the period
+    void start(void)
+    {
+        TimerService::instance().start(this, _periodMs);
+    }
+    void stop(void)
+    {
+        TimerService::instance().stop(this);
+    }
+    // change the period and (re)start, as xTimerChangePeriod()
+    void changePeriod(uint32_t periodMs)
+    {
+        _periodMs = periodMs;
+        start();
+    }
+
+    // lParam of its SysSoftwareTimer messages
+    uint32_t id(void) const
+    {
+        return _id;
+    }
+    const char *name(void) const
+    {
+        return _name;
+    }
+    uint32_t periodMs(void) const
+    {
+        return _periodMs;
+    }
+    uint32_t fired(void) const
+    {
+        return _fired;
+    }
+
+private:
+    friend class TimerService;
+    const char *_name;
+    ardufreertos::MessageQueue *_owner;
+    uint32_t _periodMs;
+    uint16_t _id;
+    uint32_t _fired;
+};
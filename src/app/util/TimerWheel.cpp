@@ -0,0 +1,213 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include "./TimerWheel.h"
+
+// a slot of level n spans 2^(TIMER_WHEEL_BITS * n) ticks
+#define LEVEL_SHIFT(level) (TIMER_WHEEL_BITS * (level))
+
+TimerWheel::TimerWheel(uint32_t now) : _now(now),
+                                       _count(0)
+{
+    memset(_slots, 0, sizeof(_slots));
+}
+
+void TimerWheel::start(WheelNode *node, uint32_t period, uint32_t from)
+{
+    if (node->isQueued())
+    {
+        unlink(node);
+        _count--;
+    }
+    if ((int32_t)(from - _now) < 0)
+    {
+        from = _now;
+    }
+    node->_period = period ? period : 1;
+    node->_expiry = (from / node->_period + 1) * node->_period;
+    insert(node);
+    _count++;
+}
+
+void TimerWheel::stop(WheelNode *node)
+{
+    if (node->isQueued())
+    {
+        unlink(node);
+        _count--;
+    }
+}
+
+uint16_t TimerWheel::advance(uint32_t to, ExpiryCallback cb, void *ctx)
+{
+    uint16_t fired = 0;
+    if (!_count && (int32_t)(to - _now) > 0)
+    {
+        _now = to;
+    }
+    while ((int32_t)(to - _now) > 0)
+    {
+        _now++;
+        if ((_now & TIMER_WHEEL_MASK) == 0)
+        {
+            cascade(1);
+        }
+
+        // every timer of the slot expires now: a level 0 slot is one tick
+        WheelNode *node = _slots[0][_now & TIMER_WHEEL_MASK];
+        _slots[0][_now & TIMER_WHEEL_MASK] = nullptr;
+        while (node)
+        {
+            WheelNode *next = node->_next;
+            node->_next = nullptr;
+            node->_pprev = nullptr;
+
+            // re-queue first, cb may stop it; skip the periods missed until "to"
+            uint32_t expiry = node->_expiry + node->_period;
+            if ((int32_t)(to - expiry) >= 0)
+            {
+                expiry += ((to - expiry) / node->_period + 1) * node->_period;
+            }
+            node->_expiry = expiry;
+            insert(node);
+
+            cb(node, ctx);
+            fired++;
+            node = next;
+        }
+    }
+    return fired;
+}
+
+bool TimerWheel::nextExpiry(uint32_t *expiry) const
+{
+    bool isFound = false;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        uint32_t candidate;
+        if (earliest(level, &candidate) && (!isFound || (int32_t)(candidate - *expiry) < 0))
+        {
+            *expiry = candidate;
+            isFound = true;
+        }
+    }
+    return isFound;
+}
+
+void TimerWheel::insert(WheelNode *node)
+{
+    // expiry == _now: cascaded on the tick it expires, its level 0 slot is served next
+    if ((int32_t)(node->_expiry - _now) < 0)
+    {
+        node->_expiry = _now + 1;
+    }
+
+    // the lowest level whose slots reach the expiry without wrapping onto the current slot
+    int level = 0;
+    uint32_t index = node->_expiry & TIMER_WHEEL_MASK;
+    if (node->_expiry - _now >= TIMER_WHEEL_SLOTS)
+    {
+        for (level = 1; level < TIMER_WHEEL_LEVELS; level++)
+        {
+            // slots of this level between now and the expiry, modulo the wrap of the tick count
+            uint32_t span = ((node->_expiry >> LEVEL_SHIFT(level)) - (_now >> LEVEL_SHIFT(level))) &
+                            (0xffffffffUL >> LEVEL_SHIFT(level));
+            if (span < TIMER_WHEEL_SLOTS)
+            {
+                break;
+            }
+        }
+        if (level < TIMER_WHEEL_LEVELS)
+        {
+            index = (node->_expiry >> LEVEL_SHIFT(level)) & TIMER_WHEEL_MASK;
+        }
+        else
+        {
+            // beyond the wheel: park in the farthest slot, it cascades down from there
+            level = TIMER_WHEEL_LEVELS - 1;
+            index = ((_now >> LEVEL_SHIFT(level)) + TIMER_WHEEL_MASK) & TIMER_WHEEL_MASK;
+        }
+    }
+
+    WheelNode **head = &_slots[level][index];
+    node->_next = *head;
+    if (node->_next)
+    {
+        node->_next->_pprev = &node->_next;
+    }
+    node->_pprev = head;
+    *head = node;
+}
+
+void TimerWheel::unlink(WheelNode *node)
+{
+    *node->_pprev = node->_next;
+    if (node->_next)
+    {
+        node->_next->_pprev = node->_pprev;
+    }
+    node->_next = nullptr;
+    node->_pprev = nullptr;
+}
+
+// called when _now enters the slot of level "level": move its timers to the levels below
+void TimerWheel::cascade(int level)
+{
+    uint32_t index = (_now >> LEVEL_SHIFT(level)) & TIMER_WHEEL_MASK;
+    if (index == 0 && level + 1 < TIMER_WHEEL_LEVELS)
+    {
+        cascade(level + 1);
+    }
+
+    WheelNode *node = _slots[level][index];
+    _slots[level][index] = nullptr;
+    while (node)
+    {
+        WheelNode *next = node->_next;
+        node->_next = nullptr;
+        node->_pprev = nullptr;
+        insert(node);
+        node = next;
+    }
+}
+
+// earliest expiry in a level: the slots ahead are in time order, so the first one not empty
+bool TimerWheel::earliest(int level, uint32_t *expiry) const
+{
+    uint32_t base = _now >> LEVEL_SHIFT(level);
+    for (uint32_t i = 1; i < TIMER_WHEEL_SLOTS; i++)
+    {
+        const WheelNode *node = _slots[level][(base + i) & TIMER_WHEEL_MASK];
+        if (!node)
+        {
+            continue;
+        }
+        *expiry = node->_expiry;
+        for (node = node->_next; node; node = node->_next)
+        {
+            if ((int32_t)(node->_expiry - *expiry) < 0)
+            {
+                *expiry = node->_expiry;
+            }
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,102 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Hierarchical timer wheel
+//   3 levels of 64 slots; a slot of level 0 is one tick, of level 1 64 ticks, of level 2
+//   4096 ticks. A timer sits in level 0 when it expires within 64 ticks, else in the
+//   level whose slot spans its expiry; it moves down (cascade) when the wheel reaches that
+//   slot. start(), stop() and the expiry of a timer are O(1) whatever the number of timers.
+//   The first expiry of a periodic timer is aligned on a multiple of its period, so timers
+//   of the same period (or of multiple periods) expire on the same tick: one wake-up.
+//   A timer which expired late (advance() called late) fires once, then keeps its phase.
+// Portable, no RTOS: TimerService drives it from a FreeRTOS timer, tools/timerwheel checks
+// it against a brute-force model on the host.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define TIMER_WHEEL_LEVELS 3
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1UL << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+class TimerWheel;
+
+class WheelNode
+{
+public:
+    WheelNode() : _next(nullptr), _pprev(nullptr), _expiry(0), _period(0)
+    {
+    }
+
+    bool isQueued(void) const
+    {
+        return _pprev != nullptr;
+    }
+    uint32_t expiry(void) const
+    {
+        return _expiry;
+    }
+    uint32_t period(void) const
+    {
+        return _period;
+    }
+
+private:
+    friend class TimerWheel;
+    WheelNode *_next;
+    WheelNode **_pprev; // the link which points to this node, nullptr: not in the wheel
+    uint32_t _expiry;   // in ticks of the wheel
+    uint32_t _period;
+};
+
+class TimerWheel
+{
+public:
+    typedef void (*ExpiryCallback)(WheelNode *node, void *ctx);
+
+    explicit TimerWheel(uint32_t now = 0);
+
+    uint32_t now(void) const
+    {
+        return _now;
+    }
+
+    // (re)start a periodic timer, first expiry at the next multiple of period after "from",
+    // the current time when the wheel lags behind it (advance() not called yet)
+    void start(WheelNode *node, uint32_t period, uint32_t from);
+    void stop(WheelNode *node);
+
+    // run the wheel to tick "to", calling cb for each timer expired; returns their number
+    uint16_t advance(uint32_t to, ExpiryCallback cb, void *ctx);
+
+    // earliest expiry of all timers, false if there is none
+    bool nextExpiry(uint32_t *expiry) const;
+
+private:
+    WheelNode *_slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint32_t _now;
+    uint16_t _count; // timers in the wheel, none: advance() jumps
+
+    void insert(WheelNode *node);
+    void unlink(WheelNode *node);
+    void cascade(int level);
+    bool earliest(int level, uint32_t *expiry) const;
+};
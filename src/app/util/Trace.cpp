@@ -0,0 +1,139 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <esp_timer.h>
+#include <string.h>
+#include "./Trace.h"
+#include "../AppLog.h"
+
+Trace::Ring Trace::_rings[TRACE_RINGS];
+std::atomic<uint8_t> Trace::_ringCount(0);
+portMUX_TYPE Trace::_mux = portMUX_INITIALIZER_UNLOCKED;
+const char *Trace::_queueNames[TRACE_QUEUES];
+uint8_t Trace::_queueCount = 0;
+std::atomic<bool> Trace::_isEnabled(true);
+uint32_t Trace::_untracked = 0;
+
+// runs in the static constructors, before any task
+uint8_t Trace::addQueue(const char *name)
+{
+    if (_queueCount >= TRACE_QUEUES)
+    {
+        return TRACE_NO_QUEUE;
+    }
+    _queueNames[_queueCount] = name;
+    return _queueCount++;
+}
+
+void Trace::record(TraceKind kind, uint8_t queue, int16_t event, int16_t iParam, uint16_t left)
+{
+#if TRACE
+    if (!isEnabled())
+    {
+        return;
+    }
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    Ring *ring = nullptr;
+    uint8_t count = _ringCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+        if (_rings[i].task == task)
+        {
+            ring = &_rings[i];
+            break;
+        }
+    }
+    if (!ring && !(ring = claim(task)))
+    {
+        return;
+    }
+
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    TraceRecord &record = ring->records[head & (TRACE_RECORDS - 1)];
+    record.us = (uint32_t)esp_timer_get_time();
+    record.event = event;
+    record.iParam = iParam;
+    record.kind = kind;
+    record.queue = queue;
+    record.left = left;
+    ring->head.store(head + 1, std::memory_order_release);
+#endif
+}
+
+// first record of a task; only the task itself claims its ring, the lock is for the count
+Trace::Ring *Trace::claim(TaskHandle_t task)
+{
+    Ring *ring = nullptr;
+    portENTER_CRITICAL(&_mux);
+    uint8_t count = _ringCount.load(std::memory_order_relaxed);
+    if (count < TRACE_RINGS)
+    {
+        ring = &_rings[count];
+        ring->task = task;
+        _ringCount.store(count + 1, std::memory_order_release);
+    }
+    else
+    {
+        _untracked++;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return ring;
+}
+
+void Trace::report(void)
+{
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint8_t count = _ringCount.load(std::memory_order_acquire);
+    PRINTLN("trace: ", isEnabled() ? "on" : "off", ", ", _queueCount, " queues, ", count, "/", TRACE_RINGS,
+            " rings of ", TRACE_RECORDS, " records, untracked=", _untracked);
+    for (int i = 0; i < count; i++)
+    {
+        const Ring &ring = _rings[i];
+        uint32_t written = ring.head.load(std::memory_order_acquire);
+        uint32_t kept = written < TRACE_RECORDS ? written : TRACE_RECORDS;
+        uint32_t oldest = kept ? ring.records[(written - kept) & (TRACE_RECORDS - 1)].us : now;
+        PRINTLN("  ", pcTaskGetName(ring.task), ": written=", written, ", kept=", kept, ", covering the last ", (now - oldest) / 1000, " ms");
+    }
+}
+
+void Trace::fillHeader(TraceHeader *header)
+{
+    uint64_t now = esp_timer_get_time();
+    memset(header, 0, sizeof(*header));
+    header->magic = TRACE_MAGIC;
+    header->version = TRACE_VERSION;
+    header->recordSize = sizeof(TraceRecord);
+    header->nowLow = (uint32_t)now;
+    header->nowHigh = (uint32_t)(now >> 32);
+    header->queueCount = _queueCount;
+    header->ringCount = _ringCount.load(std::memory_order_acquire);
+    header->recordsPerRing = TRACE_RECORDS;
+    portENTER_CRITICAL(&_mux);
+    header->untracked = _untracked;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void Trace::copyName(char *dest, const char *name)
+{
+    memset(dest, 0, TRACE_NAME_SIZE);
+    if (name)
+    {
+        strncpy(dest, name, TRACE_NAME_SIZE - 1);
+    }
+}
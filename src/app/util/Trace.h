@@ -0,0 +1,199 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "../ArduProfFreeRTOS.h"
+#include "./TraceRecord.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Message trace: post, dequeue, handler start and handler end of every message, with the
+// event, the queue, the task and the time in us, to find where an alert spent its time
+//   QueueStats::post() records the posts, QueueStats::onReceive() the dequeues, and the
+//   threads bracket their handlers with start()/end(). Messages posted straight to a queue
+//   (ISRs, WiFi events) have their dequeue recorded, not their post.
+//   Each task writes a ring of its own, claimed on its first record: one writer per ring,
+//   so a record is a lookup of the task among a few, a timer read and a 12-byte store, with
+//   no lock and no read-modify-write, which the ESP32-C3 (no "A" extension) would emulate
+//   by masking interrupts. Cheap enough to stay on in the field.
+//   A busy ring wraps sooner than the others; tools/trace drops the records older than
+//   the oldest of the wrapped rings, so every task is covered over the same window.
+//   dump() pauses the recording and streams the TraceRecord.h format to a writer: an
+//   HttpChunkedWriter or a TraceHexWriter on Serial. A record which a preempted task was
+//   writing at that moment may be torn.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define TRACE 1             // 0: nothing is recorded
+#define TRACE_RINGS 5       // tasks traced: loopTask, ThreadNpu, ThreadMessaging, Tmr Svc, one spare
+#define TRACE_RECORDS 256   // per ring, a power of two, 12 bytes each
+#define TRACE_QUEUES 8
+
+class Trace
+{
+public:
+    // a queue id for the records, called by the QueueStats constructors
+    static uint8_t addQueue(const char *name);
+
+    static void post(uint8_t queue, TraceKind kind, int16_t event, int16_t iParam)
+    {
+        record(kind, queue, event, iParam, 0);
+    }
+    static void dequeue(uint8_t queue, const Message &msg, uint16_t left)
+    {
+        record(TraceDequeue, queue, msg.event, msg.iParam, left);
+    }
+    static void start(const Message &msg)
+    {
+        record(TraceStart, TRACE_NO_QUEUE, msg.event, msg.iParam, 0);
+    }
+    static void end(const Message &msg)
+    {
+        record(TraceEnd, TRACE_NO_QUEUE, msg.event, msg.iParam, 0);
+    }
+
+    static void setEnabled(bool isEnabled)
+    {
+        _isEnabled.store(isEnabled, std::memory_order_relaxed);
+    }
+    static bool isEnabled(void)
+    {
+        return _isEnabled.load(std::memory_order_relaxed);
+    }
+    static void report(void);
+
+    // write the dump, return false when the writer failed
+    template <typename Writer>
+    static bool dump(Writer &writer)
+    {
+        bool wasEnabled = isEnabled();
+        setEnabled(false);
+        TraceHeader header;
+        fillHeader(&header);
+        bool isOk = put(writer, &header, sizeof(header));
+        for (int i = 0; i < _queueCount && isOk; i++)
+        {
+            TraceName name;
+            copyName(name.name, _queueNames[i]);
+            isOk = put(writer, &name, sizeof(name));
+        }
+        for (int i = 0; i < header.ringCount && isOk; i++)
+        {
+            const Ring &ring = _rings[i];
+            TraceRingHeader ringHeader;
+            copyName(ringHeader.name, pcTaskGetName(ring.task));
+            ringHeader.written = ring.head.load(std::memory_order_acquire);
+            ringHeader.count = ringHeader.written < TRACE_RECORDS ? ringHeader.written : TRACE_RECORDS;
+            isOk = put(writer, &ringHeader, sizeof(ringHeader));
+
+            // oldest first: from the slot of the oldest record up to the end, then the rest
+            uint32_t first = (ringHeader.written - ringHeader.count) & (TRACE_RECORDS - 1);
+            uint32_t tail = TRACE_RECORDS - first < ringHeader.count ? TRACE_RECORDS - first : ringHeader.count;
+            isOk = isOk && put(writer, &ring.records[first], tail * sizeof(TraceRecord)) &&
+                   put(writer, &ring.records[0], (ringHeader.count - tail) * sizeof(TraceRecord));
+        }
+        setEnabled(wasEnabled);
+        return isOk;
+    }
+
+private:
+    struct Ring
+    {
+        TaskHandle_t task;
+        std::atomic<uint32_t> head; // records written, by the task only
+        TraceRecord records[TRACE_RECORDS];
+    };
+    static_assert((TRACE_RECORDS & (TRACE_RECORDS - 1)) == 0, "TRACE_RECORDS must be a power of two");
+
+    static Ring _rings[TRACE_RINGS];
+    static std::atomic<uint8_t> _ringCount;
+    static portMUX_TYPE _mux;
+    static const char *_queueNames[TRACE_QUEUES];
+    static uint8_t _queueCount;
+    static std::atomic<bool> _isEnabled;
+    static uint32_t _untracked; // under _mux
+
+    static void record(TraceKind kind, uint8_t queue, int16_t event, int16_t iParam, uint16_t left);
+    static Ring *claim(TaskHandle_t task);
+    static void fillHeader(TraceHeader *header);
+    static void copyName(char *dest, const char *name);
+
+    template <typename Writer>
+    static bool put(Writer &writer, const void *data, size_t length)
+    {
+        return length == 0 || writer.write((const uint8_t *)data, length) == length;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// A dump as text lines on a Stream (Serial), between TRACE_HEX_BEGIN and TRACE_HEX_END:
+// TRACE_HEX_PREFIX then TRACE_HEX_BYTES bytes in hex. tools/trace reads them from a capture
+// of the serial output, which may have log lines in between.
+////////////////////////////////////////////////////////////////////////////////////////////
+class TraceHexWriter
+{
+public:
+    TraceHexWriter(Stream &stream) : _stream(stream), _length(0)
+    {
+        _stream.println(TRACE_HEX_BEGIN);
+    }
+
+    size_t write(const uint8_t *data, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            _line[_length++] = data[i];
+            if (_length == TRACE_HEX_BYTES)
+            {
+                flush();
+            }
+        }
+        return length;
+    }
+
+    void finish(void)
+    {
+        flush();
+        _stream.println(TRACE_HEX_END);
+    }
+
+private:
+    Stream &_stream;
+    uint8_t _line[TRACE_HEX_BYTES];
+    uint8_t _length;
+
+    void flush(void)
+    {
+        if (_length == 0)
+        {
+            return;
+        }
+        static const char digits[] = "0123456789abcdef";
+        char text[1 + TRACE_HEX_BYTES * 2 + 1];
+        int n = 0;
+        text[n++] = TRACE_HEX_PREFIX;
+        for (int i = 0; i < _length; i++)
+        {
+            text[n++] = digits[_line[i] >> 4];
+            text[n++] = digits[_line[i] & 0xf];
+        }
+        text[n] = '\0';
+        _stream.println(text);
+        _length = 0;
+    }
+};
@@ -0,0 +1,91 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Binary format of a message trace dump (src/app/util/Trace.h), read by tools/trace
+//   TraceHeader
+//   TraceName * queueCount           names of the queues, TraceRecord::queue indexes them
+//   for each of ringCount rings:
+//     TraceRingHeader                 name of the task which wrote the ring
+//     TraceRecord * count             oldest first
+// Little endian, as the ESP32-C3 and the Linux hosts. A serial dump carries the same bytes
+// as hex lines, see TraceHexWriter.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define TRACE_MAGIC 0x43525444 // "DTRC"
+#define TRACE_VERSION 1
+#define TRACE_NAME_SIZE 16   // configMAX_TASK_NAME_LEN of ESP-IDF
+#define TRACE_NO_QUEUE 0xff  // TraceRecord::queue of a record with no queue
+#define TRACE_HEX_BEGIN "trace dump begin"
+#define TRACE_HEX_END "trace dump end"
+#define TRACE_HEX_PREFIX '~' // first character of a hex line of a serial dump
+#define TRACE_HEX_BYTES 32   // bytes per hex line
+
+typedef enum _TraceKind : uint8_t
+{
+    TraceNull = 0,
+    TracePost,     // queue=destination, by the posting task
+    TracePostFail, // queue=destination, which was full: cancels the TracePost just before
+    TraceCoalesce, // queue=destination, merged into a pending message, see MessageCoalescer
+    TraceDequeue,  // queue=source, by the receiving task
+    TraceStart,    // handler start, by the receiving task
+    TraceEnd,      // handler end
+    TraceKindCount,
+} TraceKind;
+
+typedef struct _TraceRecord
+{
+    uint32_t us; // esp_timer_get_time(), low 32 bits
+    int16_t event;
+    int16_t iParam;
+    uint8_t kind; // TraceKind
+    uint8_t queue;
+    uint16_t left; // TraceDequeue: messages left in the queue, 0 for the other kinds
+} TraceRecord;
+
+typedef struct _TraceHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t nowLow; // esp_timer_get_time() at the dump: the records are up to 2^32 us older
+    uint32_t nowHigh;
+    uint8_t queueCount;
+    uint8_t ringCount;
+    uint16_t recordsPerRing;
+    uint32_t untracked; // records lost: every ring was taken by another task
+} TraceHeader;
+
+typedef struct _TraceName
+{
+    char name[TRACE_NAME_SIZE];
+} TraceName;
+
+typedef struct _TraceRingHeader
+{
+    char name[TRACE_NAME_SIZE];
+    uint32_t written; // records since boot, those before the last count were overwritten
+    uint32_t count;
+} TraceRingHeader;
+
+static_assert(sizeof(TraceRecord) == 12, "TraceRecord is part of the dump format");
+static_assert(sizeof(TraceHeader) == 24, "TraceHeader is part of the dump format");
+static_assert(sizeof(TraceRingHeader) == 24, "TraceRingHeader is part of the dump format");
@@ -0,0 +1,137 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "app/AppEvent.h"
+#include "app/storage/DetectionRecord.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Print the records of a "detlog" partition image read back with esptool, see README.md
+//   records are validated with their CRC and sorted by seq, so the ring order of the
+//   partition does not matter
+////////////////////////////////////////////////////////////////////////////////////////////
+static const char *decisionName(int decision)
+{
+    switch (decision)
+    {
+    case IpcNpuStrangerDetected:
+        return "stranger";
+    case IpcNpuTenderDetected:
+        return "tenant";
+    default:
+        return "?";
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-c] detlog.bin\n", name);
+    fprintf(stderr, "  -c  comma separated values instead of a table\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bool isCsv = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "c")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            isCsv = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(argv[optind], std::ios::binary);
+    if (!file)
+    {
+        fprintf(stderr, "cannot open %s\n", argv[optind]);
+        return 1;
+    }
+    std::vector<char> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<DetectionRecord> records;
+    size_t erasedCount = 0;
+    size_t corruptCount = 0;
+    for (size_t offset = 0; offset + DETECTION_RECORD_SIZE <= image.size(); offset += DETECTION_RECORD_SIZE)
+    {
+        DetectionRecord record;
+        memcpy(&record, &image[offset], sizeof(record));
+        if (record.isErased())
+        {
+            erasedCount++;
+        }
+        else if (record.isValid())
+        {
+            records.push_back(record);
+        }
+        else
+        {
+            corruptCount++;
+        }
+    }
+    std::sort(records.begin(), records.end(), [](const DetectionRecord &a, const DetectionRecord &b)
+              { return a.seq < b.seq; });
+
+    if (isCsv)
+    {
+        printf("seq,time_ms,frame,decision,target,score,track,boxes,x,y,w,h,inference_ms\n");
+    }
+    else
+    {
+        printf("%8s %10s %6s %-8s %6s %5s %5s %5s %5s %5s %5s %5s %9s\n",
+               "seq", "time(ms)", "frame", "decision", "target", "score", "track", "boxes", "x", "y", "w", "h", "infer(ms)");
+    }
+    for (const DetectionRecord &r : records)
+    {
+        printf(isCsv ? "%u,%u,%u,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u\n"
+                     : "%8u %10u %6u %-8s %6u %5u %5u %5u %5u %5u %5u %5u %9u\n",
+               (unsigned)r.seq, (unsigned)r.timeMs, (unsigned)r.frameSeq, decisionName(r.decision), (unsigned)r.target,
+               (unsigned)r.score, (unsigned)r.trackId, (unsigned)r.boxCount, (unsigned)r.x, (unsigned)r.y, (unsigned)r.w,
+               (unsigned)r.h, (unsigned)r.inferenceMs);
+    }
+
+    // a gap in seq means a whole sector was recycled or a batch was lost
+    size_t gapCount = 0;
+    for (size_t i = 1; i < records.size(); i++)
+    {
+        if (records[i].seq != records[i - 1].seq + 1)
+        {
+            gapCount++;
+        }
+    }
+    fprintf(stderr, "%zu records, %zu erased slots, %zu corrupt, %zu seq gaps\n", records.size(), erasedCount, corruptCount, gapCount);
+    return 0;
+}
@@ -0,0 +1,37 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Minimal host stand-in for https://github.com/teamprof/arduprof: the Message type and the
+// handler macros, which is all EventDispatch.h needs
+////////////////////////////////////////////////////////////////////////////////////////////
+typedef struct _Message
+{
+    int16_t event;
+    int16_t iParam;
+    uint16_t uParam;
+    uint32_t lParam;
+} Message;
+
+#define __EVENT_MAP(cls, event) {(event), &cls::handler##event}
+#define __EVENT_FUNC_DECLARATION(event) void handler##event(const Message &msg);
+#define __EVENT_FUNC_DEFINITION(cls, event, msg) void cls::handler##event(const Message &msg)
@@ -0,0 +1,220 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <vector>
+#include "app/AppEvent.h"
+#include "app/util/EventDispatch.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// EventDispatch against the std::map<int16_t, handlerFunc> handlerMap it replaces, on the
+// event table of QueueMain and a message mix of a doorbell at work: mostly NPU frames and
+// timer ticks, some GPIO edges and a few events QueueMain has no handler for
+////////////////////////////////////////////////////////////////////////////////////////////
+#define DISPATCHBENCH_MESSAGES 10000000 // default number of dispatches per method
+
+class Target
+{
+public:
+    Target() : handlerMap(), count(0), unsupportedCount(0)
+    {
+        handlerMap = {
+            __EVENT_MAP(Target, EventIpc),
+            __EVENT_MAP(Target, EventNpuFrame),
+            __EVENT_MAP(Target, EventMessageStatus),
+            __EVENT_MAP(Target, EventInternetStatus),
+            __EVENT_MAP(Target, EventGpioISR),
+            __EVENT_MAP(Target, EventSystem),
+            __EVENT_MAP(Target, EventNull),
+        };
+    }
+
+    // the onMessage() of QueueMain before EventDispatch
+    void onMessageMap(const Message &msg)
+    {
+        auto func = handlerMap[msg.event];
+        if (func)
+        {
+            (this->*func)(msg);
+        }
+        else
+        {
+            unsupportedCount++;
+        }
+    }
+
+    void onMessageDispatch(const Message &msg);
+
+    typedef void (Target::*handlerFunc)(const Message &);
+    std::map<int16_t, handlerFunc> handlerMap;
+    uint64_t count;
+    uint64_t unsupportedCount;
+
+    __EVENT_FUNC_DECLARATION(EventIpc)
+    __EVENT_FUNC_DECLARATION(EventNpuFrame)
+    __EVENT_FUNC_DECLARATION(EventMessageStatus)
+    __EVENT_FUNC_DECLARATION(EventInternetStatus)
+    __EVENT_FUNC_DECLARATION(EventGpioISR)
+    __EVENT_FUNC_DECLARATION(EventSystem)
+    __EVENT_FUNC_DECLARATION(EventNull)
+    void handlerUnsupported(const Message &msg);
+
+    typedef EventDispatch<Target, &Target::handlerUnsupported,
+                          __EVENT_ENTRY(Target, EventIpc),
+                          __EVENT_ENTRY(Target, EventNpuFrame),
+                          __EVENT_ENTRY(Target, EventMessageStatus),
+                          __EVENT_ENTRY(Target, EventInternetStatus),
+                          __EVENT_ENTRY(Target, EventGpioISR),
+                          __EVENT_ENTRY(Target, EventSystem),
+                          __EVENT_ENTRY(Target, EventNull)>
+        Dispatch;
+};
+
+void Target::onMessageDispatch(const Message &msg)
+{
+    Dispatch::dispatch(*this, msg);
+}
+
+// out of line and not inlined, as the handlers of QueueMain are
+#define BENCH_HANDLER(event)                                          \
+    __attribute__((noinline)) __EVENT_FUNC_DEFINITION(Target, event, msg) \
+    {                                                                     \
+        count += msg.iParam;                                              \
+    }
+BENCH_HANDLER(EventIpc)
+BENCH_HANDLER(EventNpuFrame)
+BENCH_HANDLER(EventMessageStatus)
+BENCH_HANDLER(EventInternetStatus)
+BENCH_HANDLER(EventGpioISR)
+BENCH_HANDLER(EventSystem)
+BENCH_HANDLER(EventNull)
+
+__attribute__((noinline)) void Target::handlerUnsupported(const Message &msg)
+{
+    unsupportedCount++;
+}
+
+static std::vector<Message> makeMessages(int unsupportedPercent)
+{
+    static const struct
+    {
+        int16_t event;
+        int weight;
+    } mix[] = {
+        {EventNpuFrame, 50},
+        {EventSystem, 30}, // timers, console, buttons
+        {EventGpioISR, 10},
+        {EventIpc, 6},
+        {EventMessageStatus, 2},
+        {EventInternetStatus, 2},
+    };
+
+    std::vector<Message> messages(4096);
+    uint32_t seed = 1;
+    for (Message &msg : messages)
+    {
+        seed = seed * 1103515245 + 12345;
+        int r = (seed >> 16) % 100;
+        msg = {EventNull, 1, 0, 0};
+        if (r < unsupportedPercent)
+        {
+            msg.event = EventWifiStatus + (seed >> 8) % 64; // ThreadMessaging events, and beyond
+            continue;
+        }
+        r = (seed >> 4) % 100;
+        for (const auto &m : mix)
+        {
+            if (r < m.weight)
+            {
+                msg.event = m.event;
+                break;
+            }
+            r -= m.weight;
+        }
+    }
+    return messages;
+}
+
+template <typename F>
+static double nsPerMessage(const std::vector<Message> &messages, int count, F onMessage)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        onMessage(messages[i & (messages.size() - 1)]);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / count;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n messages] [-u unsupported_percent]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    int count = DISPATCHBENCH_MESSAGES;
+    int unsupportedPercent = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:u:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 'u':
+            unsupportedPercent = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Message> messages = makeMessages(unsupportedPercent);
+    Target mapTarget;
+    Target dispatchTarget;
+    size_t mapSize = mapTarget.handlerMap.size();
+
+    double mapNs = nsPerMessage(messages, count, [&](const Message &msg)
+                                { mapTarget.onMessageMap(msg); });
+    double dispatchNs = nsPerMessage(messages, count, [&](const Message &msg)
+                                     { dispatchTarget.onMessageDispatch(msg); });
+
+    if (mapTarget.count != dispatchTarget.count || mapTarget.unsupportedCount != dispatchTarget.unsupportedCount)
+    {
+        printf("FAIL: map handled %llu / %llu unsupported, EventDispatch %llu / %llu\n",
+               (unsigned long long)mapTarget.count, (unsigned long long)mapTarget.unsupportedCount,
+               (unsigned long long)dispatchTarget.count, (unsigned long long)dispatchTarget.unsupportedCount);
+        return 1;
+    }
+
+    printf("%d messages, %d%% unsupported\n", count, unsupportedPercent);
+    printf("  std::map      : %6.2f ns/message, handlerMap grew from %zu to %zu entries\n", mapNs, mapSize,
+           mapTarget.handlerMap.size());
+    printf("  EventDispatch : %6.2f ns/message, %zu byte table, no heap\n", dispatchNs, Target::Dispatch::Span);
+    return 0;
+}
@@ -0,0 +1,280 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <pthread.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <deque>
+#include <Arduino.h>
+#include <DebugLog.h>
+#include <FunctionalInterrupt.h>
+#include <driver/gpio.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+DebugLogLevel hostlog::level = DebugLogLevel::LVL_TRACE;
+bool hostlog::hexMode = false;
+
+void hostlog::emit(DebugLogLevel lvl, const std::string &line)
+{
+    printf("%s\n", line.c_str());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// time
+/////////////////////////////////////////////////////////////////////////////
+uint32_t millis(void)
+{
+    return (uint32_t)(hostrtos::nowUs() / 1000);
+}
+
+uint32_t micros(void)
+{
+    return (uint32_t)hostrtos::nowUs();
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)hostrtos::nowUs();
+}
+
+void delay(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+uint32_t getCpuFrequencyMhz(void)
+{
+    return 160;
+}
+
+size_t getArduinoLoopTaskStackSize(void)
+{
+    return 8192; // ARDUINO_LOOP_STACK_SIZE
+}
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return ESP_RST_POWERON;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GPIO
+/////////////////////////////////////////////////////////////////////////////
+struct HostPin
+{
+    int level;
+    int mode; // interrupt mode, 0: none
+    bool isMasked;
+    void (*fn)(void *);
+    void *arg;
+    std::function<void(void)> func;
+};
+static HostPin pins[GPIO_NUM_MAX];
+static portMUX_TYPE pinsLock = portMUX_INITIALIZER_UNLOCKED;
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    // the buttons and the strapping pin BOOT idle high
+    if (pin < GPIO_NUM_MAX && (mode == INPUT_PULLUP || pin == GPIO_NUM_9))
+    {
+        portENTER_CRITICAL(&pinsLock);
+        pins[pin].level = HIGH;
+        portEXIT_CRITICAL(&pinsLock);
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= GPIO_NUM_MAX)
+    {
+        return LOW;
+    }
+    portENTER_CRITICAL(&pinsLock);
+    int level = pins[pin].level;
+    portEXIT_CRITICAL(&pinsLock);
+    return level;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin >= GPIO_NUM_MAX)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&pinsLock);
+    HostPin &p = pins[pin];
+    int old = p.level;
+    p.level = value ? HIGH : LOW;
+    bool isEdge = (p.mode == CHANGE && old != p.level) ||
+                  (p.mode == RISING && old == LOW && p.level == HIGH) ||
+                  (p.mode == FALLING && old == HIGH && p.level == LOW);
+    if (isEdge && !p.isMasked && (p.fn || p.func))
+    {
+        hostrtos::isr([&p]()
+                      {
+                          if (p.fn)
+                          {
+                              p.fn(p.arg);
+                          }
+                          else
+                          {
+                              p.func();
+                          } });
+    }
+    portEXIT_CRITICAL(&pinsLock);
+}
+
+void attachInterruptArg(uint8_t pin, void (*fn)(void *), void *arg, int mode)
+{
+    portENTER_CRITICAL(&pinsLock);
+    pins[pin].fn = fn;
+    pins[pin].arg = arg;
+    pins[pin].mode = mode;
+    portEXIT_CRITICAL(&pinsLock);
+}
+
+void attachInterrupt(uint8_t pin, void (*fn)(void), int mode)
+{
+    portENTER_CRITICAL(&pinsLock);
+    pins[pin].func = fn;
+    pins[pin].mode = mode;
+    portEXIT_CRITICAL(&pinsLock);
+}
+
+void attachInterrupt(uint8_t pin, std::function<void(void)> fn, int mode)
+{
+    portENTER_CRITICAL(&pinsLock);
+    pins[pin].func = fn;
+    pins[pin].mode = mode;
+    portEXIT_CRITICAL(&pinsLock);
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    portENTER_CRITICAL(&pinsLock);
+    pins[pin].fn = nullptr;
+    pins[pin].func = nullptr;
+    pins[pin].mode = 0;
+    portEXIT_CRITICAL(&pinsLock);
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t pin)
+{
+    if (pin >= GPIO_NUM_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&pinsLock);
+    pins[pin].isMasked = true;
+    portEXIT_CRITICAL(&pinsLock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t pin)
+{
+    if (pin >= GPIO_NUM_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&pinsLock);
+    pins[pin].isMasked = false;
+    portEXIT_CRITICAL(&pinsLock);
+    return ESP_OK;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Serial
+/////////////////////////////////////////////////////////////////////////////
+static pthread_mutex_t inputLock = PTHREAD_MUTEX_INITIALIZER;
+static std::deque<char> input;
+
+void hostSerialInput(const char *text)
+{
+    pthread_mutex_lock(&inputLock);
+    input.insert(input.end(), text, text + strlen(text));
+    pthread_mutex_unlock(&inputLock);
+}
+
+// stdin is typed on the console, up to its end
+static void *stdinMain(void *arg)
+{
+    char buf[64];
+    ssize_t n;
+    while ((n = ::read(STDIN_FILENO, buf, sizeof(buf) - 1)) > 0)
+    {
+        buf[n] = '\0';
+        hostSerialInput(buf);
+    }
+    return nullptr;
+}
+
+// not on virtual time: the input comes from the scenario only, so that a run is repeatable
+void HardwareSerial::begin(unsigned long baud)
+{
+    if (hostrtos::isVirtualTime())
+    {
+        return;
+    }
+    pthread_t thread;
+    pthread_create(&thread, nullptr, stdinMain, nullptr);
+    pthread_detach(thread);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t size)
+{
+    return fwrite(buf, 1, size, stdout);
+}
+
+int HardwareSerial::available(void)
+{
+    pthread_mutex_lock(&inputLock);
+    int n = (int)input.size();
+    pthread_mutex_unlock(&inputLock);
+    return n;
+}
+
+int HardwareSerial::read(void)
+{
+    pthread_mutex_lock(&inputLock);
+    int c = -1;
+    if (!input.empty())
+    {
+        c = (unsigned char)input.front();
+        input.pop_front();
+    }
+    pthread_mutex_unlock(&inputLock);
+    return c;
+}
+
+size_t Print::printf(const char *fmt, ...)
+{
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return write((const uint8_t *)buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+}
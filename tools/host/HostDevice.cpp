@@ -0,0 +1,209 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <Seeed_Arduino_SSCMA.h>
+#include <Wire.h>
+#include <driver/gpio.h>
+#include <esp_partition.h>
+#include <esp_pm.h>
+
+TwoWire Wire;
+
+/////////////////////////////////////////////////////////////////////////////
+// SSCMA
+/////////////////////////////////////////////////////////////////////////////
+static std::map<std::string, MockSSCMA> scenes; // loaded recordings, by path
+static const MockSSCMA emptyScene;
+static const MockSSCMA *scene = &emptyScene;
+static uint32_t sceneSeq = 1; // changed with scene
+static uint32_t sceneStartMs = 0;
+static uint32_t inferences = 0;
+
+bool hostSceneLoad(const char *path, uint32_t framePeriodMs)
+{
+    if (!path)
+    {
+        scene = &emptyScene;
+        sceneSeq++;
+        return true;
+    }
+
+    auto it = scenes.find(path);
+    if (it == scenes.end())
+    {
+        MockSSCMA recording;
+        int line = 0;
+        if (!recording.load(path, &line))
+        {
+            fprintf(stderr, "%s:%d: invalid recording\n", path, line);
+            return false;
+        }
+        it = scenes.insert(std::make_pair(std::string(path), recording)).first;
+    }
+    it->second.setFramePeriod(framePeriodMs);
+    scene = &it->second;
+    sceneSeq++;
+    return true;
+}
+
+void hostSceneStart(void)
+{
+    sceneStartMs = millis();
+}
+
+uint32_t hostInferences(void)
+{
+    return inferences;
+}
+
+bool SSCMA::begin(TwoWire *wire, int32_t rst, uint16_t address, uint32_t wait_delay, uint32_t clock)
+{
+    return true;
+}
+
+// blocks for the preprocess + inference + postprocess time of the frame, as the I2C wait
+int SSCMA::invoke(int times, bool filter, bool show)
+{
+    if (_sceneSeq != sceneSeq)
+    {
+        static_cast<MockSSCMA &>(*this) = *scene;
+        _sceneSeq = sceneSeq;
+    }
+    setTime(millis() - sceneStartMs);
+    int rc = MockSSCMA::invoke(times, filter, show);
+    inferences++;
+    uint32_t ms = perf().prepocess + perf().inference + perf().postprocess;
+    if (ms)
+    {
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+    return rc;
+}
+
+int SSCMA::available(void)
+{
+    return 0;
+}
+
+int SSCMA::read(char *data, int length)
+{
+    return 0;
+}
+
+int SSCMA::write(const char *data, int length)
+{
+    return length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// flash partition
+/////////////////////////////////////////////////////////////////////////////
+#define SECTOR_SIZE 4096
+
+static esp_partition_t detlog = {ESP_PARTITION_TYPE_DATA, 0x40, 0x3d0000, 0x20000, "detlog"};
+static std::vector<uint8_t> flash(0x20000, 0xff);
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+    return (label && strcmp(label, detlog.label) == 0) ? &detlog : nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset, void *dst, size_t size)
+{
+    if (offset + size > flash.size())
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, &flash[offset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *src, size_t size)
+{
+    if (offset + size > flash.size())
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t *bytes = static_cast<const uint8_t *>(src);
+    for (size_t i = 0; i < size; i++)
+    {
+        flash[offset + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if (offset % SECTOR_SIZE || size % SECTOR_SIZE || offset + size > flash.size())
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&flash[offset], 0xff, size);
+    return ESP_OK;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// power management
+/////////////////////////////////////////////////////////////////////////////
+struct esp_pm_lock
+{
+    esp_pm_lock_type_t type;
+    int count;
+};
+
+esp_err_t esp_pm_configure(const void *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char *name, esp_pm_lock_handle_t *handle)
+{
+    *handle = new esp_pm_lock{type, 0};
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle)
+{
+    if (handle->count)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle)
+{
+    handle->count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle)
+{
+    if (handle->count == 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->count--;
+    return ESP_OK;
+}
@@ -0,0 +1,901 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "HostRtos.h"
+
+#define NEVER UINT64_MAX
+#define LOOP_TASK_PRIORITY 1 // loopTask of the Arduino core, runs setup() and loop()
+
+typedef enum _TaskState : uint8_t
+{
+    TaskReady = 0,
+    TaskRunning,
+    TaskBlocked,
+    TaskDeleted,
+} TaskState;
+
+struct HostTask
+{
+    const char *name;
+    UBaseType_t priority;
+    uint32_t stackDepth;
+    TaskFunction_t fn;
+    void *param;
+    pthread_t thread;
+    pthread_cond_t cv;
+    TaskState state;
+    uint32_t readySeq; // FIFO order among the ready tasks of a priority
+    uint64_t wakeUs;   // end of the block, NEVER: no timeout
+    bool isTimedOut;
+};
+
+struct HostQueue
+{
+    std::vector<uint8_t> storage;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+    HostQueue *set;
+};
+
+struct HostTimer
+{
+    const char *name;
+    TickType_t period;
+    bool isAutoReload;
+    void *id;
+    TimerCallbackFunction_t cb;
+    bool isActive;
+    uint64_t expiryUs;
+};
+
+// the kernel lock guards every structure below; a task holds it only inside these calls
+static pthread_mutex_t kernelLock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<HostTask *> tasks;
+static HostTask *current = nullptr; // the task owning the core, nullptr: idle
+static uint32_t readySeq = 0;
+static HostTask *timerTask = nullptr;
+static std::vector<HostTimer *> timers;
+
+static thread_local HostTask *self = nullptr;
+static thread_local int isrDepth = 0;
+static thread_local int criticalDepth = 0; // no task switch inside a critical section
+
+static struct timespec epoch;
+static pthread_once_t startOnce = PTHREAD_ONCE_INIT;
+
+static bool isVirtual = false; // virtual time, see hostrtos::useVirtualTime()
+static uint64_t virtualUs = 0; // the virtual clock, moved by the thread owning the core
+static bool isAdvancing = false; // advance() runs the events, no task owns the core
+
+struct Event
+{
+    uint64_t us;
+    uint32_t seq; // FIFO among the events of the same time
+    std::function<void(void)> fn;
+};
+
+static pthread_mutex_t eventLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t eventCv;
+static std::vector<Event> events;
+static uint32_t eventSeq = 0;
+static pthread_once_t eventOnce = PTHREAD_ONCE_INIT;
+
+static void startKernel(void);
+static void *taskEntry(void *arg);
+
+/////////////////////////////////////////////////////////////////////////////
+// clock
+/////////////////////////////////////////////////////////////////////////////
+static uint64_t monotonicUs(void)
+{
+    if (isVirtual)
+    {
+        return virtualUs;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(ts.tv_sec - epoch.tv_sec) * 1000000 + (ts.tv_nsec - epoch.tv_nsec) / 1000;
+}
+
+static struct timespec toTimespec(uint64_t us)
+{
+    struct timespec ts = epoch;
+    uint64_t ns = (uint64_t)ts.tv_nsec + (us % 1000000) * 1000;
+    ts.tv_sec += us / 1000000 + ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    return ts;
+}
+
+static uint64_t deadline(TickType_t ticks)
+{
+    return ticks == portMAX_DELAY ? NEVER : monotonicUs() + (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+// index of the earliest event, events.size() if none; with the event lock held
+static size_t firstEvent(void)
+{
+    size_t first = events.size();
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        if (first == events.size() || events[i].us < events[first].us ||
+            (events[i].us == events[first].us && (int32_t)(events[i].seq - events[first].seq) < 0))
+        {
+            first = i;
+        }
+    }
+    return first;
+}
+
+// remove the earliest event due at limitUs or before
+static bool takeEvent(uint64_t limitUs, Event *event)
+{
+    pthread_mutex_lock(&eventLock);
+    size_t first = firstEvent();
+    bool isTaken = first < events.size() && events[first].us <= limitUs;
+    if (isTaken)
+    {
+        *event = events[first];
+        events.erase(events.begin() + first);
+    }
+    pthread_mutex_unlock(&eventLock);
+    return isTaken;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// scheduler, all with the kernel lock held
+/////////////////////////////////////////////////////////////////////////////
+static HostTask *highestReady(void)
+{
+    HostTask *next = nullptr;
+    for (HostTask *task : tasks)
+    {
+        if (task->state == TaskReady &&
+            (!next || task->priority > next->priority ||
+             (task->priority == next->priority && (int32_t)(task->readySeq - next->readySeq) < 0)))
+        {
+            next = task;
+        }
+    }
+    return next;
+}
+
+static void makeReady(HostTask *task, bool isTimedOut);
+
+// virtual time, no task ready: move the clock to the next event or timeout, and run it
+static HostTask *advance(void)
+{
+    HostTask *next;
+    isAdvancing = true;
+    while (!(next = highestReady()))
+    {
+        uint64_t wakeUs = NEVER;
+        for (HostTask *task : tasks)
+        {
+            if (task->state == TaskBlocked && task->wakeUs < wakeUs)
+            {
+                wakeUs = task->wakeUs;
+            }
+        }
+
+        Event event;
+        if (takeEvent(wakeUs, &event))
+        {
+            virtualUs = event.us > virtualUs ? event.us : virtualUs;
+            pthread_mutex_unlock(&kernelLock);
+            hostrtos::isr(event.fn);
+            pthread_mutex_lock(&kernelLock);
+        }
+        else if (wakeUs != NEVER)
+        {
+            virtualUs = wakeUs > virtualUs ? wakeUs : virtualUs;
+            for (HostTask *task : tasks)
+            {
+                if (task->state == TaskBlocked && task->wakeUs <= virtualUs)
+                {
+                    makeReady(task, true);
+                }
+            }
+        }
+        else
+        {
+            fflush(stdout);
+            fprintf(stderr, "virtual time: every task blocked forever, no event left\n");
+            _exit(1);
+        }
+    }
+    isAdvancing = false;
+    return next;
+}
+
+// give the core to the highest priority ready task; current is nullptr
+static void schedule(void)
+{
+    HostTask *next = highestReady();
+    if (!next && isVirtual)
+    {
+        next = advance();
+    }
+    current = next;
+    if (next)
+    {
+        next->state = TaskRunning;
+        pthread_cond_signal(&next->cv);
+    }
+}
+
+static void makeReady(HostTask *task, bool isTimedOut)
+{
+    task->state = TaskReady;
+    task->readySeq = ++readySeq;
+    task->isTimedOut = isTimedOut;
+    if (!current && !isAdvancing)
+    {
+        schedule();
+    }
+}
+
+// wait on the pthread of task until it owns the core
+static void waitForCore(HostTask *task)
+{
+    while (current != task)
+    {
+        if (!isVirtual && task->state == TaskBlocked && task->wakeUs != NEVER)
+        {
+            struct timespec ts = toTimespec(task->wakeUs);
+            if (pthread_cond_timedwait(&task->cv, &kernelLock, &ts) == ETIMEDOUT && task->state == TaskBlocked)
+            {
+                makeReady(task, true);
+            }
+        }
+        else
+        {
+            pthread_cond_wait(&task->cv, &kernelLock);
+        }
+    }
+}
+
+// block the running task until makeReady() or wakeUs; true on timeout
+static bool block(HostTask *task, uint64_t wakeUs)
+{
+    task->state = TaskBlocked;
+    task->wakeUs = wakeUs;
+    task->isTimedOut = false;
+    current = nullptr;
+    schedule();
+    waitForCore(task);
+    return task->isTimedOut;
+}
+
+// a task of higher priority got ready: the running task yields the core, as on preemption
+static void preemptIfNeeded(void)
+{
+    if (!self || current != self || isrDepth > 0 || criticalDepth > 0)
+    {
+        return;
+    }
+    HostTask *next = highestReady();
+    if (next && next->priority > self->priority)
+    {
+        self->state = TaskReady;
+        self->readySeq = ++readySeq;
+        current = nullptr;
+        schedule();
+        waitForCore(self);
+    }
+}
+
+static bool canBlock(void)
+{
+    return self && current == self && isrDepth == 0 && criticalDepth == 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// tasks
+/////////////////////////////////////////////////////////////////////////////
+static HostTask *newTask(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param, UBaseType_t priority)
+{
+    HostTask *task = new HostTask();
+    task->name = name;
+    task->priority = priority;
+    task->stackDepth = stackDepth;
+    task->fn = fn;
+    task->param = param;
+    task->state = TaskReady;
+    task->wakeUs = NEVER;
+    task->isTimedOut = false;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&task->cv, &attr);
+    pthread_condattr_destroy(&attr);
+    return task;
+}
+
+static void *taskEntry(void *arg)
+{
+    HostTask *task = static_cast<HostTask *>(arg);
+    self = task;
+    pthread_mutex_lock(&kernelLock);
+    waitForCore(task);
+    pthread_mutex_unlock(&kernelLock);
+
+    task->fn(task->param);
+
+    // a FreeRTOS task must not return; if it does, it is deleted
+    pthread_mutex_lock(&kernelLock);
+    task->state = TaskDeleted;
+    current = nullptr;
+    schedule();
+    pthread_mutex_unlock(&kernelLock);
+    return nullptr;
+}
+
+// the thread of main() is loopTask, running from the first call into the kernel
+static void startKernel(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+    HostTask *loopTask = newTask(nullptr, "loopTask", 8192, nullptr, LOOP_TASK_PRIORITY);
+    loopTask->thread = pthread_self();
+    loopTask->state = TaskRunning;
+    tasks.push_back(loopTask);
+    current = loopTask;
+    self = loopTask;
+}
+
+static void ensureStarted(void)
+{
+    pthread_once(&startOnce, startKernel);
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                                           UBaseType_t priority, StackType_t *stack, StaticTask_t *buffer, BaseType_t core)
+{
+    ensureStarted();
+    HostTask *task = newTask(fn, name, stackDepth, param, priority);
+
+    pthread_mutex_lock(&kernelLock);
+    task->readySeq = ++readySeq;
+    tasks.push_back(task);
+    pthread_create(&task->thread, nullptr, taskEntry, task);
+    pthread_detach(task->thread);
+    if (!current)
+    {
+        schedule();
+    }
+    preemptIfNeeded();
+    pthread_mutex_unlock(&kernelLock);
+    return task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    ensureStarted();
+    pthread_mutex_lock(&kernelLock);
+    if (canBlock())
+    {
+        if (ticks == 0)
+        {
+            // yield to the ready tasks of the same priority
+            self->state = TaskReady;
+            self->readySeq = ++readySeq;
+            current = nullptr;
+            schedule();
+            waitForCore(self);
+        }
+        else
+        {
+            block(self, deadline(ticks));
+        }
+        pthread_mutex_unlock(&kernelLock);
+        return;
+    }
+    pthread_mutex_unlock(&kernelLock);
+
+    // a thread outside the kernel, e.g. a stimulus of main.cpp
+    struct timespec ts = {(time_t)(ticks / 1000), (long)(ticks % 1000) * 1000000};
+    nanosleep(&ts, nullptr);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    ensureStarted();
+    return (TickType_t)(monotonicUs() / 1000 / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    ensureStarted();
+    return self;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    // no stack of the app size on the host: report it untouched
+    task = task ? task : self;
+    return task ? task->stackDepth : 0;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    task = task ? task : self;
+    return task ? task->name : "";
+}
+
+BaseType_t xPortInIsrContext(void)
+{
+    return isrDepth > 0 ? pdTRUE : pdFALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// queues
+/////////////////////////////////////////////////////////////////////////////
+static std::vector<std::pair<HostTask *, HostQueue *>> receivers; // blocked receives
+
+// wake the task of highest priority blocked on a receive of queue
+static void wakeReceiver(HostQueue *queue)
+{
+    size_t best = receivers.size();
+    for (size_t i = 0; i < receivers.size(); i++)
+    {
+        if (receivers[i].second == queue &&
+            (best == receivers.size() || receivers[i].first->priority > receivers[best].first->priority))
+        {
+            best = i;
+        }
+    }
+    if (best < receivers.size())
+    {
+        HostTask *task = receivers[best].first;
+        receivers.erase(receivers.begin() + best);
+        makeReady(task, false);
+    }
+}
+
+static bool push(HostQueue *queue, const void *item)
+{
+    if (queue->count >= queue->length)
+    {
+        return false;
+    }
+    memcpy(&queue->storage[((queue->head + queue->count) % queue->length) * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+    wakeReceiver(queue);
+    if (queue->set)
+    {
+        push(queue->set, &queue);
+    }
+    return true;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t *storage, StaticQueue_t *buffer)
+{
+    ensureStarted();
+    HostQueue *queue = new HostQueue();
+    queue->storage.resize(length * itemSize);
+    queue->length = length;
+    queue->itemSize = itemSize;
+    queue->head = 0;
+    queue->count = 0;
+    queue->set = nullptr;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    ensureStarted();
+    pthread_mutex_lock(&kernelLock);
+    bool isSent = push(queue, item);
+    preemptIfNeeded();
+    pthread_mutex_unlock(&kernelLock);
+    return isSent ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken)
+{
+    pthread_mutex_lock(&kernelLock);
+    bool isSent = push(queue, item);
+    pthread_mutex_unlock(&kernelLock);
+    if (woken)
+    {
+        *woken = pdFALSE;
+    }
+    return isSent ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    ensureStarted();
+    pthread_mutex_lock(&kernelLock);
+    uint64_t wakeUs = deadline(wait);
+    while (queue->count == 0)
+    {
+        if (wait == 0 || !canBlock())
+        {
+            pthread_mutex_unlock(&kernelLock);
+            return pdFAIL;
+        }
+        receivers.push_back(std::make_pair(self, queue));
+        if (block(self, wakeUs))
+        {
+            for (size_t i = 0; i < receivers.size(); i++)
+            {
+                if (receivers[i].first == self)
+                {
+                    receivers.erase(receivers.begin() + i);
+                    break;
+                }
+            }
+            if (queue->count == 0)
+            {
+                pthread_mutex_unlock(&kernelLock);
+                return pdFAIL;
+            }
+        }
+    }
+    memcpy(item, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_mutex_unlock(&kernelLock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&kernelLock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&kernelLock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&kernelLock);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&kernelLock);
+    return spaces;
+}
+
+// a set is a queue of the handles of its member queues, one per message sent to them
+QueueSetHandle_t xQueueCreateSet(UBaseType_t length)
+{
+    return xQueueCreateStatic(length, sizeof(QueueHandle_t), nullptr, nullptr);
+}
+
+BaseType_t xQueueAddToSet(QueueHandle_t queue, QueueSetHandle_t set)
+{
+    pthread_mutex_lock(&kernelLock);
+    bool isEmpty = queue->count == 0 && !queue->set;
+    if (isEmpty)
+    {
+        queue->set = set;
+    }
+    pthread_mutex_unlock(&kernelLock);
+    return isEmpty ? pdPASS : pdFAIL;
+}
+
+QueueHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t wait)
+{
+    QueueHandle_t queue = nullptr;
+    return xQueueReceive(set, &queue, wait) == pdPASS ? queue : nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// timers
+/////////////////////////////////////////////////////////////////////////////
+static HostTimer *findTimer(TimerHandle_t handle)
+{
+    return (handle > 0 && handle <= timers.size()) ? timers[handle - 1] : nullptr;
+}
+
+// the timer daemon re-reads the timers whenever one changes
+static void kickTimerTask(void)
+{
+    if (timerTask && timerTask->state == TaskBlocked)
+    {
+        makeReady(timerTask, false);
+    }
+}
+
+TaskHandle_t xTimerGetTimerDaemonTaskHandle(void)
+{
+    pthread_mutex_lock(&kernelLock);
+    TaskHandle_t task = timerTask;
+    pthread_mutex_unlock(&kernelLock);
+    return task;
+}
+
+static void timerTaskMain(void *param)
+{
+    pthread_mutex_lock(&kernelLock);
+    for (;;)
+    {
+        uint64_t now = monotonicUs();
+        uint64_t wakeUs = NEVER;
+        HostTimer *due = nullptr;
+        TimerHandle_t handle = 0;
+        for (size_t i = 0; i < timers.size() && !due; i++)
+        {
+            HostTimer *timer = timers[i];
+            if (!timer->isActive)
+            {
+                continue;
+            }
+            if (timer->expiryUs <= now)
+            {
+                due = timer;
+                handle = (TimerHandle_t)(i + 1);
+            }
+            else if (timer->expiryUs < wakeUs)
+            {
+                wakeUs = timer->expiryUs;
+            }
+        }
+
+        if (!due)
+        {
+            block(self, wakeUs);
+            continue;
+        }
+
+        if (due->isAutoReload)
+        {
+            due->expiryUs += (uint64_t)due->period * portTICK_PERIOD_MS * 1000;
+        }
+        else
+        {
+            due->isActive = false;
+        }
+        pthread_mutex_unlock(&kernelLock);
+        due->cb(handle);
+        pthread_mutex_lock(&kernelLock);
+    }
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload, void *id, TimerCallbackFunction_t cb)
+{
+    ensureStarted();
+    pthread_mutex_lock(&kernelLock);
+    if (!timerTask)
+    {
+        timerTask = newTask(timerTaskMain, "Tmr Svc", configTIMER_TASK_STACK_DEPTH, nullptr, configTIMER_TASK_PRIORITY);
+        timerTask->readySeq = ++readySeq;
+        tasks.push_back(timerTask);
+        pthread_create(&timerTask->thread, nullptr, taskEntry, timerTask);
+        pthread_detach(timerTask->thread);
+        if (!current)
+        {
+            schedule();
+        }
+    }
+    HostTimer *timer = new HostTimer();
+    timer->name = name;
+    timer->period = period;
+    timer->isAutoReload = autoReload != pdFALSE;
+    timer->id = id;
+    timer->cb = cb;
+    timer->isActive = false;
+    timer->expiryUs = 0;
+    timers.push_back(timer);
+    TimerHandle_t handle = (TimerHandle_t)timers.size();
+    pthread_mutex_unlock(&kernelLock);
+    return handle;
+}
+
+static BaseType_t restartTimer(TimerHandle_t handle, const TickType_t *period)
+{
+    pthread_mutex_lock(&kernelLock);
+    HostTimer *timer = findTimer(handle);
+    if (timer)
+    {
+        if (period)
+        {
+            timer->period = *period;
+        }
+        timer->isActive = true;
+        timer->expiryUs = monotonicUs() + (uint64_t)timer->period * portTICK_PERIOD_MS * 1000;
+        kickTimerTask();
+        preemptIfNeeded();
+    }
+    pthread_mutex_unlock(&kernelLock);
+    return timer ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait)
+{
+    return restartTimer(timer, nullptr);
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait)
+{
+    return restartTimer(timer, nullptr);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t wait)
+{
+    return restartTimer(timer, &period);
+}
+
+BaseType_t xTimerStop(TimerHandle_t handle, TickType_t wait)
+{
+    pthread_mutex_lock(&kernelLock);
+    HostTimer *timer = findTimer(handle);
+    if (timer)
+    {
+        timer->isActive = false;
+    }
+    pthread_mutex_unlock(&kernelLock);
+    return timer ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t handle)
+{
+    pthread_mutex_lock(&kernelLock);
+    HostTimer *timer = findTimer(handle);
+    bool isActive = timer && timer->isActive;
+    pthread_mutex_unlock(&kernelLock);
+    return isActive ? pdTRUE : pdFALSE;
+}
+
+TickType_t xTimerGetPeriod(TimerHandle_t handle)
+{
+    pthread_mutex_lock(&kernelLock);
+    HostTimer *timer = findTimer(handle);
+    TickType_t period = timer ? timer->period : 0;
+    pthread_mutex_unlock(&kernelLock);
+    return period;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t handle)
+{
+    pthread_mutex_lock(&kernelLock);
+    HostTimer *timer = findTimer(handle);
+    void *id = timer ? timer->id : nullptr;
+    pthread_mutex_unlock(&kernelLock);
+    return id;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// interrupts, critical sections
+/////////////////////////////////////////////////////////////////////////////
+namespace hostrtos
+{
+    static pthread_mutex_t criticalLock;
+    static pthread_once_t criticalOnce = PTHREAD_ONCE_INIT;
+
+    // the interrupt controller: runs the events in time order
+    static void *eventMain(void *arg)
+    {
+        pthread_mutex_lock(&eventLock);
+        for (;;)
+        {
+            size_t first = firstEvent();
+            if (first == events.size())
+            {
+                pthread_cond_wait(&eventCv, &eventLock);
+                continue;
+            }
+            if (events[first].us > monotonicUs())
+            {
+                struct timespec ts = toTimespec(events[first].us);
+                pthread_cond_timedwait(&eventCv, &eventLock, &ts);
+                continue;
+            }
+
+            std::function<void(void)> fn = events[first].fn;
+            events.erase(events.begin() + first);
+            pthread_mutex_unlock(&eventLock);
+            isr(fn);
+            pthread_mutex_lock(&eventLock);
+        }
+        return nullptr;
+    }
+
+    static void startEvents(void)
+    {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&eventCv, &attr);
+        pthread_condattr_destroy(&attr);
+
+        pthread_t thread;
+        pthread_create(&thread, nullptr, eventMain, nullptr);
+        pthread_detach(thread);
+    }
+
+    uint64_t nowUs(void)
+    {
+        ensureStarted();
+        return monotonicUs();
+    }
+
+    void at(uint64_t us, const std::function<void(void)> &fn)
+    {
+        ensureStarted();
+        if (!isVirtual)
+        {
+            pthread_once(&eventOnce, startEvents);
+        }
+        pthread_mutex_lock(&eventLock);
+        Event event = {us, ++eventSeq, fn};
+        events.push_back(event);
+        pthread_cond_signal(&eventCv);
+        pthread_mutex_unlock(&eventLock);
+    }
+
+    void useVirtualTime(void)
+    {
+        isVirtual = true;
+    }
+
+    bool isVirtualTime(void)
+    {
+        return isVirtual;
+    }
+
+    // an ISR and the critical sections exclude each other, as on a single core
+    void isr(const std::function<void(void)> &fn)
+    {
+        enterCritical(nullptr);
+        isrDepth++;
+        fn();
+        isrDepth--;
+        exitCritical(nullptr);
+    }
+
+    static void startCritical(void)
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&criticalLock, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+
+    // one lock for every critical section, as a single core masking interrupts
+    void enterCritical(portMUX_TYPE *mux)
+    {
+        pthread_once(&criticalOnce, startCritical);
+        pthread_mutex_lock(&criticalLock);
+        criticalDepth++;
+    }
+
+    void exitCritical(portMUX_TYPE *mux)
+    {
+        criticalDepth--;
+        pthread_mutex_unlock(&criticalLock);
+    }
+
+    void assertFailed(const char *expr, const char *file, int line)
+    {
+        fprintf(stderr, "configASSERT(%s) failed at %s:%d\n", expr, file, line);
+        abort();
+    }
+} // namespace hostrtos
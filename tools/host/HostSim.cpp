@@ -0,0 +1,430 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include <Seeed_Arduino_SSCMA.h>
+#include <WiFi.h>
+#include "app/pins.h"
+#include "HostSim.h"
+
+#define SIM_FRAME_MS 100 // default camera frame period
+#define SIM_TAIL_US 60000000ULL // default end: after the last "at" line
+
+namespace hostsim
+{
+    typedef enum _StepType : uint8_t
+    {
+        StepVisit = 0,
+        StepPir,
+        StepNet,
+        StepConsole,
+    } StepType;
+
+    struct Step
+    {
+        uint64_t us; // from the start of a repetition
+        StepType type;
+        uint32_t widthMs;
+        std::string arg; // scene path, console line
+        HostNet net;
+    };
+
+    struct Visit
+    {
+        uint64_t pirUs;
+        bool hasScene;
+        uint64_t requestUs; // first notification request, 0: none
+        uint64_t statusUs;  // first HTTP 200 of a notification, 0: none
+    };
+
+    static std::vector<Step> steps;
+    static uint32_t frameMs = SIM_FRAME_MS;
+    static uint64_t repeatUs = 0; // 0: no repetition
+    static uint64_t endUs = 0;
+
+    static uint64_t startUs = 0;
+    static struct timespec startWall;
+    static std::vector<Visit> visits;
+    static uint32_t requests = 0;
+    static uint32_t successes = 0;
+    static uint32_t httpErrors = 0;
+    static uint32_t connectFails = 0;
+    static uint32_t otherRequests = 0; // the snapshot uploads
+
+    // "1h30m", "90s", "500ms", a plain number is in ms
+    static bool parseTime(const char *text, uint64_t *us)
+    {
+        *us = 0;
+        const char *p = text;
+        while (*p)
+        {
+            char *end;
+            double value = strtod(p, &end);
+            if (end == p || value < 0)
+            {
+                return false;
+            }
+            p = end;
+            double unitUs = 1000;
+            if (strncmp(p, "ms", 2) == 0)
+            {
+                p += 2;
+            }
+            else if (*p == 's' || *p == 'm' || *p == 'h')
+            {
+                unitUs = *p == 's' ? 1e6 : *p == 'm' ? 60e6 : 3600e6;
+                p++;
+            }
+            else if (*p)
+            {
+                return false;
+            }
+            *us += (uint64_t)(value * unitUs);
+        }
+        return p != text;
+    }
+
+    static bool parseMs(const char *text, const char *none, int32_t *ms)
+    {
+        if (strcmp(text, none) == 0)
+        {
+            *ms = -1;
+            return true;
+        }
+        char *end;
+        long value = strtol(text, &end, 0);
+        *ms = (int32_t)value;
+        return *end == '\0' && value >= 0;
+    }
+
+    static bool parseStep(char *line, const std::string &dir, Step *step)
+    {
+        char *when = strtok(line, " \t");
+        char *what = strtok(nullptr, " \t");
+        if (!when || !what || !parseTime(when, &step->us))
+        {
+            return false;
+        }
+
+        step->widthMs = SIM_PIR_WIDTH_MS;
+        if (strcmp(what, "visit") == 0 || strcmp(what, "pir") == 0)
+        {
+            step->type = strcmp(what, "visit") == 0 ? StepVisit : StepPir;
+            if (step->type == StepVisit)
+            {
+                char *path = strtok(nullptr, " \t");
+                if (!path)
+                {
+                    return false;
+                }
+                step->arg = path[0] == '/' ? std::string(path) : dir + path;
+                if (!hostSceneLoad(step->arg.c_str(), frameMs))
+                {
+                    return false;
+                }
+            }
+            char *width = strtok(nullptr, " \t");
+            step->widthMs = width ? strtoul(width, nullptr, 0) : SIM_PIR_WIDTH_MS;
+            return step->widthMs > 0;
+        }
+        if (strcmp(what, "net") == 0)
+        {
+            step->type = StepNet;
+            char *connect = strtok(nullptr, " \t");
+            char *response = strtok(nullptr, " \t");
+            char *status = strtok(nullptr, " \t");
+            step->net.status = status ? atoi(status) : 200;
+            if (connect && strcmp(connect, "down") == 0)
+            {
+                step->net.connectMs = -1;
+                step->net.responseMs = -1;
+                return true;
+            }
+            return connect && response &&
+                   parseMs(connect, "down", &step->net.connectMs) &&
+                   parseMs(response, "never", &step->net.responseMs);
+        }
+        if (strcmp(what, "console") == 0)
+        {
+            step->type = StepConsole;
+            char *rest = strtok(nullptr, "");
+            step->arg = std::string(rest ? rest : "") + "\n";
+            return true;
+        }
+        return false;
+    }
+
+    bool load(const char *path)
+    {
+        FILE *file = fopen(path, "r");
+        if (!file)
+        {
+            perror(path);
+            return false;
+        }
+        std::string dir(path);
+        dir = dir.find('/') == std::string::npos ? std::string() : dir.substr(0, dir.rfind('/') + 1);
+
+        char line[256];
+        int lineNo = 0;
+        bool isOk = true;
+        while (isOk && fgets(line, sizeof(line), file))
+        {
+            lineNo++;
+            char *comment = strchr(line, '#');
+            if (comment)
+            {
+                *comment = '\0';
+            }
+            line[strcspn(line, "\r\n")] = '\0';
+            char *text = line + strspn(line, " \t");
+            if (*text == '\0')
+            {
+                continue;
+            }
+
+            char *arg = text + strcspn(text, " \t");
+            if (*arg)
+            {
+                *arg++ = '\0';
+                arg += strspn(arg, " \t");
+            }
+            if (strcmp(text, "frame") == 0)
+            {
+                frameMs = strtoul(arg, nullptr, 0);
+                isOk = frameMs > 0;
+            }
+            else if (strcmp(text, "repeat") == 0)
+            {
+                isOk = parseTime(arg, &repeatUs) && repeatUs > 0;
+            }
+            else if (strcmp(text, "end") == 0)
+            {
+                isOk = parseTime(arg, &endUs);
+            }
+            else if (strcmp(text, "at") == 0)
+            {
+                Step step = {};
+                isOk = parseStep(arg, dir, &step);
+                steps.push_back(step);
+            }
+            else
+            {
+                isOk = false;
+            }
+        }
+        fclose(file);
+        if (!isOk)
+        {
+            fprintf(stderr, "%s:%d: invalid line\n", path, lineNo);
+            return false;
+        }
+
+        std::stable_sort(steps.begin(), steps.end(), [](const Step &a, const Step &b)
+                         { return a.us < b.us; });
+        if (!endUs)
+        {
+            endUs = (steps.empty() ? 0 : steps.back().us) + SIM_TAIL_US;
+        }
+        return true;
+    }
+
+    void pirPulse(uint64_t us, uint32_t widthMs, bool hasScene)
+    {
+        hostrtos::at(us, [hasScene]()
+                     {
+                         Visit visit = {hostrtos::nowUs(), hasScene, 0, 0};
+                         visits.push_back(visit);
+                         hostSceneStart();
+                         digitalWrite(PIN_PIR_INT, HIGH); });
+        hostrtos::at(us + (uint64_t)widthMs * 1000, []()
+                     { digitalWrite(PIN_PIR_INT, LOW); });
+    }
+
+    static void runStep(const Step &step)
+    {
+        switch (step.type)
+        {
+        case StepVisit:
+        case StepPir:
+            hostSceneLoad(step.type == StepVisit ? step.arg.c_str() : nullptr, frameMs);
+            pirPulse(hostrtos::nowUs(), step.widthMs, step.type == StepVisit);
+            break;
+        case StepNet:
+            hostNetModel(step.net);
+            break;
+        case StepConsole:
+            hostSerialInput(step.arg.c_str());
+            break;
+        }
+    }
+
+    // the steps of the repetition from baseUs, then the next repetition
+    static void schedule(uint64_t baseUs)
+    {
+        for (const Step &step : steps)
+        {
+            if ((repeatUs && step.us >= repeatUs) || startUs + endUs <= baseUs + step.us)
+            {
+                continue;
+            }
+            const Step *s = &step;
+            hostrtos::at(baseUs + step.us, [s]()
+                         { runStep(*s); });
+        }
+        if (repeatUs && baseUs + repeatUs < startUs + endUs)
+        {
+            hostrtos::at(baseUs + repeatUs, [baseUs]()
+                         { schedule(baseUs + repeatUs); });
+        }
+    }
+
+    void start(uint64_t us)
+    {
+        startUs = us;
+        clock_gettime(CLOCK_MONOTONIC, &startWall);
+        schedule(startUs);
+        hostrtos::at(startUs + endUs, []()
+                     {
+                         report();
+                         fflush(stdout);
+                         _exit(0); });
+    }
+
+    void onRequest(bool isNotification)
+    {
+        if (!isNotification)
+        {
+            otherRequests++;
+            return;
+        }
+        requests++;
+        if (!visits.empty() && !visits.back().requestUs)
+        {
+            visits.back().requestUs = hostrtos::nowUs();
+        }
+    }
+
+    void onResponse(int status, bool isNotification)
+    {
+        if (!isNotification)
+        {
+            return;
+        }
+        if (status != 200)
+        {
+            httpErrors++;
+            return;
+        }
+        successes++;
+        if (!visits.empty() && !visits.back().statusUs)
+        {
+            visits.back().statusUs = hostrtos::nowUs();
+        }
+    }
+
+    void onConnectFail(void)
+    {
+        connectFails++;
+    }
+
+    static void printDistribution(const char *name, std::vector<uint32_t> &ms)
+    {
+        if (ms.empty())
+        {
+            printf("%s: none\n", name);
+            return;
+        }
+        std::sort(ms.begin(), ms.end());
+        uint64_t sum = 0;
+        for (uint32_t v : ms)
+        {
+            sum += v;
+        }
+        printf("%s (ms): n=%u, min=%u, p50=%u, p90=%u, p99=%u, max=%u, avg=%u\n", name, (unsigned)ms.size(),
+               ms.front(), ms[ms.size() / 2], ms[ms.size() * 9 / 10], ms[ms.size() * 99 / 100], ms.back(),
+               (unsigned)(sum / ms.size()));
+    }
+
+    void report(void)
+    {
+        static const uint32_t buckets[] = {500, 1000, 2000, 5000, 10000, 30000};
+        const int bucketCount = sizeof(buckets) / sizeof(buckets[0]);
+
+        struct timespec wall;
+        clock_gettime(CLOCK_MONOTONIC, &wall);
+        double wallS = (wall.tv_sec - startWall.tv_sec) + (wall.tv_nsec - startWall.tv_nsec) / 1e9;
+        double simS = (hostrtos::nowUs() - startUs) / 1e6;
+
+        uint32_t scenes = 0;
+        uint32_t notified = 0;
+        uint32_t histogram[bucketCount + 1] = {};
+        std::vector<uint32_t> toRequest;
+        std::vector<uint32_t> toStatus;
+        for (const Visit &visit : visits)
+        {
+            scenes += visit.hasScene;
+            if (visit.requestUs)
+            {
+                toRequest.push_back((uint32_t)((visit.requestUs - visit.pirUs) / 1000));
+            }
+            if (visit.statusUs)
+            {
+                uint32_t ms = (uint32_t)((visit.statusUs - visit.pirUs) / 1000);
+                toStatus.push_back(ms);
+                int i = 0;
+                while (i < bucketCount && ms >= buckets[i])
+                {
+                    i++;
+                }
+                histogram[i]++;
+                notified++;
+            }
+        }
+
+        printf("simulated %.0f s in %.2f s (x%.0f)\n", simS, wallS, wallS > 0 ? simS / wallS : 0);
+        printf("visits=%u (scene=%u, nobody=%u), notified=%u, not notified=%u\n", (unsigned)visits.size(),
+               scenes, (unsigned)visits.size() - scenes, notified, (unsigned)visits.size() - notified);
+        printDistribution("PIR to request written", toRequest);
+        printDistribution("PIR to notification", toStatus);
+        for (int i = 0; i <= bucketCount; i++)
+        {
+            if (i < bucketCount)
+            {
+                printf("  < %5u ms: %u\n", buckets[i], histogram[i]);
+            }
+            else
+            {
+                printf("  >=%5u ms: %u\n", buckets[bucketCount - 1], histogram[i]);
+            }
+        }
+        printf("sends=%u: ok=%u, HTTP errors=%u, no response=%u; connect failures=%u, snapshot uploads=%u\n",
+               requests, successes, httpErrors, requests - successes - httpErrors, connectFails, otherRequests);
+        printf("inferences=%u, %.1f per visit\n", hostInferences(), visits.empty() ? 0.0 : (double)hostInferences() / visits.size());
+    }
+} // namespace hostsim
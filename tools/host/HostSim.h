@@ -0,0 +1,55 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Simulator of the host port: a scenario scripts PIR pulses, scenes and the network on
+// the virtual clock, and the stubs report to the probes below what the app did with them.
+// At the end, the report gives the latency from PIR to notification, and the inferences
+// and sends. A scenario file has one command per line, '#' starts a comment:
+//   frame <ms>                           camera frame period of the scenes (default 100)
+//   repeat <time>                        the "at" lines repeat with this period ...
+//   end <time>                           ... up to this time, when the report is printed
+//   at <time> visit <file.rec> [<ms>]    PIR pulse (width, default 300 ms) with the scene of
+//                                        a tools/replay recording, relative to the scenario
+//   at <time> pir [<ms>]                 PIR pulse with nobody in the scene
+//   at <time> net <connect ms|down> <response ms|never> [<HTTP status>]
+//   at <time> console <command line>
+// <time> is a sum of numbers with a unit: ms, s, m or h, e.g. 1h30m, 2m15s or 500ms.
+// A notification is a GET request of ThreadMessaging; it belongs to the last PIR pulse
+// before it.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define SIM_PIR_WIDTH_MS 300 // default PIR pulse width
+
+namespace hostsim
+{
+    bool load(const char *path); // false on an error, reported on stderr
+    void start(uint64_t startUs);
+    void report(void);
+
+    // PIR pulse at us (nowUs() clock), the start of a visit
+    void pirPulse(uint64_t us, uint32_t widthMs, bool hasScene);
+
+    // probes of the stubs
+    void onRequest(bool isNotification);
+    void onResponse(int status, bool isNotification);
+    void onConnectFail(void);
+} // namespace hostsim
@@ -0,0 +1,191 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <vector>
+#include <UrlEncode.h>
+#include <WiFi.h>
+#include "HostSim.h"
+
+#define WIFI_CONNECT_US 100000 // begin() to STA_GOT_IP
+#define TCP_CONNECT_MS 50      // default network model
+#define HTTP_RESPONSE_MS 100
+#define WIFI_CLIENT_CONNECT_TIMEOUT 3000 // WIFI_CLIENT_DEF_CONN_TIMEOUT_MS of the ESP32 core
+
+WiFiClass WiFi;
+
+static std::vector<WiFiEventCb> callbacks;
+
+void WiFiClass::onEvent(WiFiEventCb cb, arduino_event_id_t event)
+{
+    callbacks.push_back(cb);
+}
+
+void WiFiClass::onEvent(WiFiEventFuncCb cb, arduino_event_id_t event)
+{
+}
+
+void WiFiClass::begin(const char *ssid, const char *password)
+{
+    hostrtos::at(hostrtos::nowUs() + WIFI_CONNECT_US, []()
+                 {
+                     for (WiFiEventCb cb : callbacks)
+                     {
+                         cb(ARDUINO_EVENT_WIFI_STA_START);
+                         cb(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+                         cb(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+                     } });
+}
+
+static HostNet net = {TCP_CONNECT_MS, HTTP_RESPONSE_MS, 200};
+static portMUX_TYPE netLock = portMUX_INITIALIZER_UNLOCKED;
+
+void hostNetModel(const HostNet &model)
+{
+    portENTER_CRITICAL(&netLock);
+    net = model;
+    portEXIT_CRITICAL(&netLock);
+}
+
+WiFiClient::WiFiClient() : _isConnected(false),
+                           _net(),
+                           _method(),
+                           _written(0),
+                           _tail(0),
+                           _isRequestSent(false),
+                           _requestMs(0),
+                           _response(),
+                           _rxPos(0)
+{
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+    return connect(host, port, WIFI_CLIENT_CONNECT_TIMEOUT);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeoutMs)
+{
+    portENTER_CRITICAL(&netLock);
+    _net = net;
+    portEXIT_CRITICAL(&netLock);
+
+    _isConnected = false;
+    _written = 0;
+    _tail = 0;
+    _isRequestSent = false;
+    _rxPos = 0;
+    memset(_method, 0, sizeof(_method));
+    snprintf(_response, sizeof(_response), "HTTP/1.1 %d OK\r\nContent-Length: 0\r\n\r\n", _net.status);
+
+    if (_net.connectMs < 0 || _net.connectMs > timeoutMs)
+    {
+        vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+        hostsim::onConnectFail();
+        return 0;
+    }
+    vTaskDelay(pdMS_TO_TICKS(_net.connectMs));
+    _isConnected = true;
+    return 1;
+}
+
+uint8_t WiFiClient::connected(void)
+{
+    return _isConnected;
+}
+
+void WiFiClient::stop(void)
+{
+    _isConnected = false;
+}
+
+size_t WiFiClient::write(uint8_t c)
+{
+    if (!_isConnected)
+    {
+        return 0;
+    }
+    if (_written < sizeof(_method) - 1)
+    {
+        _method[_written] = (char)c;
+    }
+    _written++;
+    _tail = (_tail << 8) | c;
+    if (!_isRequestSent && _tail == 0x0d0a0d0a) // "\r\n\r\n"
+    {
+        _isRequestSent = true;
+        _requestMs = millis();
+        hostsim::onRequest(isNotification());
+    }
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size)
+{
+    size_t n = 0;
+    while (n < size && write(buf[n]))
+    {
+        n++;
+    }
+    return n;
+}
+
+int WiFiClient::available(void)
+{
+    if (!_isConnected || !_isRequestSent || _net.responseMs < 0 ||
+        (millis() - _requestMs) < (uint32_t)_net.responseMs)
+    {
+        return 0;
+    }
+    return (int)(strlen(_response) - _rxPos);
+}
+
+int WiFiClient::read(void)
+{
+    if (available() <= 0)
+    {
+        return -1;
+    }
+    int c = (unsigned char)_response[_rxPos++];
+    if (_response[_rxPos] == '\0')
+    {
+        hostsim::onResponse(_net.status, isNotification());
+    }
+    return c;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size)
+{
+    size_t n = 0;
+    int c;
+    while (n < size && (c = read()) >= 0)
+    {
+        buf[n++] = (uint8_t)c;
+    }
+    return (int)n;
+}
+
+bool WiFiClient::isNotification(void) const
+{
+    return strcmp(_method, "GET ") == 0;
+}
+
+String urlEncode(String s)
+{
+    return s;
+}
@@ -0,0 +1,174 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include <DebugLog.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// https://github.com/teamprof/arduprof on the host port: the FreeRTOS flavour (MessageQueue,
+// ThreadBase, MessageBus, SoftwareTimer, PeriodicTimer, Gpio) over HostRtos.h
+////////////////////////////////////////////////////////////////////////////////////////////
+#define ARDUPROF_VER "host"
+
+typedef struct _Message
+{
+    int16_t event;
+    int16_t iParam;
+    uint16_t uParam;
+    uint32_t lParam;
+} Message;
+
+#define __EVENT_MAP(cls, event) {(event), &cls::handler##event}
+#define __EVENT_FUNC_DECLARATION(event) void handler##event(const Message &msg);
+#define __EVENT_FUNC_DEFINITION(cls, event, msg) void cls::handler##event(const Message &msg)
+
+namespace ardufreertos
+{
+    class MessageQueue
+    {
+    public:
+        MessageQueue(QueueHandle_t queue) : _queue(queue), _context(nullptr) {}
+        MessageQueue(uint16_t queueLength, uint8_t *storage, StaticQueue_t *buffer)
+            : _queue(xQueueCreateStatic(queueLength, sizeof(Message), storage, buffer)), _context(nullptr) {}
+        virtual ~MessageQueue() {}
+
+        QueueHandle_t queue(void) { return _queue; }
+        void *context(void) { return _context; }
+
+        bool postEvent(int16_t event, int16_t iParam = 0, uint16_t uParam = 0, uint32_t lParam = 0)
+        {
+            Message msg = {event, iParam, uParam, lParam};
+            return xPortInIsrContext() ? sendMessageFromIsr(msg) : sendMessage(msg);
+        }
+        bool postEvent(MessageQueue *dest, int16_t event, int16_t iParam = 0, uint16_t uParam = 0, uint32_t lParam = 0)
+        {
+            return dest ? dest->postEvent(event, iParam, uParam, lParam) : false;
+        }
+        bool sendMessageToTask(int16_t event, int16_t iParam = 0, uint16_t uParam = 0, uint32_t lParam = 0)
+        {
+            Message msg = {event, iParam, uParam, lParam};
+            return sendMessage(msg);
+        }
+        bool sendMessageFromIsrToTask(int16_t event, int16_t iParam = 0, uint16_t uParam = 0, uint32_t lParam = 0)
+        {
+            Message msg = {event, iParam, uParam, lParam};
+            return sendMessageFromIsr(msg);
+        }
+
+    protected:
+        QueueHandle_t _queue;
+        void *_context;
+
+        bool sendMessage(const Message &msg) { return xQueueSend(_queue, &msg, 0) == pdPASS; }
+        bool sendMessageFromIsr(const Message &msg)
+        {
+            BaseType_t woken = pdFALSE;
+            return xQueueSendFromISR(_queue, &msg, &woken) == pdPASS;
+        }
+    };
+
+    class ThreadBase : public MessageQueue
+    {
+    public:
+        ThreadBase(uint16_t queueLength, uint8_t *storage, StaticQueue_t *buffer)
+            : MessageQueue(queueLength, storage, buffer), _taskHandle(nullptr) {}
+
+        virtual void start(void *ctx) { _context = ctx; }
+
+    protected:
+        TaskHandle_t _taskHandle;
+
+        virtual void setup(void) {}
+        virtual void delayInit(void) {}
+        virtual void onMessage(const Message &msg) = 0;
+        virtual void run(void)
+        {
+            setup();
+            delayInit();
+            for (;;)
+            {
+                Message msg;
+                if (xQueueReceive(_queue, &msg, portMAX_DELAY) == pdPASS)
+                {
+                    onMessage(msg);
+                }
+            }
+        }
+    };
+
+    class MessageBus : public MessageQueue
+    {
+    public:
+        MessageBus(uint16_t queueLength, uint8_t *storage, StaticQueue_t *buffer)
+            : MessageQueue(queueLength, storage, buffer) {}
+
+        virtual void start(void *ctx) { _context = ctx; }
+        virtual void onMessage(const Message &msg) = 0;
+
+        void messageLoop(uint32_t ms)
+        {
+            Message msg;
+            if (xQueueReceive(_queue, &msg, pdMS_TO_TICKS(ms)) == pdPASS)
+            {
+                onMessage(msg);
+            }
+        }
+        void messageLoopForever(void)
+        {
+            for (;;)
+            {
+                messageLoop(portMAX_DELAY);
+            }
+        }
+    };
+
+    class SoftwareTimer
+    {
+    public:
+        SoftwareTimer(const char *name, TickType_t period, UBaseType_t autoReload, void *id, TimerCallbackFunction_t cb)
+            : _timer(xTimerCreate(name, period, autoReload, id, cb)) {}
+        bool start(void) { return xTimerStart(_timer, 0) == pdPASS; }
+        bool stop(void) { return xTimerStop(_timer, 0) == pdPASS; }
+        TimerHandle_t timer(void) { return _timer; }
+
+    protected:
+        TimerHandle_t _timer;
+    };
+
+    class PeriodicTimer : public SoftwareTimer
+    {
+    public:
+        PeriodicTimer(const char *name, TickType_t period, TimerCallbackFunction_t cb)
+            : SoftwareTimer(name, period, pdTRUE, nullptr, cb) {}
+    };
+} // namespace ardufreertos
+
+class Gpio
+{
+public:
+    Gpio(uint8_t pin, uint8_t mode) : _pin(pin) { pinMode(pin, mode); }
+    void attachIntr(int mode, void (*fn)(void *), void *arg) { attachInterruptArg(_pin, fn, arg, mode); }
+    void detachIntr(void) { detachInterrupt(_pin); }
+    int read(void) { return digitalRead(_pin); }
+    uint8_t getPin(void) { return _pin; }
+
+protected:
+    uint8_t _pin;
+};
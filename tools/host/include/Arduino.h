@@ -0,0 +1,206 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "HostRtos.h"
+#include "esp_system.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Arduino core of the host port
+//   GPIO: a pin is a level in memory. digitalWrite() on a pin with an interrupt attached
+//   runs the ISR in interrupt context, so the stimuli of main.cpp drive PIR and BOOT with it.
+//   Serial: output to stdout; input from stdin and from hostSerialInput().
+////////////////////////////////////////////////////////////////////////////////////////////
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define ONLOW 0x04
+#define ONHIGH 0x05
+
+#define CONFIG_IDF_TARGET_ESP32C3 1
+
+typedef enum
+{
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_1,
+    GPIO_NUM_2,
+    GPIO_NUM_3,
+    GPIO_NUM_4,
+    GPIO_NUM_5,
+    GPIO_NUM_6,
+    GPIO_NUM_7,
+    GPIO_NUM_8,
+    GPIO_NUM_9,
+    GPIO_NUM_10,
+    GPIO_NUM_MAX = 22,
+} gpio_num_t;
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+#define digitalPinToInterrupt(p) (p)
+void attachInterrupt(uint8_t pin, void (*fn)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*fn)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+uint32_t getCpuFrequencyMhz(void);
+size_t getArduinoLoopTaskStackSize(void);
+
+// host port only: text typed on the console, '\n' ends a command
+void hostSerialInput(const char *text);
+
+class String
+{
+public:
+    String() {}
+    String(const char *s) : _s(s ? s : "") {}
+    String(const std::string &s) : _s(s) {}
+    String(int v) : _s(std::to_string(v)) {}
+    const char *c_str(void) const { return _s.c_str(); }
+    unsigned int length(void) const { return (unsigned int)_s.size(); }
+    String &operator+=(const String &rhs)
+    {
+        _s += rhs._s;
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        _s += c;
+        return *this;
+    }
+    friend String operator+(const String &a, const String &b) { return String(a._s + b._s); }
+    bool operator==(const String &rhs) const { return _s == rhs._s; }
+    char operator[](unsigned int i) const { return _s[i]; }
+    void trim(void)
+    {
+        size_t b = _s.find_first_not_of(" \t\r\n");
+        size_t e = _s.find_last_not_of(" \t\r\n");
+        _s = (b == std::string::npos) ? std::string() : _s.substr(b, e - b + 1);
+    }
+
+private:
+    std::string _s;
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+        {
+            n += write(*buf++);
+        }
+        return n;
+    }
+    size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t print(int v) { return print(std::to_string(v).c_str()); }
+    size_t print(unsigned int v) { return print(std::to_string(v).c_str()); }
+    size_t print(long v) { return print(std::to_string(v).c_str()); }
+    size_t print(unsigned long v) { return print(std::to_string(v).c_str()); }
+    size_t println(void) { return print("\r\n"); }
+    template <typename T>
+    size_t println(const T &v) { return print(v) + println(); }
+    size_t printf(const char *fmt, ...);
+};
+
+class Stream : public Print
+{
+public:
+    Stream() : _timeout(1000) {}
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+    void setTimeout(unsigned long ms) { _timeout = ms; }
+    // waits for each byte up to the timeout, as Arduino does; 1 ms steps, so in virtual time too
+    size_t readBytesUntil(char terminator, char *buffer, size_t length)
+    {
+        size_t n = 0;
+        while (n < length && waitAvailable())
+        {
+            int c = read();
+            if (c < 0 || c == terminator)
+            {
+                break;
+            }
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+
+protected:
+    unsigned long _timeout;
+
+    bool waitAvailable(void)
+    {
+        for (unsigned long ms = 0; available() <= 0; ms++)
+        {
+            if (ms >= _timeout)
+            {
+                return false;
+            }
+            delay(1);
+        }
+        return true;
+    }
+};
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud);
+    operator bool() const { return true; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available(void) override;
+    int read(void) override;
+};
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    const char *getChipModel(void) { return "host"; }
+    uint8_t getChipRevision(void) { return 0; }
+    uint8_t getChipCores(void) { return 1; }
+    const char *getSdkVersion(void) { return "host"; }
+    uint32_t getFreeHeap(void) { return 0; }
+};
+extern EspClass ESP;
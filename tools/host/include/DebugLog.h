@@ -0,0 +1,103 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdio.h>
+#include <sstream>
+#include <string>
+#include <Arduino.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// https://github.com/hideakitai/DebugLog on the host port: one line per call, to stdout
+////////////////////////////////////////////////////////////////////////////////////////////
+enum class DebugLogLevel
+{
+    LVL_NONE = 0,
+    LVL_ERROR = 1,
+    LVL_WARN = 2,
+    LVL_INFO = 3,
+    LVL_DEBUG = 4,
+    LVL_TRACE = 5,
+};
+
+namespace DebugLogBase
+{
+    enum Base
+    {
+        DEC,
+        HEX,
+    };
+}
+
+namespace hostlog
+{
+    extern DebugLogLevel level;
+    extern bool hexMode;
+    void emit(DebugLogLevel lvl, const std::string &line);
+
+    inline void append(std::ostringstream &os) {}
+
+    template <typename T>
+    inline void put(std::ostringstream &os, const T &v) { os << v; }
+    inline void put(std::ostringstream &os, const String &v) { os << v.c_str(); }
+    inline void put(std::ostringstream &os, DebugLogBase::Base b) { hexMode = (b == DebugLogBase::HEX); }
+    inline void put(std::ostringstream &os, uint8_t v)
+    {
+        if (hexMode)
+            os << std::hex << (unsigned)v << std::dec;
+        else
+            os << (unsigned)v;
+    }
+    inline void put(std::ostringstream &os, int8_t v) { os << (int)v; }
+    inline void put(std::ostringstream &os, bool v) { os << (v ? "true" : "false"); }
+
+    template <typename T, typename... Rest>
+    inline void append(std::ostringstream &os, const T &v, const Rest &...rest)
+    {
+        put(os, v);
+        append(os, rest...);
+    }
+
+    template <typename... Args>
+    inline void log(DebugLogLevel lvl, const char *tag, const Args &...args)
+    {
+        if ((int)lvl > (int)level)
+        {
+            return;
+        }
+        std::ostringstream os;
+        if (tag)
+        {
+            os << tag;
+        }
+        hexMode = false;
+        append(os, args...);
+        emit(lvl, os.str());
+    }
+} // namespace hostlog
+
+#define LOG_ERROR(...) hostlog::log(DebugLogLevel::LVL_ERROR, "[ERROR] ", __VA_ARGS__)
+#define LOG_WARN(...) hostlog::log(DebugLogLevel::LVL_WARN, "[WARN] ", __VA_ARGS__)
+#define LOG_INFO(...) hostlog::log(DebugLogLevel::LVL_INFO, "[INFO] ", __VA_ARGS__)
+#define LOG_DEBUG(...) hostlog::log(DebugLogLevel::LVL_DEBUG, "[DEBUG] ", __VA_ARGS__)
+#define LOG_TRACE(...) hostlog::log(DebugLogLevel::LVL_TRACE, "[TRACE] ", __VA_ARGS__)
+#define PRINTLN(...) hostlog::log(DebugLogLevel::LVL_ERROR, nullptr, __VA_ARGS__)
+#define LOG_SET_LEVEL(l) (hostlog::level = (l))
+#define LOG_SET_DELIMITER(d)
+#define LOG_ATTACH_SERIAL(s)
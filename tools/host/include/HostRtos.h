@@ -0,0 +1,150 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// FreeRTOS subset of the host port, on pthreads and CLOCK_MONOTONIC
+//   The tasks are pthreads, but they run one at a time, in priority order, as on the single
+//   core of the ESP32C3: a task runs until it blocks (queue, delay) or a task of higher
+//   priority gets ready through one of the calls below. Tasks of equal priority are not
+//   time-sliced. Interrupts (the GPIO ISRs, the timed events of hostrtos::at()) run on
+//   another pthread, concurrently with the running task, as an interrupt would.
+//   Critical sections are one recursive mutex: they exclude the ISRs as well.
+//   The timers run in a "Tmr Svc" task of priority 1, as configTIMER_TASK_PRIORITY.
+//   A tick is 1 ms. A send never blocks: a full queue fails at once, as the app posts with
+//   no wait anyway.
+// Virtual time (useVirtualTime()): the clock stands still while a task runs, and jumps to
+// the next timeout or event of at() when every task is blocked; the events run on the
+// thread of the task that blocked last. No thread is left to chance, so a run is the same
+// every time, and a simulated hour takes as long as the work done in it.
+////////////////////////////////////////////////////////////////////////////////////////////
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define configTIMER_TASK_PRIORITY 1
+#define configTIMER_TASK_STACK_DEPTH 2048
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define ARDUINO_RUNNING_CORE 0
+#define configASSERT(x) ((x) ? (void)0 : hostrtos::assertFailed(#x, __FILE__, __LINE__))
+
+struct HostQueue;
+struct HostTask;
+typedef HostQueue *QueueHandle_t;
+typedef HostQueue *QueueSetHandle_t;
+typedef HostTask *TaskHandle_t;
+// timer handles are 32-bit ids, so that (uint32_t) casts of the app round-trip on 64-bit hosts
+typedef uint32_t TimerHandle_t;
+typedef struct
+{
+    uint8_t reserved[64];
+} StaticQueue_t;
+typedef struct
+{
+    uint8_t reserved[64];
+} StaticTask_t;
+typedef void (*TaskFunction_t)(void *);
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+
+// queues and queue sets; the static storage of the app is not used
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t *storage, StaticQueue_t *buffer);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+QueueSetHandle_t xQueueCreateSet(UBaseType_t length);
+BaseType_t xQueueAddToSet(QueueHandle_t queue, QueueSetHandle_t set);
+QueueHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t wait);
+#define xQueueSendToBack xQueueSend
+#define xQueueSendToBackFromISR xQueueSendFromISR
+#define portYIELD_FROM_ISR(x) (void)(x)
+
+// tasks
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                                           UBaseType_t priority, StackType_t *stack, StaticTask_t *buffer, BaseType_t core);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+const char *pcTaskGetName(TaskHandle_t task);
+BaseType_t xPortInIsrContext(void);
+#define taskYIELD() vTaskDelay(0)
+
+// software timers
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload, void *id, TimerCallbackFunction_t cb);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t wait);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+TickType_t xTimerGetPeriod(TimerHandle_t timer);
+void *pvTimerGetTimerID(TimerHandle_t timer);
+TaskHandle_t xTimerGetTimerDaemonTaskHandle(void);
+#define xTimerStartFromISR(t, w) xTimerStart(t, 0)
+#define xTimerStopFromISR(t, w) xTimerStop(t, 0)
+
+// critical sections
+typedef struct
+{
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+#define portMUX_INITIALIZE(mux) \
+    do                          \
+    {                           \
+        (mux)->owner = 0;       \
+        (mux)->count = 0;       \
+    } while (0)
+#define portENTER_CRITICAL(mux) hostrtos::enterCritical(mux)
+#define portEXIT_CRITICAL(mux) hostrtos::exitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) hostrtos::enterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) hostrtos::exitCritical(mux)
+
+namespace hostrtos
+{
+    // time since the start of the process, in unit of us
+    uint64_t nowUs(void);
+
+    // run fn in interrupt context at time us (nowUs() clock)
+    void at(uint64_t us, const std::function<void(void)> &fn);
+    // run fn in interrupt context now, on the calling thread
+    void isr(const std::function<void(void)> &fn);
+
+    // virtual time, to call before any other: see the banner
+    void useVirtualTime(void);
+    bool isVirtualTime(void);
+
+    void enterCritical(portMUX_TYPE *mux);
+    void exitCritical(portMUX_TYPE *mux);
+    void assertFailed(const char *expr, const char *file, int line);
+} // namespace hostrtos
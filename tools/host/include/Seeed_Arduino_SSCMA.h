@@ -0,0 +1,53 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include "../../replay/MockSSCMA.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Seeed_Arduino_SSCMA on the host port: MockSSCMA of tools/replay
+//   invoke() returns the frames of the recording of hostSceneLoad() (main.cpp -s, or a
+//   visit of a scenario), from the start of the scene: hostSceneStart() is called on each
+//   PIR pulse, so every visit replays it. It blocks for the preprocess + inference +
+//   postprocess time of the frame. With no recording the scene is empty.
+//   The AT channel (available/read/write) is silent, so the AT commands of NpuAt time out.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define CMD_OK 0
+
+class TwoWire;
+
+class SSCMA : public MockSSCMA
+{
+public:
+    bool begin(TwoWire *wire = nullptr, int32_t rst = -1, uint16_t address = 0x62, uint32_t wait_delay = 2, uint32_t clock = 400000);
+    int invoke(int times = 1, bool filter = 0, bool show = 0);
+    int available(void);
+    int read(char *data, int length);
+    int write(const char *data, int length);
+    String last_image(void) { return String(); }
+
+private:
+    uint32_t _sceneSeq = 0; // the scene copied into this
+};
+
+// host port only; a nullptr path selects the empty scene
+bool hostSceneLoad(const char *path, uint32_t framePeriodMs);
+void hostSceneStart(void);
+uint32_t hostInferences(void);
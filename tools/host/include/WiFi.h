@@ -0,0 +1,149 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <Arduino.h>
+#include <ostream>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// WiFi of the host port
+//   begin() reports STA_START, STA_CONNECTED and STA_GOT_IP 100 ms later.
+//   WiFiClient::connect() blocks as on the ESP32, for the connect time of hostNetModel(),
+//   and fails after WIFI_CLIENT_CONNECT_TIMEOUT (or the timeout given) if the server is
+//   down or slower to connect. The server answers
+//   "HTTP/1.1 <status>" the response time after the end of the request headers, or never.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class IPAddress
+{
+public:
+    IPAddress(uint32_t v = 0) : _v(v) {}
+    String toString(void) const
+    {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (unsigned)(_v & 0xff), (unsigned)((_v >> 8) & 0xff), (unsigned)((_v >> 16) & 0xff), (unsigned)(_v >> 24));
+        return String(buf);
+    }
+    friend std::ostream &operator<<(std::ostream &os, const IPAddress &ip) { return os << ip.toString().c_str(); }
+
+private:
+    uint32_t _v;
+};
+
+typedef enum
+{
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP6,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_WIFI_AP_START,
+    ARDUINO_EVENT_WIFI_AP_STOP,
+    ARDUINO_EVENT_WIFI_AP_STACONNECTED,
+    ARDUINO_EVENT_WIFI_AP_STADISCONNECTED,
+    ARDUINO_EVENT_WIFI_AP_STAIPASSIGNED,
+    ARDUINO_EVENT_WIFI_AP_PROBEREQRECVED,
+    ARDUINO_EVENT_WIFI_AP_GOT_IP6,
+    ARDUINO_EVENT_ETH_START,
+    ARDUINO_EVENT_ETH_STOP,
+    ARDUINO_EVENT_ETH_CONNECTED,
+    ARDUINO_EVENT_ETH_DISCONNECTED,
+    ARDUINO_EVENT_ETH_GOT_IP,
+    ARDUINO_EVENT_ETH_GOT_IP6,
+    ARDUINO_EVENT_WPS_ER_SUCCESS,
+    ARDUINO_EVENT_WPS_ER_FAILED,
+    ARDUINO_EVENT_WPS_ER_TIMEOUT,
+    ARDUINO_EVENT_WPS_ER_PIN,
+    ARDUINO_EVENT_MAX,
+} arduino_event_id_t;
+typedef arduino_event_id_t WiFiEvent_t;
+typedef struct
+{
+    uint32_t reserved;
+} arduino_event_info_t;
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+typedef void (*WiFiEventFuncCb)(arduino_event_id_t event, arduino_event_info_t info);
+
+#define WIFI_STA 1
+#define WL_CONNECTED 3
+
+class WiFiClass
+{
+public:
+    void mode(int) {}
+    void begin(const char *ssid, const char *password);
+    void disconnect(bool) {}
+    int status(void) { return WL_CONNECTED; }
+    void macAddress(uint8_t *mac) { memset(mac, 0, 6); }
+    int RSSI(void) { return -40; }
+    IPAddress localIP(void) { return IPAddress(0x0100007f); }
+    IPAddress gatewayIP(void) { return IPAddress(0); }
+    IPAddress dnsIP(void) { return IPAddress(0); }
+    IPAddress subnetMask(void) { return IPAddress(0x00ffffff); }
+    void onEvent(WiFiEventCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    void onEvent(WiFiEventFuncCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+};
+extern WiFiClass WiFi;
+
+// network of the host port: TCP connect time, -1: server down; response time, -1: never
+typedef struct _HostNet
+{
+    int32_t connectMs;
+    int32_t responseMs;
+    int status;
+} HostNet;
+
+// host port only
+void hostNetModel(const HostNet &net);
+
+class WiFiClient : public Stream
+{
+public:
+    WiFiClient();
+    int connect(const char *host, uint16_t port);
+    int connect(const char *host, uint16_t port, int32_t timeoutMs);
+    uint8_t connected(void);
+    void stop(void);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available(void) override;
+    int read(void) override;
+    int read(uint8_t *buf, size_t size);
+    IPAddress remoteIP(void) { return IPAddress(0x0100007f); }
+    uint16_t remotePort(void) { return 80; }
+    operator bool() { return connected(); }
+
+private:
+    bool isNotification(void) const;
+
+    bool _isConnected;
+    HostNet _net;
+    char _method[5]; // first bytes written, "GET " for the notifications
+    uint32_t _written;
+    uint32_t _tail; // last 4 bytes written, to spot the end of the headers
+    bool _isRequestSent;
+    uint32_t _requestMs;
+    char _response[64];
+    size_t _rxPos;
+};
@@ -0,0 +1,166 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include <Seeed_Arduino_SSCMA.h>
+#include "HostSim.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Host port of the doorbell: the unmodified setup()/loop() of github-we2-doorbell.ino and
+// the app threads on the FreeRTOS subset of HostRtos.cpp
+//   usage: doorbell [-v] [-t sec] [-s file.rec [-f ms]] [-p ms]... [-P ms] [-w ms] [-c ms:cmd]...
+//          doorbell -S file.sim
+////////////////////////////////////////////////////////////////////////////////////////////
+extern void setup(void);
+extern void loop(void);
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -v          virtual time, see HostRtos.h\n"
+            "  -S file     simulate a scenario on virtual time, see HostSim.h\n"
+            "  -t sec      exit after sec seconds (default: run forever)\n"
+            "  -s file     Grove Vision AI scene, a tools/replay recording\n"
+            "  -f ms       camera frame period of the scene (default 100)\n"
+            "  -p ms       PIR pulse at ms after start, repeatable\n"
+            "  -P ms       PIR pulse every ms\n"
+            "  -w ms       PIR pulse width (default %u)\n"
+            "  -c ms:cmd   type console command cmd at ms after start, repeatable\n",
+            name, SIM_PIR_WIDTH_MS);
+    exit(2);
+}
+
+static void pirPeriodic(uint64_t us, uint32_t periodMs, uint32_t widthMs, bool hasScene)
+{
+    hostsim::pirPulse(us, widthMs, hasScene);
+    hostrtos::at(us + (uint64_t)periodMs * 1000, [us, periodMs, widthMs, hasScene]()
+                 { pirPeriodic(us + (uint64_t)periodMs * 1000, periodMs, widthMs, hasScene); });
+}
+
+int main(int argc, char **argv)
+{
+    bool isVirtual = false;
+    const char *scenario = nullptr;
+    double exitS = 0;
+    const char *scene = nullptr;
+    uint32_t frameMs = 100;
+    uint32_t periodMs = 0;
+    uint32_t widthMs = SIM_PIR_WIDTH_MS;
+    std::vector<uint32_t> pulses;
+    std::vector<std::pair<uint32_t, std::string>> commands;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "vS:t:s:f:p:P:w:c:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'v':
+            isVirtual = true;
+            break;
+        case 'S':
+            scenario = optarg;
+            isVirtual = true;
+            break;
+        case 't':
+            exitS = atof(optarg);
+            break;
+        case 's':
+            scene = optarg;
+            break;
+        case 'f':
+            frameMs = strtoul(optarg, nullptr, 0);
+            break;
+        case 'p':
+            pulses.push_back(strtoul(optarg, nullptr, 0));
+            break;
+        case 'P':
+            periodMs = strtoul(optarg, nullptr, 0);
+            break;
+        case 'w':
+            widthMs = strtoul(optarg, nullptr, 0);
+            break;
+        case 'c':
+        {
+            char *cmd = strchr(optarg, ':');
+            if (!cmd)
+            {
+                usage(argv[0]);
+            }
+            commands.push_back(std::make_pair(strtoul(optarg, nullptr, 0), std::string(cmd + 1) + "\n"));
+            break;
+        }
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (isVirtual)
+    {
+        hostrtos::useVirtualTime();
+    }
+    uint64_t startUs = hostrtos::nowUs(); // main() becomes loopTask
+
+    if (scenario)
+    {
+        if (!hostsim::load(scenario))
+        {
+            return 1;
+        }
+        hostsim::start(startUs);
+    }
+    if (scene && !hostSceneLoad(scene, frameMs))
+    {
+        return 1;
+    }
+    for (uint32_t ms : pulses)
+    {
+        hostsim::pirPulse(startUs + (uint64_t)ms * 1000, widthMs, scene != nullptr);
+    }
+    if (periodMs)
+    {
+        pirPeriodic(startUs + (uint64_t)periodMs * 1000, periodMs, widthMs, scene != nullptr);
+    }
+    for (const std::pair<uint32_t, std::string> &command : commands)
+    {
+        std::string line = command.second;
+        hostrtos::at(startUs + (uint64_t)command.first * 1000, [line]()
+                     { hostSerialInput(line.c_str()); });
+    }
+    if (exitS > 0)
+    {
+        hostrtos::at(startUs + (uint64_t)(exitS * 1000000), []()
+                     {
+                         fflush(stdout);
+                         _exit(0); });
+    }
+
+    setup();
+    for (;;)
+    {
+        loop();
+    }
+    return 0;
+}
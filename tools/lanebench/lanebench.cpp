@@ -0,0 +1,248 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include "app/util/MessageLanes.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Per-lane dispatch latency of QueueMain, single FIFO against LanePolicy, in virtual time
+//   bulk  : NPU results, a steady frame rate plus periodic bursts (a backlog after a stall)
+//   urgent: GPIO edges, debounce ticks and timer ticks, at a steady rate with jitter
+// One consumer serves a message at a time; the latency is from the post to the start of
+// its handler. The lane capacities are the queue sizes of QueueMain.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define LANEBENCH_BULK_QUEUE 2048  // TASK_QUEUE_SIZE of QueueMain
+#define LANEBENCH_URGENT_QUEUE 32  // URGENT_QUEUE_SIZE of QueueMain
+
+struct Config
+{
+    uint32_t durationMs;
+    uint32_t framePeriodMs;  // steady NPU frames
+    uint32_t burstPeriodMs;  // a burst of bulk messages every ...
+    uint32_t burstSize;
+    uint32_t urgentPeriodMs; // mean period of the urgent messages
+    uint32_t bulkServiceUs;  // handler time of a bulk message
+    uint32_t urgentServiceUs;
+    uint16_t urgentBurst; // LanePolicy cap
+};
+
+struct Arrival
+{
+    uint64_t us;
+    MessageLane lane;
+
+    bool operator<(const Arrival &other) const
+    {
+        return us < other.us;
+    }
+};
+
+class Latency
+{
+public:
+    void add(uint64_t us)
+    {
+        _samples.push_back(us);
+    }
+
+    void print(const char *name, uint32_t dropped)
+    {
+        std::sort(_samples.begin(), _samples.end());
+        if (_samples.empty())
+        {
+            printf("  %-6s: no message, %u dropped\n", name, (unsigned)dropped);
+            return;
+        }
+        printf("  %-6s: %7zu messages, p50 %8.2f ms, p99 %8.2f ms, max %8.2f ms, %u dropped\n", name, _samples.size(),
+               percentile(50) / 1000.0, percentile(99) / 1000.0, _samples.back() / 1000.0, (unsigned)dropped);
+    }
+
+private:
+    std::vector<uint64_t> _samples;
+
+    uint64_t percentile(int p) const
+    {
+        return _samples[(_samples.size() - 1) * p / 100];
+    }
+};
+
+static std::vector<Arrival> makeArrivals(const Config &config)
+{
+    std::vector<Arrival> arrivals;
+    uint64_t endUs = (uint64_t)config.durationMs * 1000;
+
+    for (uint64_t us = 0; us < endUs; us += (uint64_t)config.framePeriodMs * 1000)
+    {
+        arrivals.push_back({us, LaneBulk});
+    }
+    for (uint64_t us = (uint64_t)config.burstPeriodMs * 1000; config.burstPeriodMs && us < endUs; us += (uint64_t)config.burstPeriodMs * 1000)
+    {
+        for (uint32_t i = 0; i < config.burstSize; i++)
+        {
+            arrivals.push_back({us + i * 10, LaneBulk}); // posted back to back
+        }
+    }
+
+    uint32_t seed = 1;
+    for (uint64_t us = 0; us < endUs;)
+    {
+        seed = seed * 1103515245 + 12345;
+        us += (uint64_t)config.urgentPeriodMs * 1000 / 2 + (seed >> 8) % ((uint64_t)config.urgentPeriodMs * 1000 + 1);
+        arrivals.push_back({us, LaneUrgent});
+    }
+
+    std::stable_sort(arrivals.begin(), arrivals.end());
+    return arrivals;
+}
+
+// isLanes false: everything goes through the bulk queue in post order, as before
+static void simulate(const Config &config, const std::vector<Arrival> &arrivals, bool isLanes)
+{
+    std::deque<uint64_t> queues[LaneCount];
+    const size_t capacity[LaneCount] = {LANEBENCH_URGENT_QUEUE, LANEBENCH_BULK_QUEUE};
+    std::deque<Arrival> fifo;
+    uint32_t dropped[LaneCount] = {0, 0};
+    Latency latency[LaneCount];
+    LanePolicy policy(config.urgentBurst);
+
+    uint64_t now = 0;
+    size_t next = 0;
+    while (next < arrivals.size() || !fifo.empty() || !queues[LaneUrgent].empty() || !queues[LaneBulk].empty())
+    {
+        bool isEmpty = isLanes ? queues[LaneUrgent].empty() && queues[LaneBulk].empty() : fifo.empty();
+        if (isEmpty && now < arrivals[next].us)
+        {
+            now = arrivals[next].us; // idle until the next post
+        }
+        for (; next < arrivals.size() && arrivals[next].us <= now; next++)
+        {
+            const Arrival &arrival = arrivals[next];
+            MessageLane lane = isLanes ? arrival.lane : LaneBulk;
+            size_t depth = isLanes ? queues[lane].size() : fifo.size();
+            if (depth >= capacity[lane])
+            {
+                dropped[arrival.lane]++;
+            }
+            else if (isLanes)
+            {
+                queues[lane].push_back(arrival.us);
+            }
+            else
+            {
+                fifo.push_back(arrival);
+            }
+        }
+
+        Arrival served;
+        if (isLanes)
+        {
+            MessageLane lane = policy.next(!queues[LaneUrgent].empty(), !queues[LaneBulk].empty());
+            if (lane == LaneCount)
+            {
+                continue;
+            }
+            served = {queues[lane].front(), lane};
+            queues[lane].pop_front();
+        }
+        else
+        {
+            if (fifo.empty())
+            {
+                continue;
+            }
+            served = fifo.front();
+            fifo.pop_front();
+        }
+        latency[served.lane].add(now - served.us);
+        now += served.lane == LaneUrgent ? config.urgentServiceUs : config.bulkServiceUs;
+    }
+
+    printf("%s\n", isLanes ? "urgent + bulk lanes (LanePolicy)" : "single FIFO");
+    latency[LaneUrgent].print("urgent", dropped[LaneUrgent]);
+    latency[LaneBulk].print("bulk", dropped[LaneBulk]);
+    if (isLanes)
+    {
+        const LanePolicy::Stats &stats = policy.stats();
+        printf("  bulk starved %u, forced %u, longest urgent run %u\n", (unsigned)stats.bulkStarved, (unsigned)stats.bulkForced,
+               (unsigned)stats.maxUrgentRun);
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-t seconds] [-f frame_ms] [-p burst_period_ms] [-b burst_size] [-u urgent_ms]\n"
+                    "          [-s bulk_service_us] [-S urgent_service_us] [-r urgent_burst]\n",
+            name);
+    fprintf(stderr, "  defaults: -t 60 -f 250 -p 5000 -b 500 -u 20 -s 2000 -S 200 -r %d\n", LANE_URGENT_BURST);
+}
+
+int main(int argc, char *argv[])
+{
+    Config config = {60000, 250, 5000, 500, 20, 2000, 200, LANE_URGENT_BURST};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:f:p:b:u:s:S:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            config.durationMs = atoi(optarg) * 1000;
+            break;
+        case 'f':
+            config.framePeriodMs = atoi(optarg);
+            break;
+        case 'p':
+            config.burstPeriodMs = atoi(optarg);
+            break;
+        case 'b':
+            config.burstSize = atoi(optarg);
+            break;
+        case 'u':
+            config.urgentPeriodMs = atoi(optarg);
+            break;
+        case 's':
+            config.bulkServiceUs = atoi(optarg);
+            break;
+        case 'S':
+            config.urgentServiceUs = atoi(optarg);
+            break;
+        case 'r':
+            config.urgentBurst = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!config.framePeriodMs || !config.urgentPeriodMs)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Arrival> arrivals = makeArrivals(config);
+    simulate(config, arrivals, false);
+    simulate(config, arrivals, true);
+    return 0;
+}
@@ -0,0 +1,52 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Minimal host stand-in for the Arduino core used by src/app/driver/npu
+//   time is virtual: it only moves on delay() and on the transactions of SimLink, so a
+//   benchmark run is deterministic and takes no wall-clock time
+////////////////////////////////////////////////////////////////////////////////////////////
+namespace hostclock
+{
+    extern uint64_t us;
+
+    inline void advance(uint64_t deltaUs)
+    {
+        us += deltaUs;
+    }
+} // namespace hostclock
+
+inline uint32_t micros(void)
+{
+    return (uint32_t)hostclock::us;
+}
+
+inline uint32_t millis(void)
+{
+    return (uint32_t)(hostclock::us / 1000);
+}
+
+inline void delay(uint32_t ms)
+{
+    hostclock::advance((uint64_t)ms * 1000);
+}
@@ -0,0 +1,137 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include "./SimLink.h"
+#include "./Arduino.h"
+
+static const char base64Table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static std::string base64Of(const std::vector<uint8_t> &data)
+{
+    std::string text;
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        uint32_t bits = data[i] << 16;
+        bits |= (i + 1 < data.size()) ? data[i + 1] << 8 : 0;
+        bits |= (i + 2 < data.size()) ? data[i + 2] : 0;
+        text += base64Table[(bits >> 18) & 0x3f];
+        text += base64Table[(bits >> 12) & 0x3f];
+        text += (i + 1 < data.size()) ? base64Table[(bits >> 6) & 0x3f] : '=';
+        text += (i + 2 < data.size()) ? base64Table[bits & 0x3f] : '=';
+    }
+    return text;
+}
+
+SimLink::SimLink(const Config &config) : _config(config), _reply(), _replyHead(0), _readyUs(0), _image(), _transactions(0), _seed(1)
+{
+}
+
+int SimLink::available(void)
+{
+    transaction(SIM_LINK_HEADER);
+    delay(_config.waitDelayMs);
+    transaction(2);
+    delay(_config.waitDelayMs);
+    if (hostclock::us < _readyUs)
+    {
+        return 0;
+    }
+    return (int)(_reply.size() - _replyHead);
+}
+
+int SimLink::read(char *data, int length)
+{
+    int n = 0;
+    while (n < length)
+    {
+        int packet = length - n < SIM_LINK_PACKET ? length - n : SIM_LINK_PACKET;
+        transaction(SIM_LINK_HEADER);
+        delay(_config.waitDelayMs);
+        transaction(packet);
+        delay(_config.waitDelayMs);
+        n += packet;
+    }
+
+    // the device pads a read past its data, the callers only read what available() said
+    int valid = (hostclock::us >= _readyUs) ? (int)(_reply.size() - _replyHead) : 0;
+    valid = valid < length ? valid : length;
+    memcpy(data, _reply.data() + _replyHead, valid);
+    _replyHead += valid;
+    return valid;
+}
+
+int SimLink::write(const char *data, int length)
+{
+    for (int n = 0; n < length; n += SIM_LINK_PACKET)
+    {
+        int packet = length - n < SIM_LINK_PACKET ? length - n : SIM_LINK_PACKET;
+        transaction(SIM_LINK_HEADER + packet);
+        delay(_config.waitDelayMs);
+    }
+    makeReply(std::string(data, length));
+    _readyUs = hostclock::us + (uint64_t)_config.computeMs * 1000;
+    return length;
+}
+
+void SimLink::transaction(uint32_t bytes)
+{
+    uint64_t us = _config.latencyUs + (uint64_t)bytes * 9 * 1000000 / _config.clockHz;
+    if (_config.jitterUs)
+    {
+        us += random() % (_config.jitterUs + 1);
+    }
+    hostclock::advance(us);
+    _transactions++;
+}
+
+uint32_t SimLink::random(void)
+{
+    _seed = _seed * 1103515245 + 12345;
+    return _seed >> 16;
+}
+
+void SimLink::makeReply(const std::string &command)
+{
+    _replyHead = 0;
+    int times = 0, differed = 0, resultOnly = 1;
+    bool isInvoke = sscanf(command.c_str(), "AT+INVOKE=%d,%d,%d", &times, &differed, &resultOnly) == 3;
+    if (isInvoke && resultOnly == 0)
+    {
+        _image.resize(_config.imageSize);
+        for (size_t i = 0; i < _image.size(); i++)
+        {
+            _image[i] = (uint8_t)random();
+        }
+        _reply = "\r{\"type\": 1, \"name\": \"INVOKE\", \"code\": 0, \"data\": {\"count\": 1, "
+                 "\"perf\": [5, 60, 1], \"boxes\": [[96, 96, 40, 120, 80, 0]], \"resolution\": [240, 240], \"image\": \"" +
+                 base64Of(_image) + "\"}}\n";
+    }
+    else if (isInvoke)
+    {
+        _reply = "\r{\"type\": 1, \"name\": \"INVOKE\", \"code\": 0, \"data\": {\"count\": 1, "
+                 "\"perf\": [5, 60, 1], \"boxes\": [[96, 96, 40, 120, 80, 0]], \"resolution\": [240, 240]}}\n";
+    }
+    else
+    {
+        size_t end = command.find_first_of("=?\r", 3);
+        std::string name = command.substr(3, end == std::string::npos ? std::string::npos : end - 3);
+        _reply = "\r{\"type\": 0, \"name\": \"" + name + "\", \"code\": 0, \"data\": {}}\n";
+    }
+}
@@ -0,0 +1,80 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Simulated SSCMA I2C link, with the transaction costs of the Seeed_Arduino_SSCMA transport
+//   every call is one transaction: latency (+ random jitter) + 9 bit times per byte
+//   available(): command packet, wait delay, 2 byte answer, wait delay
+//   read()     : per packet of at most SIM_LINK_PACKET bytes, command, wait, data, wait
+//   write()    : per packet, command + data, wait
+// Replies to a write:
+//   AT+INVOKE=n,d,0 : JSON event with an "image" field holding imageSize random bytes
+//   AT+INVOKE=n,d,1 : JSON event with one box, no image (RESULT_ONLY)
+//   AT+<name>...    : {"type": 0, "name": "<NAME>", "code": 0}
+// A reply becomes available computeMs after the write, all at once.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define SIM_LINK_PACKET 250 // MAX_PL_LEN of the SSCMA library
+#define SIM_LINK_HEADER 6   // feature, command, length (2), checksum (2)
+
+class SimLink
+{
+public:
+    struct Config
+    {
+        uint32_t clockHz;
+        uint32_t waitDelayMs;
+        uint32_t latencyUs; // injected per transaction
+        uint32_t jitterUs;  // max random extra per transaction
+        uint32_t computeMs; // from a command to its reply
+        uint32_t imageSize; // bytes of the JPEG in the image reply
+    };
+
+    explicit SimLink(const Config &config);
+
+    int available(void);
+    int read(char *data, int length);
+    int write(const char *data, int length);
+
+    const std::vector<uint8_t> &image(void) const
+    {
+        return _image;
+    }
+    uint32_t transactions(void) const
+    {
+        return _transactions;
+    }
+
+private:
+    Config _config;
+    std::string _reply;
+    size_t _replyHead;
+    uint64_t _readyUs; // virtual time the reply becomes available
+    std::vector<uint8_t> _image;
+    uint32_t _transactions;
+    uint32_t _seed;
+
+    void transaction(uint32_t bytes);
+    uint32_t random(void);
+    void makeReply(const std::string &command);
+};
@@ -0,0 +1,199 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include "./Arduino.h"
+#include "./SimLink.h"
+#include "app/driver/npu/NpuAt.h"
+#include "app/driver/npu/NpuLink.h"
+#include "app/driver/npu/NpuLinkBench.h"
+#include "app/driver/npu/NpuSnapshot.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// NpuLink on a simulated SSCMA I2C link (SimLink), in virtual time
+//   1. check: NpuAt and NpuSnapshot over NpuLink, Direct and Bulk, at odd chunk sizes,
+//      must return the reply code and the exact image bytes; exit status 1 otherwise
+//   2. bench: the same sweep as the "bench" console command (ThreadNpu), plus the
+//      AT command round trip, which NpuAt reads byte by byte
+////////////////////////////////////////////////////////////////////////////////////////////
+#define LINKBENCH_AT_COMMANDS 10 // AT command round trips per mode
+
+uint64_t hostclock::us = 0;
+
+static const uint32_t clocks[] = {100000, 400000, 1000000};
+static const int chunks[] = {32, 64, 128, 256, 512, 1024};
+
+class ImageSink
+{
+public:
+    size_t write(const uint8_t *data, size_t length)
+    {
+        bytes.insert(bytes.end(), data, data + length);
+        return length;
+    }
+
+    std::vector<uint8_t> bytes;
+};
+
+static const char *modeName(NpuLinkMode mode)
+{
+    return mode == NpuLinkDirect ? "direct" : "bulk";
+}
+
+static bool check(const SimLink::Config &config)
+{
+    static const int checkChunks[] = {1, 7, 250, 251, NPU_LINK_CHUNK_MAX};
+    static const NpuLinkMode modes[] = {NpuLinkDirect, NpuLinkBulk};
+    bool isOk = true;
+
+    for (NpuLinkMode mode : modes)
+    {
+        for (int chunk : checkChunks)
+        {
+            SimLink sim(config);
+            NpuLink<SimLink> link(sim);
+            link.setMode(mode, chunk);
+
+            // twice: the rest of the first reply must not leak into the second one
+            for (int n = 0; n < 2; n++)
+            {
+                if (NpuAt<NpuLink<SimLink>>::command(link, "MODEL=2", "MODEL") != 0)
+                {
+                    printf("FAIL %s %d: AT+MODEL reply %d\n", modeName(mode), chunk, n);
+                    isOk = false;
+                }
+            }
+
+            NpuSnapshot<NpuLink<SimLink>> snapshot;
+            ImageSink sink;
+            NpuSnapshot<NpuLink<SimLink>>::Report report = snapshot.stream(link, sink);
+            if (!report.isOk || sink.bytes != sim.image())
+            {
+                printf("FAIL %s %d: snapshot %u of %u bytes\n", modeName(mode), chunk, (unsigned)sink.bytes.size(),
+                       (unsigned)sim.image().size());
+                isOk = false;
+            }
+        }
+    }
+    printf("check: %s\n", isOk ? "ok" : "FAIL");
+    return isOk;
+}
+
+static void printResult(const char *name, int chunk, const NpuLinkBench<SimLink>::Result &result)
+{
+    printf("  %-6s %5d: %6u bytes %8u bytes/s %6u transactions, first byte %u ms\n", name, chunk, (unsigned)result.bytes,
+           (unsigned)result.bytesPerSecond(), (unsigned)result.transactions, (unsigned)(result.firstByteUs / 1000));
+}
+
+static void bench(SimLink::Config config)
+{
+    static const NpuLinkMode modes[] = {NpuLinkDirect, NpuLinkBulk};
+
+    for (uint32_t clock : clocks)
+    {
+        config.clockHz = clock;
+        SimLink sim(config);
+        NpuLink<SimLink> link(sim);
+        printf("clock %u Hz\n", (unsigned)clock);
+
+        NpuLinkBench<SimLink>::Result result = NpuLinkBench<SimLink>::transfer(link, NpuLinkBulk, NPU_LINK_CHUNK_MAX);
+        uint32_t roundTripMs = (result.firstByteUs + result.transferUs) / 1000;
+        printf("  invoke with image: %u ms round trip, %u ms compute, %u ms transport\n", (unsigned)roundTripMs, (unsigned)config.computeMs,
+               (unsigned)(roundTripMs > config.computeMs ? roundTripMs - config.computeMs : 0));
+
+        for (NpuLinkMode mode : modes)
+        {
+            link.setMode(mode);
+            link.resetStats();
+            uint64_t start = hostclock::us;
+            for (int n = 0; n < LINKBENCH_AT_COMMANDS; n++)
+            {
+                NpuAt<NpuLink<SimLink>>::command(link, "MODEL=2", "MODEL");
+            }
+            printf("  AT     %-6s: %u ms round trip, %u transactions\n", modeName(mode),
+                   (unsigned)((hostclock::us - start) / 1000 / LINKBENCH_AT_COMMANDS),
+                   (unsigned)(link.stats().transactions / LINKBENCH_AT_COMMANDS));
+        }
+
+        printResult("direct", NPU_SNAPSHOT_CHUNK, NpuLinkBench<SimLink>::transfer(link, NpuLinkDirect, NPU_SNAPSHOT_CHUNK));
+        for (int chunk : chunks)
+        {
+            printResult("bulk", chunk, NpuLinkBench<SimLink>::transfer(link, NpuLinkBulk, chunk));
+        }
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-l latency_us] [-j jitter_us] [-w wait_ms] [-c compute_ms] [-s image_bytes] [-q]\n", name);
+    fprintf(stderr, "  -l  latency injected per transaction, default 100 us\n");
+    fprintf(stderr, "  -j  max random extra latency per transaction, default 0 us\n");
+    fprintf(stderr, "  -w  SSCMA wait delay around each transaction, default 2 ms\n");
+    fprintf(stderr, "  -c  WE2 time from a command to its reply, default 66 ms\n");
+    fprintf(stderr, "  -s  JPEG size of the image reply, default 12000 bytes\n");
+    fprintf(stderr, "  -q  check only, no bench\n");
+}
+
+int main(int argc, char *argv[])
+{
+    SimLink::Config config = {400000, 2, 100, 0, 66, 12000};
+    bool isBench = true;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "l:j:w:c:s:q")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            config.latencyUs = atoi(optarg);
+            break;
+        case 'j':
+            config.jitterUs = atoi(optarg);
+            break;
+        case 'w':
+            config.waitDelayMs = atoi(optarg);
+            break;
+        case 'c':
+            config.computeMs = atoi(optarg);
+            break;
+        case 's':
+            config.imageSize = atoi(optarg);
+            break;
+        case 'q':
+            isBench = false;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!check(config))
+    {
+        return 1;
+    }
+    if (isBench)
+    {
+        bench(config);
+    }
+    return 0;
+}
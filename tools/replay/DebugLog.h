@@ -0,0 +1,77 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include <iostream>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Minimal host stand-in for https://github.com/hideakitai/DebugLog
+//   LOG_* print to stderr when debuglog::isEnabled is set (replay -v)
+////////////////////////////////////////////////////////////////////////////////////////////
+namespace debuglog
+{
+    extern bool isEnabled;
+
+    // Arduino Print shows 8-bit integers as numbers, not characters
+    template <typename T>
+    inline void put(const T &value)
+    {
+        std::cerr << value;
+    }
+
+    inline void put(uint8_t value)
+    {
+        std::cerr << (int)value;
+    }
+
+    inline void put(int8_t value)
+    {
+        std::cerr << (int)value;
+    }
+
+    inline void print(void)
+    {
+        std::cerr << std::endl;
+    }
+
+    template <typename T, typename... Args>
+    inline void print(const T &head, const Args &...args)
+    {
+        put(head);
+        print(args...);
+    }
+} // namespace debuglog
+
+#define LOG_LOG(level, ...)                   \
+    do                                        \
+    {                                         \
+        if (debuglog::isEnabled)              \
+        {                                     \
+            std::cerr << "[" level "] ";      \
+            debuglog::print(__VA_ARGS__);     \
+        }                                     \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_LOG("ERROR", __VA_ARGS__)
+#define LOG_WARN(...) LOG_LOG("WARN", __VA_ARGS__)
+#define LOG_INFO(...) LOG_LOG("INFO", __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_LOG("DEBUG", __VA_ARGS__)
+#define LOG_TRACE(...) LOG_LOG("TRACE", __VA_ARGS__)
+#define PRINTLN(...) debuglog::print(__VA_ARGS__)
@@ -0,0 +1,148 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include "./MockSSCMA.h"
+
+MockSSCMA::MockSSCMA() : _frames(),
+                         _current(),
+                         _emptyPerf(),
+                         _framePeriod(100),
+                         _time(0),
+                         _invokeCount(0)
+{
+}
+
+bool MockSSCMA::load(const char *path, int *line)
+{
+    std::ifstream file(path);
+    *line = 0;
+    if (!file)
+    {
+        return false;
+    }
+
+    _frames.clear();
+    std::string text;
+    while (std::getline(file, text))
+    {
+        (*line)++;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos)
+        {
+            text.erase(comment);
+        }
+
+        std::istringstream in(text);
+        std::string item;
+        if (!(in >> item))
+        {
+            continue; // blank line
+        }
+
+        unsigned v[6];
+        if (item == "frame")
+        {
+            if (!(in >> v[0] >> v[1] >> v[2]))
+            {
+                return false;
+            }
+            Frame frame;
+            frame.perf.prepocess = v[0];
+            frame.perf.inference = v[1];
+            frame.perf.postprocess = v[2];
+            _frames.push_back(frame);
+            _emptyPerf = frame.perf;
+            continue;
+        }
+        if (_frames.empty())
+        {
+            return false; // item outside of a frame
+        }
+
+        Frame &frame = _frames.back();
+        if (item == "box" || item == "keypoint")
+        {
+            if (!(in >> v[0] >> v[1] >> v[2] >> v[3] >> v[4] >> v[5]))
+            {
+                return false;
+            }
+            boxes_t box = {(uint16_t)v[0], (uint16_t)v[1], (uint16_t)v[2], (uint16_t)v[3], (uint8_t)v[4], (uint8_t)v[5]};
+            if (item == "box")
+            {
+                frame.boxes.push_back(box);
+            }
+            else
+            {
+                keypoints_t keypoint;
+                keypoint.box = box;
+                unsigned x, y;
+                while (in >> x >> y)
+                {
+                    point_t point = {(uint16_t)x, (uint16_t)y, 0, box.score, box.target};
+                    keypoint.points.push_back(point);
+                }
+                frame.keypoints.push_back(keypoint);
+            }
+        }
+        else if (item == "class")
+        {
+            if (!(in >> v[0] >> v[1]))
+            {
+                return false;
+            }
+            classes_t cls = {(uint8_t)v[0], (uint8_t)v[1]};
+            frame.classes.push_back(cls);
+        }
+        else if (item == "point")
+        {
+            if (!(in >> v[0] >> v[1] >> v[2] >> v[3] >> v[4]))
+            {
+                return false;
+            }
+            point_t point = {(uint16_t)v[0], (uint16_t)v[1], (uint16_t)v[2], (uint8_t)v[3], (uint8_t)v[4]};
+            frame.points.push_back(point);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int MockSSCMA::invoke(int times, bool filter, bool show)
+{
+    _invokeCount++;
+
+    uint32_t index = _time / _framePeriod;
+    if (index < _frames.size())
+    {
+        _current = _frames[index];
+    }
+    else
+    {
+        _current = Frame();
+        _current.perf = _emptyPerf;
+    }
+    return 0;
+}
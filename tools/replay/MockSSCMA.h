@@ -0,0 +1,136 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Mock of Seeed_Arduino_SSCMA replaying a recorded result stream
+//
+// Recording format: one item per line, '#' starts a comment
+//   frame <prepocess> <inference> <postprocess>           start of a frame, perf in ms
+//   box <x> <y> <w> <h> <score> <target>
+//   class <target> <score>
+//   point <x> <y> <z> <score> <target>
+//   keypoint <x> <y> <w> <h> <score> <target> [<px> <py>]...
+//
+// Frames are spaced by the camera frame period: invoke() at time t returns frame
+// t / framePeriod, as a camera stream sampled by the inference timer would.
+// Past the end of the recording, the scene is empty.
+////////////////////////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint8_t score;
+    uint8_t target;
+} boxes_t;
+
+typedef struct
+{
+    uint8_t target;
+    uint8_t score;
+} classes_t;
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+    uint8_t score;
+    uint8_t target;
+} point_t;
+
+typedef struct
+{
+    boxes_t box;
+    std::vector<point_t> points;
+} keypoints_t;
+
+typedef struct
+{
+    uint16_t prepocess;
+    uint16_t inference;
+    uint16_t postprocess;
+} perf_t;
+
+class MockSSCMA
+{
+public:
+    struct Frame
+    {
+        perf_t perf;
+        std::vector<boxes_t> boxes;
+        std::vector<classes_t> classes;
+        std::vector<point_t> points;
+        std::vector<keypoints_t> keypoints;
+    };
+
+    MockSSCMA();
+
+    // return false with *line set to the failing line number on a parse error
+    bool load(const char *path, int *line);
+
+    void setFramePeriod(uint32_t ms)
+    {
+        _framePeriod = ms ? ms : 1;
+    }
+
+    // virtual time of the next invoke(), in unit of ms
+    void setTime(uint32_t ms)
+    {
+        _time = ms;
+    }
+
+    // same return convention as SSCMA::invoke(): 0 on success
+    int invoke(int times = 1, bool filter = 0, bool show = 0);
+
+    uint32_t frameCount(void) const
+    {
+        return _frames.size();
+    }
+
+    uint32_t duration(void) const
+    {
+        return frameCount() * _framePeriod;
+    }
+
+    uint32_t invokeCount(void) const
+    {
+        return _invokeCount;
+    }
+
+    perf_t &perf(void) { return _current.perf; }
+    std::vector<boxes_t> &boxes(void) { return _current.boxes; }
+    std::vector<classes_t> &classes(void) { return _current.classes; }
+    std::vector<point_t> &points(void) { return _current.points; }
+    std::vector<keypoints_t> &keypoints(void) { return _current.keypoints; }
+
+private:
+    std::vector<Frame> _frames;
+    Frame _current;
+    perf_t _emptyPerf; // perf reported past the end of the recording
+    uint32_t _framePeriod;
+    uint32_t _time;
+    uint32_t _invokeCount;
+};
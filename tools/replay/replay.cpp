@@ -0,0 +1,404 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "./MockSSCMA.h"
+#include "app/npu/NpuPipeline.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Replay a recorded SSCMA result stream through the ThreadNpu detection logic
+// (NpuPipeline + NpuTracker + NpuScheduler) in virtual time, on a Linux host
+////////////////////////////////////////////////////////////////////////////////////////////
+#define REPLAY_FRAME_PERIOD 100 // in unit of ms, camera frame period of the recording
+
+bool debuglog::isEnabled = false;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Stand-in for QueueMain, not a copy of it: it counts the events and keeps the one rule of
+// QueueMain::handlerEventNpuFrame() which decides the messages, no second message for the
+// decision last sent until the visit (a pass) is over. It differs from QueueMain in that
+//   - a message is sent instantly, so no decision is ever held while a message is being
+//     sent (QueueMain::sendAlert()), and there is no send failure
+//   - no snapshot is requested, no latency is stamped (AlertLatency)
+// tools/host runs the real QueueMain, with ThreadMessaging and the network delays
+////////////////////////////////////////////////////////////////////////////////////////////
+class StubQueueMain
+{
+public:
+    struct Notification
+    {
+        uint32_t pass;
+        uint32_t ms;
+        int16_t decision;
+    };
+
+    StubQueueMain() : _lastNpuResult(IpcNpuNoObjectDetected), _frameEvents(0), _idleEvents(0), _decisions(), _notifications()
+    {
+    }
+
+    // the PIR is released between passes: QueueMain forgets the last decision on IpcNpuIdle
+    // only then, not when it restarts the NPU with the PIR still active
+    void startVisit(void)
+    {
+        _lastNpuResult = IpcNpuNoObjectDetected;
+    }
+
+    void postEvent(uint32_t pass, uint32_t ms, int16_t event, int16_t iParam, uint16_t uParam, uint32_t lParam)
+    {
+        if (event == EventIpc && iParam == IpcNpuIdle)
+        {
+            LOG_TRACE("t=", ms, " EventIpc(IpcNpuIdle)");
+            _idleEvents++;
+            return;
+        }
+        if (event != EventNpuFrame)
+        {
+            return;
+        }
+
+        _frameEvents++;
+        NpuFrame frame = NpuFrame::unpack(iParam, uParam, lParam);
+        LOG_TRACE("t=", ms, " EventNpuFrame: decision=", getDecisionString(frame.decision), ", seq=", frame.seq, ", boxes=", (int)frame.boxCount,
+                  ", tenant=", (int)frame.tenantScore, ", stranger=", (int)frame.strangerScore, ", ms=", frame.inferenceMs);
+        if (frame.decision >= IpcNpuNoObjectDetected && frame.decision <= IpcNpuTenderDetected)
+        {
+            _decisions[frame.decision - IpcNpuNoObjectDetected]++;
+        }
+
+        if ((frame.decision == IpcNpuStrangerDetected || frame.decision == IpcNpuTenderDetected) && _lastNpuResult != frame.decision)
+        {
+            _lastNpuResult = frame.decision;
+            Notification notification = {pass, ms, frame.decision};
+            _notifications.push_back(notification);
+        }
+    }
+
+    uint32_t frameEvents(void) const
+    {
+        return _frameEvents;
+    }
+
+    uint32_t idleEvents(void) const
+    {
+        return _idleEvents;
+    }
+
+    uint32_t decisionCount(int16_t decision) const
+    {
+        return _decisions[decision - IpcNpuNoObjectDetected];
+    }
+
+    const std::vector<Notification> &notifications(void) const
+    {
+        return _notifications;
+    }
+
+    static const char *getDecisionString(int16_t decision)
+    {
+        switch (decision)
+        {
+        case IpcNpuNoObjectDetected:
+            return "no object";
+        case IpcNpuStrangerDetected:
+            return "stranger";
+        case IpcNpuTenderDetected:
+            return "tenant";
+        case IpcNpuObjectUnclassified:
+            return "unclassified";
+        default:
+            return "unknown";
+        }
+    }
+
+private:
+    int16_t _lastNpuResult;
+    uint32_t _frameEvents;
+    uint32_t _idleEvents;
+    uint32_t _decisions[IpcNpuTenderDetected - IpcNpuNoObjectDetected + 1];
+    std::vector<Notification> _notifications;
+};
+
+// zones file: one zone per line, '#' starts a comment
+//   include|exclude <x> <y> <x> <y> [<x> <y>]...   2 points = rectangle, more = polygon
+static bool loadZones(const char *path, NpuZoneFilter &zones, int *line)
+{
+    std::ifstream file(path);
+    *line = 0;
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string text;
+    while (std::getline(file, text))
+    {
+        (*line)++;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos)
+        {
+            text.erase(comment);
+        }
+
+        std::istringstream in(text);
+        std::string rule;
+        if (!(in >> rule))
+        {
+            continue;
+        }
+        if (rule != "include" && rule != "exclude")
+        {
+            return false;
+        }
+
+        NpuPoint points[NPU_ZONE_POINT_MAX];
+        uint8_t count = 0;
+        int x, y;
+        while (count < NPU_ZONE_POINT_MAX && in >> x >> y)
+        {
+            points[count].x = x;
+            points[count].y = y;
+            count++;
+        }
+        if (!zones.add(rule == "exclude" ? NpuZone::Exclude : NpuZone::Include, points, count))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Model>
+static uint64_t replay(MockSSCMA &ai, NpuScheduler &scheduler, StubQueueMain &queueMain, NpuZoneFilter &zones, const NpuThreshold &threshold, uint32_t fixedPeriod, uint32_t passes, uint32_t *sessions)
+{
+    NpuPipeline<MockSSCMA, Model> pipeline;
+    pipeline.zones() = zones;
+    pipeline.threshold() = threshold;
+    uint64_t virtualMs = 0;
+    uint16_t frameSeq = 0;
+
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        // the PIR is assumed to stay active for the whole recording: a session that backs off
+        // to idle before the end is restarted, as QueueMain does on IpcNpuIdle
+        uint32_t now = 0;
+        bool isRunning = false;
+        queueMain.startVisit();
+        while (isRunning || now < ai.duration())
+        {
+            if (!isRunning)
+            {
+                isRunning = true;
+                (*sessions)++;
+                scheduler.start();
+                pipeline.reset();
+            }
+
+            ai.setTime(now);
+            bool isOk = !ai.invoke();
+
+            NpuFrame frame = {};
+            frame.seq = frameSeq++;
+            frame.inferenceMs = ai.perf().prepocess + ai.perf().inference + ai.perf().postprocess;
+            NpuScheduler::FrameResult result = pipeline.process(ai, isOk, frame);
+            queueMain.postEvent(pass, now, EventNpuFrame, frame.decision, frame.packScores(), frame.packInfo());
+
+            uint32_t period = fixedPeriod;
+            if (fixedPeriod)
+            {
+                isRunning = now + period < ai.duration();
+            }
+            else
+            {
+                scheduler.onFrame(result);
+                if (!scheduler.isRunning())
+                {
+                    isRunning = false;
+                    queueMain.postEvent(pass, now, EventIpc, IpcNpuIdle, 0, 0);
+                }
+                period = scheduler.period();
+            }
+            // the next inference cannot start before the current one is done
+            now += (period > frame.inferenceMs) ? period : frame.inferenceMs;
+        }
+        virtualMs += now;
+    }
+    zones = pipeline.zones(); // with the drop counters
+    return virtualMs;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-f frame_ms] [-p period_ms] [-n passes] [-m b|c|p|a] [-z zones] [-t class:enter:leave[:role]]... [-v] recording\n", name);
+    fprintf(stderr, "  -f  camera frame period of the recording in ms (default %d)\n", REPLAY_FRAME_PERIOD);
+    fprintf(stderr, "  -p  fixed inference period in ms (default 0: adaptive, NpuScheduler)\n");
+    fprintf(stderr, "  -n  replay the recording n times, for benchmarking (default 1)\n");
+    fprintf(stderr, "  -m  model-output policy: b=box (default), c=class, p=pose, a=all\n");
+    fprintf(stderr, "  -z  region-of-interest zones file, see loadZones()\n");
+    fprintf(stderr, "  -t  thresholds of a class, role 0=ignore, 1=tenant, 2=stranger (see NpuThreshold.h)\n");
+    fprintf(stderr, "  -v  trace every frame and posted event\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t framePeriod = REPLAY_FRAME_PERIOD;
+    uint32_t fixedPeriod = 0;
+    uint32_t passes = 1;
+    char model = 'b';
+    const char *zonePath = nullptr;
+    NpuThreshold threshold;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:p:n:m:z:t:v")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            framePeriod = strtoul(optarg, nullptr, 0);
+            break;
+        case 'p':
+            fixedPeriod = strtoul(optarg, nullptr, 0);
+            break;
+        case 'n':
+            passes = strtoul(optarg, nullptr, 0);
+            break;
+        case 'm':
+            model = optarg[0];
+            break;
+        case 'z':
+            zonePath = optarg;
+            break;
+        case 't':
+        {
+            unsigned classId, enter, leave, role;
+            int n = sscanf(optarg, "%u:%u:%u:%u", &classId, &enter, &leave, &role);
+            if (n < 3 || !threshold.set(classId, enter, leave) || (n == 4 && !threshold.setRole(classId, static_cast<NpuThreshold::Role>(role))))
+            {
+                fprintf(stderr, "invalid threshold: %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'v':
+            debuglog::isEnabled = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1 || framePeriod == 0 || passes == 0 || !strchr("bcpa", model))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    MockSSCMA ai;
+    int line;
+    if (!ai.load(argv[optind], &line))
+    {
+        fprintf(stderr, "%s:%d: cannot load recording\n", argv[optind], line);
+        return 1;
+    }
+    ai.setFramePeriod(framePeriod);
+
+    NpuZoneFilter zones;
+    if (zonePath && !loadZones(zonePath, zones, &line))
+    {
+        fprintf(stderr, "%s:%d: cannot load zones\n", zonePath, line);
+        return 1;
+    }
+
+    NpuScheduler scheduler;
+    StubQueueMain queueMain;
+    uint32_t sessions = 0;
+    uint64_t virtualMs = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    switch (model)
+    {
+    case 'c':
+        virtualMs = replay<NpuModelClass>(ai, scheduler, queueMain, zones, threshold, fixedPeriod, passes, &sessions);
+        break;
+    case 'p':
+        virtualMs = replay<NpuModelPose>(ai, scheduler, queueMain, zones, threshold, fixedPeriod, passes, &sessions);
+        break;
+    case 'a':
+        virtualMs = replay<NpuModelAll>(ai, scheduler, queueMain, zones, threshold, fixedPeriod, passes, &sessions);
+        break;
+    case 'b':
+    default:
+        virtualMs = replay<NpuModelBox>(ai, scheduler, queueMain, zones, threshold, fixedPeriod, passes, &sessions);
+        break;
+    }
+    double wallUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    printf("recording   : %s, %u frames, %u ms (frame period %u ms)\n", argv[optind], ai.frameCount(), ai.duration(), framePeriod);
+    if (fixedPeriod)
+    {
+        printf("rate        : fixed, %u ms\n", fixedPeriod);
+    }
+    else
+    {
+        printf("rate        : adaptive (NpuScheduler)\n");
+    }
+    printf("model       : %s\n", model == 'c' ? "class" : model == 'p' ? "pose" : model == 'a' ? "all" : "box");
+    printf("passes      : %u, sessions: %u, virtual time: %llu ms\n", passes, sessions, (unsigned long long)virtualMs);
+    printf("inferences  : %u (%.2f per virtual second)\n", ai.invokeCount(), virtualMs ? ai.invokeCount() * 1000.0 / virtualMs : 0.0);
+    if (!fixedPeriod)
+    {
+        printf("  per state :");
+        for (int i = NpuScheduler::Burst; i < NpuScheduler::StateCount; i++)
+        {
+            NpuScheduler::State state = static_cast<NpuScheduler::State>(i);
+            printf(" %s=%u", NpuScheduler::getStateString(state), scheduler.totalCount(state));
+        }
+        printf("\n");
+    }
+    printf("decisions   : no object=%u, unclassified=%u, tenant=%u, stranger=%u\n",
+           queueMain.decisionCount(IpcNpuNoObjectDetected), queueMain.decisionCount(IpcNpuObjectUnclassified),
+           queueMain.decisionCount(IpcNpuTenderDetected), queueMain.decisionCount(IpcNpuStrangerDetected));
+    printf("QueueMain   : EventNpuFrame=%u, EventIpc(IpcNpuIdle)=%u\n", queueMain.frameEvents(), queueMain.idleEvents());
+    for (int i = 0; i < zones.zoneCount(); i++)
+    {
+        printf("zone[%d]     : %s, %u points, dropped=%u\n", i, NpuZone::getRuleString(zones.zone(i).rule()), zones.zone(i).pointCount(), zones.zone(i).dropCount());
+    }
+    if (zones.zoneCount())
+    {
+        printf("  outside   : dropped=%u\n", zones.outsideCount());
+    }
+    printf("messages    : %u\n", (unsigned)queueMain.notifications().size());
+    for (const auto &notification : queueMain.notifications())
+    {
+        if (notification.pass == 0)
+        {
+            printf("  t=%u ms %s\n", notification.ms, StubQueueMain::getDecisionString(notification.decision));
+        }
+    }
+    printf("throughput  : %.0f inferences/s on host (%.3f us per inference)\n",
+           wallUs > 0 ? ai.invokeCount() * 1e6 / wallUs : 0.0, ai.invokeCount() ? wallUs / ai.invokeCount() : 0.0);
+    return 0;
+}
@@ -0,0 +1,175 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <thread>
+#include "app/util/SpscRing.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Stress test of SpscRing, the ring GpioEdgeRing puts between the GPIO ISRs and QueueMain
+//   A producer thread pushes numbered edge records as fast as it can, a consumer thread
+//   pops them. Each record carries its number in every field, so a torn record shows.
+//   lossless: the producer retries a full ring; the consumer must get every record, in order
+//   lossy   : the producer drops on a full ring, as the ISRs do, and waits a random spin
+//             between pushes, as edges come apart; the consumer must get the records in
+//             increasing order, and received + overflows must equal pushed
+// Run once per ring size: the size of GpioEdgeRing, and a tiny one to make the indices wrap
+// and the ring fill as often as possible.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define SPSCSTRESS_RING_SIZE 32 // GPIO_EDGE_RING_SIZE
+
+struct Edge
+{
+    uint32_t ms;
+    uint8_t pin;
+    uint8_t level;
+};
+
+static Edge makeEdge(uint32_t seq)
+{
+    Edge edge;
+    edge.ms = seq;
+    edge.pin = seq & 0xff;
+    edge.level = (seq >> 8) & 0xff;
+    return edge;
+}
+
+static bool isIntact(const Edge &edge)
+{
+    return edge.pin == (edge.ms & 0xff) && edge.level == ((edge.ms >> 8) & 0xff);
+}
+
+// xorshift32, the producer only
+static uint32_t nextRandom(void)
+{
+    static uint32_t state = 2463534242UL;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+template <uint32_t N>
+static bool stress(uint32_t count, bool isLossy, uint32_t spin)
+{
+    SpscRing<Edge, N> ring;
+    uint32_t errors = 0;
+    uint32_t received = 0;
+
+    std::thread consumer([&]()
+                         {
+                             uint32_t expected = 0;
+                             for (;;)
+                             {
+                                 Edge edge;
+                                 if (!ring.pop(&edge))
+                                 {
+                                     if (expected >= count || (isLossy && received + ring.overflows() >= count))
+                                     {
+                                         break;
+                                     }
+                                     std::this_thread::yield();
+                                     continue;
+                                 }
+                                 if (!isIntact(edge) || (isLossy ? edge.ms < expected : edge.ms != expected))
+                                 {
+                                     if (errors++ < 5)
+                                     {
+                                         fprintf(stderr, "  record %u (pin %u, level %u) where %u was expected\n", (unsigned)edge.ms,
+                                                 edge.pin, edge.level, (unsigned)expected);
+                                     }
+                                 }
+                                 expected = edge.ms + 1;
+                                 received++;
+                             } });
+
+    for (uint32_t seq = 0; seq < count; seq++)
+    {
+        if (isLossy)
+        {
+            ring.push(makeEdge(seq));
+            for (volatile uint32_t i = spin ? nextRandom() % spin : 0; i; i--)
+            {
+            }
+        }
+        else
+        {
+            while (!ring.push(makeEdge(seq)))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+    consumer.join();
+
+    uint32_t overflows = ring.overflows();
+    // lossless: overflows count the retries of the producer
+    bool isOk = !errors && (isLossy ? received + overflows == count : received == count);
+    printf("  ring %3u, %-8s: %u pushed, %u received, %u overflows, %u errors: %s\n", (unsigned)N,
+           isLossy ? "lossy" : "lossless", (unsigned)count, (unsigned)received, (unsigned)overflows, (unsigned)errors,
+           isOk ? "ok" : "FAILED");
+    return isOk;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n records] [-r rounds] [-s spin]\n", name);
+    fprintf(stderr, "  defaults: -n 10000000 -r 1 -s 200\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t count = 10000000;
+    uint32_t rounds = 1;
+    uint32_t spin = 200; // lossy producer, max busy loop between pushes
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            count = strtoul(optarg, nullptr, 0);
+            break;
+        case 'r':
+            rounds = strtoul(optarg, nullptr, 0);
+            break;
+        case 's':
+            spin = strtoul(optarg, nullptr, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    bool isOk = true;
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        printf("round %u\n", (unsigned)round + 1);
+        isOk &= stress<SPSCSTRESS_RING_SIZE>(count, false, spin);
+        isOk &= stress<SPSCSTRESS_RING_SIZE>(count, true, spin);
+        isOk &= stress<2>(count, false, spin);
+        isOk &= stress<2>(count, true, spin);
+    }
+    printf("spscstress: %s\n", isOk ? "ok" : "FAILED");
+    return isOk ? 0 : 1;
+}
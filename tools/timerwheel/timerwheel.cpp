@@ -0,0 +1,250 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <set>
+#include <vector>
+#include "app/util/TimerWheel.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Host check and wake-up count of TimerWheel, the wheel of TimerService
+//   check  : random timers are started, restarted and stopped while the wheel advances by
+//            random steps (0 to a few thousand ticks, crossing every cascade), from a start
+//            time close to the 32-bit wrap; every expiry and nextExpiry() are compared with a
+//            brute-force model of the same rules.
+//   wakeups: the timers of the firmware during a visit (three 1Hz timers, the NPU timer
+//            stepping 100/250/1000/5000 ms, debounce ticks while the button is held), as one
+//            FreeRTOS timer each started at its own time, against the aligned wheel.
+////////////////////////////////////////////////////////////////////////////////////////////
+#define TICK_MS 5 // TIMER_SERVICE_TICK_MS
+
+struct Timer : public WheelNode
+{
+    int id;
+    // model
+    bool isActive;
+    uint32_t period;
+    uint32_t expiry;
+};
+
+struct Fired
+{
+    std::vector<std::pair<uint32_t, int>> events; // (tick, id)
+    const TimerWheel *wheel;
+};
+
+static void onExpiry(WheelNode *node, void *ctx)
+{
+    Fired *fired = static_cast<Fired *>(ctx);
+    fired->events.push_back(std::make_pair(fired->wheel->now(), static_cast<Timer *>(node)->id));
+}
+
+static uint32_t randomUpTo(uint32_t n)
+{
+    return (uint32_t)(((uint64_t)rand() * n) / ((uint64_t)RAND_MAX + 1));
+}
+
+static bool check(uint32_t steps, uint32_t seed)
+{
+    srand(seed);
+    const uint32_t start = 0xffffffffUL - 300000; // wraps during the run
+    TimerWheel wheel(start);
+    std::vector<Timer> timers(12);
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+        timers[i].id = i;
+        timers[i].isActive = false;
+    }
+
+    uint32_t now = start;
+    uint32_t errors = 0;
+    uint64_t expiries = 0;
+    for (uint32_t step = 0; step < steps && errors < 5; step++)
+    {
+        // start/stop a few timers, "from" may lead the wheel as in TimerService::start()
+        uint32_t from = now + randomUpTo(3);
+        for (int n = randomUpTo(3); n > 0; n--)
+        {
+            Timer &timer = timers[randomUpTo(timers.size())];
+            if (randomUpTo(4) == 0)
+            {
+                wheel.stop(&timer);
+                timer.isActive = false;
+            }
+            else
+            {
+                // short periods, the 1Hz..0.2Hz of the firmware, and beyond the wheel
+                static const uint32_t periods[] = {1, 2, 7, 20, 50, 63, 64, 65, 200, 1000, 4095, 4096, 5000, 300000};
+                uint32_t period = periods[randomUpTo(sizeof(periods) / sizeof(periods[0]))];
+                wheel.start(&timer, period, from);
+                timer.isActive = true;
+                timer.period = period;
+                timer.expiry = (from / period + 1) * period;
+            }
+        }
+
+        // advance, mostly short steps, sometimes long ones
+        uint32_t delta = randomUpTo(8) ? randomUpTo(70) : randomUpTo(9000);
+        uint32_t to = now + delta;
+
+        std::vector<std::pair<uint32_t, int>> expected;
+        for (uint32_t t = now + 1; (int32_t)(to - t) >= 0; t++)
+        {
+            for (size_t i = 0; i < timers.size(); i++)
+            {
+                Timer &timer = timers[i];
+                if (timer.isActive && timer.expiry == t)
+                {
+                    expected.push_back(std::make_pair(t, timer.id));
+                    uint32_t expiry = timer.expiry + timer.period;
+                    if ((int32_t)(to - expiry) >= 0)
+                    {
+                        expiry += ((to - expiry) / timer.period + 1) * timer.period;
+                    }
+                    timer.expiry = expiry;
+                }
+            }
+        }
+
+        Fired fired;
+        fired.wheel = &wheel;
+        wheel.advance(to, onExpiry, &fired);
+        now = to;
+
+        std::sort(expected.begin(), expected.end());
+        std::sort(fired.events.begin(), fired.events.end());
+        expiries += fired.events.size();
+        if (fired.events != expected)
+        {
+            fprintf(stderr, "  step %u: %zu expiries where %zu expected, advancing %u ticks\n", (unsigned)step,
+                    fired.events.size(), expected.size(), (unsigned)delta);
+            errors++;
+        }
+
+        bool isModelNext = false;
+        uint32_t modelNext = 0;
+        for (size_t i = 0; i < timers.size(); i++)
+        {
+            if (timers[i].isActive && (!isModelNext || (int32_t)(timers[i].expiry - modelNext) < 0))
+            {
+                modelNext = timers[i].expiry;
+                isModelNext = true;
+            }
+        }
+        uint32_t next = 0;
+        bool isNext = wheel.nextExpiry(&next);
+        if (isNext != isModelNext || (isNext && next != modelNext))
+        {
+            fprintf(stderr, "  step %u: nextExpiry %u where %u expected\n", (unsigned)step, isNext ? (unsigned)(next - now) : 0,
+                    isModelNext ? (unsigned)(modelNext - now) : 0);
+            errors++;
+        }
+    }
+    printf("check: %u steps, %llu expiries, %u errors: %s\n", (unsigned)steps, (unsigned long long)expiries, (unsigned)errors,
+           errors ? "FAILED" : "ok");
+    return !errors;
+}
+
+// the firmware timers over one visit, in ms: (start, stop, period)
+struct Activity
+{
+    uint32_t startMs;
+    uint32_t stopMs;
+    uint32_t periodMs;
+};
+
+static void wakeups(uint32_t visitMs)
+{
+    std::vector<Activity> activities;
+    activities.push_back(Activity{0, visitMs, 1000});   // QueueMain 1Hz
+    activities.push_back(Activity{137, visitMs, 1000}); // ThreadNpu 1Hz
+    uint32_t t = 2000 + 311;                            // PIR: NPU burst, then steps down
+    static const uint32_t npuPeriods[] = {100, 250, 1000, 5000};
+    static const uint32_t npuFrames[] = {4, 4, 2, 12};
+    for (int i = 0; i < 4; i++)
+    {
+        activities.push_back(Activity{t, t + npuPeriods[i] * npuFrames[i], npuPeriods[i]});
+        t += npuPeriods[i] * npuFrames[i];
+    }
+    activities.push_back(Activity{2900 + 53, 2900 + 53 + 6000, 1000}); // ThreadMessaging 1Hz, while sending
+    activities.push_back(Activity{4000 + 7, 4000 + 7 + 600, 5});       // debounce, a button press
+
+    // one FreeRTOS timer each: first expiry one period after its start
+    std::set<uint32_t> separate;
+    uint32_t separateExpiries = 0;
+    // the wheel: expiries aligned on multiples of the period, in ticks
+    std::set<uint32_t> aligned;
+    for (size_t i = 0; i < activities.size(); i++)
+    {
+        const Activity &a = activities[i];
+        for (uint32_t ms = a.startMs + a.periodMs; ms <= a.stopMs; ms += a.periodMs)
+        {
+            separate.insert(ms);
+            separateExpiries++;
+        }
+        uint32_t period = a.periodMs / TICK_MS;
+        for (uint32_t tick = (a.startMs / TICK_MS / period + 1) * period; tick * TICK_MS <= a.stopMs; tick += period)
+        {
+            aligned.insert(tick);
+        }
+    }
+    printf("wakeups: one visit of %u s, %u timer expiries\n", (unsigned)(visitMs / 1000), (unsigned)separateExpiries);
+    printf("  timer per thread: %zu wake-ups of the timer daemon\n", separate.size());
+    printf("  timer wheel     : %zu wake-ups of the timer daemon\n", aligned.size());
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n steps] [-s seed] [-v visit_s]\n", name);
+    fprintf(stderr, "  defaults: -n 200000 -s 1 -v 120\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t steps = 200000;
+    uint32_t seed = 1;
+    uint32_t visitMs = 120000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:v:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            steps = strtoul(optarg, nullptr, 0);
+            break;
+        case 's':
+            seed = strtoul(optarg, nullptr, 0);
+            break;
+        case 'v':
+            visitMs = strtoul(optarg, nullptr, 0) * 1000;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    bool isOk = check(steps, seed);
+    wakeups(visitMs);
+    return isOk ? 0 : 1;
+}
@@ -0,0 +1,530 @@
+/* Copyright 2024 teamprof.net@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "app/AppEvent.h"
+#include "app/util/TraceRecord.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Convert a message trace dump of the doorbell (src/app/util/Trace.h) into the JSON trace
+// format of chrome://tracing and https://ui.perfetto.dev, see README.md
+//   The input is the body of a "trace 3" upload, or a capture of the serial output of
+//   "trace 2", log lines included: the last dump found is used.
+//   Each task is a thread of the trace. Handlers are slices, a post is an arrow from the
+//   poster to the handler of the message, and each queue has a depth counter. A dequeue
+//   is paired with the oldest pending post of the same event and iParam on its queue;
+//   messages posted other than by QueueStats::post() (ISRs, WiFi events) have no post, so
+//   no arrow. A dequeue record carries the messages left in the queue: pending posts in
+//   excess are older than the window, their dequeues are lost, and are dropped.
+//   The rings of busy tasks wrap sooner: unless -a, records older than the oldest record
+//   of a wrapped ring, and those of its time, are dropped, so every task is covered over
+//   the same window.
+////////////////////////////////////////////////////////////////////////////////////////////
+struct Ring
+{
+    std::string name;
+    uint32_t written;
+    std::vector<TraceRecord> records;
+};
+
+struct Item
+{
+    int64_t us;
+    int ring;
+    TraceRecord record;
+    int flow;    // paired post and dequeue share it, 0 = none
+    bool isLost; // a post cancelled by a TracePostFail
+};
+
+static const char *ipcName(int param)
+{
+    switch (param)
+    {
+    case IpcNpuStart:
+        return "IpcNpuStart";
+    case IpcNpuStop:
+        return "IpcNpuStop";
+    case IpcNpuNoObjectDetected:
+        return "IpcNpuNoObjectDetected";
+    case IpcNpuObjectUnclassified:
+        return "IpcNpuObjectUnclassified";
+    case IpcNpuStrangerDetected:
+        return "IpcNpuStrangerDetected";
+    case IpcNpuTenderDetected:
+        return "IpcNpuTenderDetected";
+    case IpcNpuIdle:
+        return "IpcNpuIdle";
+    case IpcNpuSnapshot:
+        return "IpcNpuSnapshot";
+    default:
+        return nullptr;
+    }
+}
+
+static const char *systemName(int source)
+{
+    switch (source)
+    {
+    case SysSoftwareTimer:
+        return "SysSoftwareTimer";
+    case SysConsoleCommand:
+        return "SysConsoleCommand";
+    case SysButtonClick:
+        return "SysButtonClick";
+    case SysButtonDoubleClick:
+        return "SysButtonDoubleClick";
+    case SysButtonLongPress:
+        return "SysButtonLongPress";
+    default:
+        return nullptr;
+    }
+}
+
+static const char *statusName(int status)
+{
+    switch (status)
+    {
+    case Sending:
+        return "Sending";
+    case SentSuccess:
+        return "SentSuccess";
+    case SentFail:
+        return "SentFail";
+    default:
+        return nullptr;
+    }
+}
+
+static std::string eventName(int event, int iParam)
+{
+    const char *name = nullptr;
+    const char *param = nullptr;
+    switch (event)
+    {
+    case EventNull:
+        name = "EventNull";
+        break;
+    case EventGpioISR:
+        name = "EventGpioISR";
+        break;
+    case EventSystem:
+        name = "EventSystem";
+        param = systemName(iParam);
+        break;
+    case EventGpioRing:
+        name = "EventGpioRing";
+        break;
+    case EventIpc:
+        name = "EventIpc";
+        param = ipcName(iParam);
+        break;
+    case EventNpuFrame:
+        name = "EventNpuFrame";
+        param = ipcName(iParam);
+        break;
+    case EventWifiStatus:
+        name = "EventWifiStatus";
+        break;
+    case EventInternetStatus:
+        name = "EventInternetStatus";
+        break;
+    case EventSendMessage:
+        name = "EventSendMessage";
+        param = ipcName(iParam);
+        break;
+    case EventMessageStatus:
+        name = "EventMessageStatus";
+        param = statusName(iParam);
+        break;
+    }
+    char text[64];
+    if (!name)
+    {
+        snprintf(text, sizeof(text), "event %d/%d", event, iParam);
+    }
+    else if (param)
+    {
+        snprintf(text, sizeof(text), "%s/%s", name, param);
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "%s/%d", name, iParam);
+    }
+    return text;
+}
+
+// the bytes of the last dump of a serial capture, empty if there is none or it is corrupt
+static std::vector<uint8_t> fromHex(const std::vector<char> &text)
+{
+    std::vector<uint8_t> bytes;
+    bool isInside = false;
+    bool isCorrupt = false;
+    size_t lineNumber = 0;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t end = pos;
+        while (end < text.size() && text[end] != '\n')
+        {
+            end++;
+        }
+        std::string line(&text[pos], end - pos);
+        pos = end + 1;
+        lineNumber++;
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+        {
+            line.pop_back();
+        }
+
+        if (line == TRACE_HEX_BEGIN)
+        {
+            isInside = true;
+            isCorrupt = false;
+            bytes.clear();
+        }
+        else if (line == TRACE_HEX_END)
+        {
+            isInside = false;
+        }
+        else if (isInside && !line.empty() && line[0] == TRACE_HEX_PREFIX)
+        {
+            // a log line of another task may cut into a hex line
+            if (line.size() % 2 != 1 || line.size() > 1 + TRACE_HEX_BYTES * 2 ||
+                line.find_first_not_of("0123456789abcdef", 1) != std::string::npos)
+            {
+                fprintf(stderr, "line %zu: corrupt hex line\n", lineNumber);
+                isCorrupt = true;
+                continue;
+            }
+            for (size_t i = 1; i < line.size(); i += 2)
+            {
+                bytes.push_back((uint8_t)strtoul(line.substr(i, 2).c_str(), nullptr, 16));
+            }
+        }
+    }
+    if (isCorrupt || isInside)
+    {
+        fprintf(stderr, isCorrupt ? "the last dump is corrupt, dump again\n" : "the last dump has no end\n");
+        bytes.clear();
+    }
+    return bytes;
+}
+
+static bool take(const std::vector<uint8_t> &bytes, size_t *offset, void *dest, size_t length)
+{
+    if (*offset + length > bytes.size())
+    {
+        return false;
+    }
+    memcpy(dest, &bytes[*offset], length);
+    *offset += length;
+    return true;
+}
+
+static std::string nameOf(const char *name)
+{
+    return std::string(name, strnlen(name, TRACE_NAME_SIZE));
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-a] dump > trace.json\n", name);
+    fprintf(stderr, "  dump  body of a \"trace 3\" upload, or serial capture of \"trace 2\"\n");
+    fprintf(stderr, "  -a    keep every record, also where only some of the rings cover the time\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bool isAll = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "a")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+            isAll = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(argv[optind], std::ios::binary);
+    if (!file)
+    {
+        fprintf(stderr, "cannot open %s\n", argv[optind]);
+        return 1;
+    }
+    std::vector<char> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    uint32_t magic = 0;
+    if (input.size() >= sizeof(magic))
+    {
+        memcpy(&magic, &input[0], sizeof(magic));
+    }
+    std::vector<uint8_t> bytes = magic == TRACE_MAGIC ? std::vector<uint8_t>(input.begin(), input.end()) : fromHex(input);
+
+    size_t offset = 0;
+    TraceHeader header;
+    if (!take(bytes, &offset, &header, sizeof(header)) || header.magic != TRACE_MAGIC)
+    {
+        fprintf(stderr, "%s: no trace dump\n", argv[optind]);
+        return 1;
+    }
+    if (header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord))
+    {
+        fprintf(stderr, "%s: dump version %u, record size %u, expect %u and %zu\n", argv[optind], header.version,
+                header.recordSize, TRACE_VERSION, sizeof(TraceRecord));
+        return 1;
+    }
+
+    std::vector<std::string> queues;
+    for (int i = 0; i < header.queueCount; i++)
+    {
+        TraceName name;
+        if (!take(bytes, &offset, &name, sizeof(name)))
+        {
+            fprintf(stderr, "%s: truncated\n", argv[optind]);
+            return 1;
+        }
+        queues.push_back(nameOf(name.name));
+    }
+    std::vector<Ring> rings;
+    for (int i = 0; i < header.ringCount; i++)
+    {
+        TraceRingHeader ringHeader;
+        Ring ring;
+        if (!take(bytes, &offset, &ringHeader, sizeof(ringHeader)))
+        {
+            fprintf(stderr, "%s: truncated\n", argv[optind]);
+            return 1;
+        }
+        ring.name = nameOf(ringHeader.name);
+        ring.written = ringHeader.written;
+        ring.records.resize(ringHeader.count);
+        if (!take(bytes, &offset, ring.records.data(), ringHeader.count * sizeof(TraceRecord)))
+        {
+            fprintf(stderr, "%s: truncated\n", argv[optind]);
+            return 1;
+        }
+        rings.push_back(ring);
+    }
+
+    // the records hold the low 32 bits of the time, at most 2^32 us before the dump
+    int64_t now = ((int64_t)header.nowHigh << 32) | header.nowLow;
+    int64_t windowUs = INT64_MIN;
+    std::vector<Item> items;
+    size_t tornCount = 0;
+    for (int i = 0; i < (int)rings.size(); i++)
+    {
+        for (const TraceRecord &record : rings[i].records)
+        {
+            if (record.kind == TraceNull || record.kind >= TraceKindCount)
+            {
+                tornCount++;
+                continue;
+            }
+            Item item = {now - (int64_t)(uint32_t)(header.nowLow - record.us), i, record, 0, false};
+            items.push_back(item);
+        }
+        if (rings[i].written > rings[i].records.size() && !rings[i].records.empty())
+        {
+            windowUs = std::max(windowUs, now - (int64_t)(uint32_t)(header.nowLow - rings[i].records[0].us));
+        }
+    }
+    if (!isAll)
+    {
+        // a wrapped ring may have lost records of the same time as its oldest: not that one
+        items.erase(std::remove_if(items.begin(), items.end(), [windowUs](const Item &item)
+                                   { return item.us <= windowUs; }),
+                    items.end());
+    }
+    // in time order; each ring is in time order already and keeps its own order on a tie
+    std::stable_sort(items.begin(), items.end(), [](const Item &a, const Item &b)
+                     { return a.us < b.us; });
+
+    // pair the dequeues with the posts; on a tie in time a post goes first
+    std::vector<std::deque<size_t>> pending(queues.size());
+    std::vector<uint32_t> paired(queues.size()), unpaired(queues.size()), stale(queues.size());
+    std::vector<int64_t> waitSum(queues.size()), waitMax(queues.size());
+    std::vector<size_t> order(items.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&items](size_t a, size_t b)
+                     { return items[a].us < items[b].us ||
+                              (items[a].us == items[b].us && items[a].record.kind != TraceDequeue && items[b].record.kind == TraceDequeue); });
+    int flowCount = 0;
+    for (size_t index : order)
+    {
+        Item &item = items[index];
+        uint8_t queue = item.record.queue;
+        if (queue >= queues.size())
+        {
+            continue;
+        }
+        std::deque<size_t> &posts = pending[queue];
+        if (item.record.kind == TracePost)
+        {
+            posts.push_back(index);
+        }
+        else if (item.record.kind == TracePostFail)
+        {
+            for (auto it = posts.rbegin(); it != posts.rend(); ++it)
+            {
+                const Item &post = items[*it];
+                if (post.ring == item.ring && post.record.event == item.record.event && post.record.iParam == item.record.iParam)
+                {
+                    items[*it].isLost = true;
+                    posts.erase(std::next(it).base());
+                    break;
+                }
+            }
+        }
+        else if (item.record.kind == TraceDequeue)
+        {
+            // more posts pending than messages were in the queue: the dequeues of the oldest
+            // went before the window or were overwritten. Posts of the same time are not
+            // counted, they may come after the dequeue (the order of a tie is unknown).
+            size_t older = 0;
+            while (older < posts.size() && items[posts[older]].us < item.us)
+            {
+                older++;
+            }
+            for (; older > item.record.left + 1u; older--)
+            {
+                posts.pop_front();
+                stale[queue]++;
+            }
+            auto it = std::find_if(posts.begin(), posts.end(), [&](size_t post)
+                                   { return items[post].record.event == item.record.event && items[post].record.iParam == item.record.iParam; });
+            if (it == posts.end())
+            {
+                unpaired[queue]++;
+                continue;
+            }
+            int64_t wait = item.us - items[*it].us;
+            item.flow = items[*it].flow = ++flowCount;
+            waitSum[queue] += wait;
+            waitMax[queue] = std::max(waitMax[queue], wait);
+            paired[queue]++;
+            posts.erase(it);
+        }
+    }
+
+    int64_t origin = items.empty() ? now : items[0].us;
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"doorbell\"}}");
+    for (int i = 0; i < (int)rings.size(); i++)
+    {
+        printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", i + 1, rings[i].name.c_str());
+    }
+
+    // the depth counters follow the pairing order, the slices the order of each ring
+    std::vector<int> depth(queues.size());
+    for (size_t index : order)
+    {
+        const Item &item = items[index];
+        uint8_t queue = item.record.queue;
+        if (queue >= queues.size() || !item.flow)
+        {
+            continue;
+        }
+        depth[queue] += item.record.kind == TracePost ? 1 : -1;
+        printf(",\n{\"name\":\"queue %s\",\"ph\":\"C\",\"ts\":%lld,\"pid\":1,\"args\":{\"depth\":%d}}", queues[queue].c_str(),
+               (long long)(item.us - origin), depth[queue]);
+    }
+    std::vector<int> nesting(rings.size());
+    for (const Item &item : items)
+    {
+        int tid = item.ring + 1;
+        long long ts = item.us - origin;
+        std::string name = eventName(item.record.event, item.record.iParam);
+        const char *queue = item.record.queue < queues.size() ? queues[item.record.queue].c_str() : "?";
+        switch (item.record.kind)
+        {
+        case TraceStart:
+            nesting[item.ring]++;
+            printf(",\n{\"name\":\"%s\",\"cat\":\"handler\",\"ph\":\"B\",\"ts\":%lld,\"pid\":1,\"tid\":%d}", name.c_str(), ts, tid);
+            break;
+        case TraceEnd:
+            // the start may be older than the window
+            if (nesting[item.ring] > 0)
+            {
+                nesting[item.ring]--;
+                printf(",\n{\"ph\":\"E\",\"ts\":%lld,\"pid\":1,\"tid\":%d}", ts, tid);
+            }
+            break;
+        case TracePost:
+        case TracePostFail:
+        case TraceCoalesce:
+        {
+            if (item.record.kind == TracePost && item.isLost)
+            {
+                break;
+            }
+            const char *verb = item.record.kind == TracePost ? "post" : item.record.kind == TracePostFail ? "post failed" : "coalesced";
+            // an arrow starts from a slice: a post outside a handler (a timer expiry) gets one of 1 us
+            bool isOutside = item.flow && nesting[item.ring] == 0;
+            printf(",\n{\"name\":\"%s %s\",\"cat\":\"queue\",\"ph\":\"%s\",%s\"ts\":%lld,\"pid\":1,\"tid\":%d,\"args\":{\"queue\":\"%s\"}}",
+                   verb, name.c_str(), isOutside ? "X" : "i", isOutside ? "\"dur\":1," : "\"s\":\"t\",", ts, tid, queue);
+            if (item.flow)
+            {
+                printf(",\n{\"name\":\"message\",\"cat\":\"queue\",\"ph\":\"s\",\"id\":%d,\"ts\":%lld,\"pid\":1,\"tid\":%d}", item.flow, ts, tid);
+            }
+            break;
+        }
+        case TraceDequeue:
+            printf(",\n{\"name\":\"dequeue %s\",\"cat\":\"queue\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld,\"pid\":1,\"tid\":%d,\"args\":{\"queue\":\"%s\"}}",
+                   name.c_str(), ts, tid, queue);
+            if (item.flow)
+            {
+                // no binding point: the arrow ends on the next slice, the handler
+                printf(",\n{\"name\":\"message\",\"cat\":\"queue\",\"ph\":\"f\",\"id\":%d,\"ts\":%lld,\"pid\":1,\"tid\":%d}", item.flow, ts, tid);
+            }
+            break;
+        }
+    }
+    printf("\n]}\n");
+
+    fprintf(stderr, "%zu records of %zu rings over %.3f s, %zu torn, %u untracked\n", items.size(), rings.size(),
+            items.empty() ? 0.0 : (items.back().us - items.front().us) / 1e6, tornCount, (unsigned)header.untracked);
+    for (size_t i = 0; i < queues.size(); i++)
+    {
+        fprintf(stderr, "queue %s: %u paired, wait avg=%lld us, max=%lld us, %u dequeued with no post (ISR, WiFi event), %u posts with no dequeue\n",
+                queues[i].c_str(), paired[i], paired[i] ? (long long)(waitSum[i] / paired[i]) : 0LL, (long long)waitMax[i], unpaired[i], stale[i]);
+    }
+    return 0;
+}